@@ -1,4 +1,5 @@
 #include "hlt/mybot_internal.hpp"
+#include "hlt/benchmark.hpp"
 
 #include <random>
 #include <unordered_map>
@@ -8,13 +9,6 @@ using namespace std;
 
 int main(int argc, char* argv[])
 {
-	unsigned int rng_seed;
-	if (argc > 1)
-		rng_seed = static_cast<unsigned int>(stoul(argv[1]));
-	else
-		rng_seed = static_cast<unsigned int>(time(nullptr));
-	mt19937 rng(rng_seed);
-
 	/* Constants */
 	unordered_map<string, int> constants;
 	constants["A* Heuristic"] = 20;
@@ -22,7 +16,27 @@ int main(int argc, char* argv[])
 
 	constants["Score: Smoothing radius"] = 3;
 
+	constants["Worker Threads"] = 2; // 0 runs the turn tasks serially
+
 	constants["Test"] = 1;
 
-	return mybot_internal("GSBot2", constants, rng_seed);
+	if ((argc > 1) && (string(argv[1]) == "--benchmark"))
+		return benchmark::run(constants);
+
+	// MyBot [seed] [--capture file] [--replay file]
+	unsigned int rng_seed = static_cast<unsigned int>(time(nullptr));
+	string capture_path, replay_path;
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if ((arg == "--capture") && (i + 1 < argc))
+			capture_path = argv[++i];
+		else if ((arg == "--replay") && (i + 1 < argc))
+			replay_path = argv[++i];
+		else
+			rng_seed = static_cast<unsigned int>(stoul(arg));
+	}
+	mt19937 rng(rng_seed);
+
+	return mybot_internal("GSBot2", constants, rng_seed, capture_path, replay_path);
 }
@@ -0,0 +1,129 @@
+#include "arena.hpp"
+#include "defines.hpp"
+
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+using namespace std;
+
+#if HALITE_DEBUG
+static atomic<size_t> heap_allocations(0);
+
+/*
+Every heap allocation of the debug bot goes through these, so that the per turn allocation
+count can be logged. They only add a counter to the default malloc / free behavior.
+*/
+void* operator new(size_t bytes)
+{
+	heap_allocations.fetch_add(1, memory_order_relaxed);
+	if (void* memory = malloc(bytes ? bytes : 1))
+		return memory;
+	throw bad_alloc();
+}
+
+void* operator new[](size_t bytes)
+{
+	return operator new(bytes);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+bool hlt::allocation_counter::enabled()
+{
+	return true;
+}
+
+size_t hlt::allocation_counter::count()
+{
+	return heap_allocations.load(memory_order_relaxed);
+}
+#else
+bool hlt::allocation_counter::enabled()
+{
+	return false;
+}
+
+size_t hlt::allocation_counter::count()
+{
+	return 0;
+}
+#endif
+
+hlt::Arena& hlt::Arena::turn()
+{
+	thread_local Arena arena;
+	return arena;
+}
+
+void hlt::Arena::reset()
+{
+	// Several blocks were needed: keep a single one that holds the most the turn held at once
+	if (overflowed)
+	{
+		size_t needed = peak_bytes_used();
+		while (block_size < needed)
+			block_size *= 2;
+
+		blocks.clear();
+		block_sizes.clear();
+	}
+
+	cursor = 0;
+	used_in_previous_blocks = 0;
+	peak_used = 0;
+	allocations = 0;
+	overflowed = false;
+}
+
+void hlt::Arena::rewind(const Mark& mark)
+{
+	peak_used = peak_bytes_used();
+
+	// The first block is kept even when the mark is before it, a scope opened on an empty arena would free it on every call
+	size_t kept = max(mark.blocks, min(blocks.size(), (size_t)1));
+	blocks.resize(kept);
+	block_sizes.resize(kept);
+	cursor = mark.cursor;
+	used_in_previous_blocks = mark.used_in_previous_blocks;
+}
+
+void* hlt::Arena::allocate_in_new_block(size_t bytes, size_t alignment)
+{
+	if (!blocks.empty())
+	{
+		used_in_previous_blocks += cursor;
+		overflowed = true;
+	}
+
+	size_t size = block_size;
+	while (size < bytes + alignment)
+		size *= 2;
+
+	blocks.push_back(unique_ptr<char[]>(new char[size]));
+	block_sizes.push_back(size);
+
+	// new[] is aligned for any fundamental type, larger alignments are padded
+	uintptr_t address = reinterpret_cast<uintptr_t>(blocks.back().get());
+	size_t start = ((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address;
+	cursor = start + bytes;
+	return blocks.back().get() + start;
+}
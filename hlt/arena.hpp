@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Monotonic arena for per turn scratch memory. Allocation bumps a pointer inside the current
+	block and deallocation does nothing; everything is released at once by reset(), called at
+	the top of Game::update_frame. After a turn that needed several blocks, reset() replaces
+	them with a single block big enough for that turn, so a steady game allocates nothing.
+	Per call scratch is released earlier by an ArenaScope, which rewinds the arena to a mark.
+
+	Anything allocated in the turn arena is invalid after the next update_frame: arena
+	containers are for temporaries only, never for state kept across turns. Each thread has
+	its own turn arena; ThreadPool workers reset theirs once their tasks are done, so a task
+	must not hand arena memory to another task.
+	*/
+	class Arena
+	{
+	public:
+		static const size_t DEFAULT_BLOCK_SIZE = 1 << 18;
+
+		// Position of the arena, to rewind to
+		struct Mark
+		{
+			size_t blocks;
+			size_t cursor;
+			size_t used_in_previous_blocks;
+		};
+
+		Arena(size_t block_size = DEFAULT_BLOCK_SIZE) : block_size(block_size), cursor(0), used_in_previous_blocks(0), peak_used(0), allocations(0), overflowed(false) {}
+
+		// Scratch arena of the current turn, one per thread
+		static Arena& turn();
+
+		inline void* allocate(size_t bytes, size_t alignment)
+		{
+			allocations++;
+			if (!blocks.empty())
+			{
+				size_t start = (cursor + alignment - 1) & ~(alignment - 1);
+				if (start + bytes <= block_sizes.back())
+				{
+					cursor = start + bytes;
+					return blocks.back().get() + start;
+				}
+			}
+
+			return allocate_in_new_block(bytes, alignment);
+		}
+
+		void reset();
+
+		inline Mark mark() const { return Mark{ blocks.size(), cursor, used_in_previous_blocks }; }
+		// Releases everything allocated since the mark, blocks opened since then included
+		void rewind(const Mark& mark);
+
+		// Bytes handed out since the last reset, alignment padding included, and the most held at once
+		inline size_t bytes_used() const { return used_in_previous_blocks + cursor; }
+		inline size_t peak_bytes_used() const { return max(peak_used, bytes_used()); }
+		inline size_t allocation_count() const { return allocations; }
+		inline size_t block_count() const { return blocks.size(); }
+
+	private:
+		size_t block_size;
+		vector<unique_ptr<char[]>> blocks;
+		vector<size_t> block_sizes;
+		size_t cursor;
+		size_t used_in_previous_blocks;
+		size_t peak_used;
+		size_t allocations;
+		bool overflowed; // a block was opened after the first one since the last reset
+
+		void* allocate_in_new_block(size_t bytes, size_t alignment);
+	};
+
+	// Standard allocator on an arena, the turn arena by default
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		ArenaAllocator() : arena(&Arena::turn()) {}
+		ArenaAllocator(Arena& arena) : arena(&arena) {}
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+		inline T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+		inline void deallocate(T*, size_t) {}
+
+		template <typename U>
+		inline bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+		template <typename U>
+		inline bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+		Arena* arena;
+	};
+
+	/*
+	Rewinds an arena, the turn arena by default, to where it was at construction when it goes
+	out of scope. Declared first in a function, it releases the scratch of each call instead of
+	keeping it until the end of the turn; nothing allocated in the scope may outlive it.
+	*/
+	class ArenaScope
+	{
+	public:
+		ArenaScope(Arena& arena = Arena::turn()) : arena(arena), mark(arena.mark()) {}
+		~ArenaScope() { arena.rewind(mark); }
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+	private:
+		Arena& arena;
+		Arena::Mark mark;
+	};
+
+	template <typename T>
+	using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+	template <typename Key, typename Value, typename Hash = hash<Key>>
+	using ArenaUnorderedMap = unordered_map<Key, Value, Hash, equal_to<Key>, ArenaAllocator<pair<const Key, Value>>>;
+
+	// Heap allocations (operator new) since the start of the process. Only HALITE_DEBUG builds
+	// replace operator new to count them, count() stays 0 otherwise.
+	namespace allocation_counter
+	{
+		bool enabled();
+		size_t count();
+	}
+}
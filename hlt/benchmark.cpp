@@ -0,0 +1,1472 @@
+#include "benchmark.hpp"
+#include "input.hpp"
+#include "game.hpp"
+#include "wrap_table.hpp"
+#include "arena.hpp"
+#include "diamond_convolution.hpp"
+#include "grid_kernels.hpp"
+#include "lazy_greedy.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+
+using namespace hlt;
+using namespace std;
+
+static const int BENCH_WIDTH = 64;
+static const int BENCH_PLAYERS = 4;
+static const int BENCH_SHIPS_PER_PLAYER = 150;
+static const int BENCH_DROPOFFS_PER_PLAYER = 4;
+static const int BENCH_CELL_UPDATES = 400;
+
+static void report(const string& name, chrono::duration<double> elapsed, int iterations, long long checksum)
+{
+	double us = 1e6 * elapsed.count() / (double)iterations;
+	cout << name << ": " << us << "us per iteration (" << iterations << " iterations, checksum " << checksum << ")" << endl;
+}
+
+// Heap allocations per unit since a count, only counted by HALITE_DEBUG builds
+static string heap_allocations_per(size_t since, double units)
+{
+	if (!allocation_counter::enabled())
+		return "uncounted";
+
+	ostringstream out;
+	out << (double)(allocation_counter::count() - since) / units;
+	return out.str();
+}
+
+// Sum of a grid weighted by cell index, so that a value moved to another cell changes it
+template<typename G> static long long grid_checksum(const G& grid, int width, int height)
+{
+	long long checksum = 0;
+	for (int i = 0; i < height; ++i)
+		for (int j = 0; j < width; ++j)
+			checksum += (long long)grid[i][j] * (i * width + j + 1);
+	return checksum;
+}
+
+// Init block of a 64x64 4 players game, player 0 is us
+static string synthetic_init(mt19937& rng)
+{
+	string init = "{\"NEW_ENTITY_ENERGY_COST\":1000,\"DROPOFF_COST\":4000,\"MAX_ENERGY\":1000,\"MAX_TURNS\":500,"
+		"\"EXTRACT_RATIO\":4,\"MOVE_COST_RATIO\":10,\"INSPIRATION_ENABLED\":true,\"INSPIRATION_RADIUS\":4,"
+		"\"INSPIRATION_SHIP_COUNT\":2,\"INSPIRED_EXTRACT_RATIO\":4,\"INSPIRED_BONUS_MULTIPLIER\":2.0,\"INSPIRED_MOVE_COST_RATIO\":10}\n";
+
+	init += to_string(BENCH_PLAYERS) + " 0\n";
+	for (int player = 0; player < BENCH_PLAYERS; ++player)
+		init += to_string(player) + " " + to_string((player % 2) ? 3 * BENCH_WIDTH / 4 : BENCH_WIDTH / 4) + " " + to_string((player / 2) ? 3 * BENCH_WIDTH / 4 : BENCH_WIDTH / 4) + "\n";
+
+	init += to_string(BENCH_WIDTH) + " " + to_string(BENCH_WIDTH) + "\n";
+	for (int y = 0; y < BENCH_WIDTH; ++y)
+	{
+		for (int x = 0; x < BENCH_WIDTH; ++x)
+			init += to_string(rng() % 1000) + " ";
+		init += "\n";
+	}
+
+	return init;
+}
+
+// Frame as sent by the engine on a crowded 64x64 4 players game, ships are on distinct cells
+static string synthetic_frame(int turn, mt19937& rng)
+{
+	vector<int> cells(BENCH_WIDTH * BENCH_WIDTH);
+	for (size_t i = 0; i < cells.size(); ++i)
+		cells[i] = (int)i;
+	shuffle(cells.begin(), cells.end(), rng);
+
+	string frame = to_string(turn) + "\n";
+	int ship_id = 0;
+	int cell = 0;
+
+	for (int player = 0; player < BENCH_PLAYERS; ++player)
+	{
+		frame += to_string(player) + " " + to_string(BENCH_SHIPS_PER_PLAYER) + " " + to_string(BENCH_DROPOFFS_PER_PLAYER) + " " + to_string(rng() % 50000) + "\n";
+
+		for (int i = 0; i < BENCH_SHIPS_PER_PLAYER; ++i, ++cell)
+			frame += to_string(ship_id++) + " " + to_string(cells[cell] % BENCH_WIDTH) + " " + to_string(cells[cell] / BENCH_WIDTH) + " " + to_string(rng() % 1000) + "\n";
+
+		for (int i = 0; i < BENCH_DROPOFFS_PER_PLAYER; ++i, ++cell)
+			frame += to_string(10000 + ship_id++) + " " + to_string(cells[cell] % BENCH_WIDTH) + " " + to_string(cells[cell] / BENCH_WIDTH) + "\n";
+	}
+
+	frame += to_string(BENCH_CELL_UPDATES) + "\n";
+	for (int i = 0; i < BENCH_CELL_UPDATES; ++i)
+		frame += to_string(rng() % BENCH_WIDTH) + " " + to_string(rng() % BENCH_WIDTH) + " " + to_string(rng() % 1000) + "\n";
+
+	return frame;
+}
+
+// Consecutive frames where ships of every player wander one cell per turn, a few die and spawn,
+// and cell_updates random cells get a new halite value
+static vector<string> synthetic_turns(int turns, mt19937& rng, int first_turn = 1, int cell_updates = 0)
+{
+	struct BenchShip { int id; int x; int y; };
+	vector<vector<BenchShip>> fleets(BENCH_PLAYERS);
+	int next_id = 0;
+
+	for (auto& fleet : fleets)
+		for (int i = 0; i < BENCH_SHIPS_PER_PLAYER; ++i)
+			fleet.push_back({ next_id++, (int)(rng() % BENCH_WIDTH), (int)(rng() % BENCH_WIDTH) });
+
+	vector<string> frames;
+	for (int turn = first_turn; turn < first_turn + turns; ++turn)
+	{
+		string frame = to_string(turn) + "\n";
+
+		for (int player = 0; player < BENCH_PLAYERS; ++player)
+		{
+			vector<BenchShip>& fleet = fleets[player];
+
+			// 2 ships die, 2 are spawned
+			for (int i = 0; i < 2; ++i)
+			{
+				fleet.erase(fleet.begin() + rng() % fleet.size());
+				fleet.push_back({ next_id++, (int)(rng() % BENCH_WIDTH), (int)(rng() % BENCH_WIDTH) });
+			}
+
+			frame += to_string(player) + " " + to_string(fleet.size()) + " " + to_string(BENCH_DROPOFFS_PER_PLAYER) + " 5000\n";
+			for (BenchShip& ship : fleet)
+			{
+				switch (rng() % 5)
+				{
+				case 0: ship.y = (ship.y + BENCH_WIDTH - 1) % BENCH_WIDTH; break;
+				case 1: ship.y = (ship.y + 1) % BENCH_WIDTH; break;
+				case 2: ship.x = (ship.x + 1) % BENCH_WIDTH; break;
+				case 3: ship.x = (ship.x + BENCH_WIDTH - 1) % BENCH_WIDTH; break;
+				default: break;
+				}
+				frame += to_string(ship.id) + " " + to_string(ship.x) + " " + to_string(ship.y) + " " + to_string(rng() % 1000) + "\n";
+			}
+
+			for (int i = 0; i < BENCH_DROPOFFS_PER_PLAYER; ++i)
+				frame += to_string(100000 + player * BENCH_DROPOFFS_PER_PLAYER + i) + " " + to_string(4 * i) + " " + to_string(8 * player) + "\n";
+		}
+
+		frame += to_string(cell_updates) + "\n";
+		for (int i = 0; i < cell_updates; ++i)
+			frame += to_string(rng() % BENCH_WIDTH) + " " + to_string(rng() % BENCH_WIDTH) + " " + to_string(rng() % 1000) + "\n";
+		frames.push_back(frame);
+	}
+
+	return frames;
+}
+
+// Game built from the synthetic init block and one crowded frame, shared by all game benchmarks
+static Game& synthetic_game(unordered_map<string, int> constants)
+{
+	static unique_ptr<Game> game;
+	static stringstream source;
+
+	if (!game)
+	{
+		mt19937 rng(7);
+		source.str(synthetic_init(rng) + synthetic_frame(200, rng));
+		input::set_source(source);
+
+		game = make_unique<Game>(constants);
+		game->update_frame();
+	}
+
+	return *game;
+}
+
+void hlt::benchmark::parse_frame()
+{
+	mt19937 rng(42);
+	string frame = synthetic_frame(100, rng);
+	const int iterations = 2000;
+
+	// Previous protocol reader: one getline and one stringstream per line
+	{
+		long long checksum = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			stringstream source(frame);
+			string line;
+			int a, b, c, d;
+
+			getline(source, line);
+			stringstream(line) >> a;
+			checksum += a;
+
+			for (int player = 0; player < BENCH_PLAYERS; ++player)
+			{
+				int num_ships, num_dropoffs;
+				getline(source, line);
+				stringstream(line) >> a >> num_ships >> num_dropoffs >> d;
+
+				for (int i = 0; i < num_ships; ++i)
+				{
+					getline(source, line);
+					stringstream(line) >> a >> b >> c >> d;
+					checksum += a + b + c + d;
+				}
+
+				for (int i = 0; i < num_dropoffs; ++i)
+				{
+					getline(source, line);
+					stringstream(line) >> a >> b >> c;
+					checksum += a + b + c;
+				}
+			}
+
+			int update_count;
+			getline(source, line);
+			stringstream(line) >> update_count;
+			for (int i = 0; i < update_count; ++i)
+			{
+				getline(source, line);
+				stringstream(line) >> a >> b >> c;
+				checksum += a + b + c;
+			}
+		}
+
+		report("Parse frame (stringstream per line)", chrono::high_resolution_clock::now() - start, iterations, checksum);
+	}
+
+	// Buffered reader
+	{
+		long long checksum = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			stringstream source(frame);
+			input::set_source(source);
+			input::begin_frame();
+
+			checksum += input::read_int();
+
+			for (int player = 0; player < BENCH_PLAYERS; ++player)
+			{
+				input::read_int();
+				int num_ships = input::read_int();
+				int num_dropoffs = input::read_int();
+				input::read_int();
+
+				for (int i = 0; i < num_ships; ++i)
+					checksum += input::read_int() + input::read_int() + input::read_int() + input::read_int();
+
+				for (int i = 0; i < num_dropoffs; ++i)
+					checksum += input::read_int() + input::read_int() + input::read_int();
+			}
+
+			int update_count = input::read_int();
+			for (int i = 0; i < update_count; ++i)
+				checksum += input::read_int() + input::read_int() + input::read_int();
+		}
+
+		report("Parse frame (buffered reader)", chrono::high_resolution_clock::now() - start, iterations, checksum);
+		input::set_source(cin);
+	}
+}
+
+void hlt::benchmark::player_update()
+{
+	mt19937 rng(11);
+	const int turns = 200;
+	vector<string> frames = synthetic_turns(turns, rng);
+
+	// Previous update: copy the ships map, rebuild every ship with make_shared, rebuild my_ships and dropoffs
+	{
+		vector<shared_ptr<Player>> players;
+		for (int player = 0; player < BENCH_PLAYERS; ++player)
+			players.push_back(make_shared<Player>(player, 0, 0));
+
+		long long checksum = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (const string& frame : frames)
+		{
+			stringstream source(frame);
+			input::set_source(source);
+			input::begin_frame();
+			input::read_int();
+
+			for (int p = 0; p < BENCH_PLAYERS; ++p)
+			{
+				Player& player = *players[input::read_int()];
+				int num_ships = input::read_int();
+				int num_dropoffs = input::read_int();
+				player.halite = input::read_int();
+
+				unordered_map<EntityId, shared_ptr<Ship>> old_ships = player.ships;
+				player.ships.clear();
+				for (int i = 0; i < num_ships; ++i)
+				{
+					EntityId ship_id = input::read_int();
+					int x = input::read_int();
+					int y = input::read_int();
+					shared_ptr<Ship> new_ship = make_shared<Ship>(player.id, ship_id, x, y, input::read_int());
+
+					if (old_ships.find(new_ship->id) != old_ships.end())
+						new_ship->assign_objective(old_ships[new_ship->id]);
+
+					player.ships[new_ship->id] = new_ship;
+				}
+				old_ships.clear();
+
+				player.dropoffs.clear();
+				for (int i = 0; i < num_dropoffs; ++i)
+				{
+					EntityId dropoff_id = input::read_int();
+					int x = input::read_int();
+					int y = input::read_int();
+					player.dropoffs[dropoff_id] = make_shared<Dropoff>(player.id, dropoff_id, x, y);
+				}
+
+				player.my_ships.clear();
+				for (const auto& ship : player.ships)
+					player.my_ships.push_back(ship.second);
+
+				checksum += player.my_ships.size();
+			}
+		}
+
+		report("Player::_update 150 ships/player (rebuild)", chrono::high_resolution_clock::now() - start, turns, checksum);
+	}
+
+	// Reconcile with the ship pool
+	{
+		vector<shared_ptr<Player>> players;
+		for (int player = 0; player < BENCH_PLAYERS; ++player)
+			players.push_back(make_shared<Player>(player, 0, 0));
+
+		ShipPool ship_pool;
+		long long checksum = 0;
+		long long events = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (const string& frame : frames)
+		{
+			stringstream source(frame);
+			input::set_source(source);
+			input::begin_frame();
+			int turn_number = input::read_int();
+			ship_pool.begin_turn();
+
+			for (int p = 0; p < BENCH_PLAYERS; ++p)
+			{
+				Player& player = *players[input::read_int()];
+				int num_ships = input::read_int();
+				int num_dropoffs = input::read_int();
+				Halite halite = input::read_int();
+
+				player._update(num_ships, num_dropoffs, halite, turn_number, ship_pool);
+				checksum += player.my_ships.size();
+			}
+
+			events += ship_pool.events.spawned.size() + ship_pool.events.destroyed.size() + ship_pool.events.moved.size();
+		}
+
+		report("Player::_update 150 ships/player (reconcile)", chrono::high_resolution_clock::now() - start, turns, checksum);
+		cout << "  " << (double)events / (double)turns << " spawned/destroyed/moved events per turn" << endl;
+	}
+
+	input::set_source(cin);
+}
+
+void hlt::benchmark::wrap_tables()
+{
+	for (int width : { 32, 64 })
+	{
+		mt19937 rng(width);
+		vector<int> halite(width * width);
+		for (int& h : halite)
+			h = rng() % 1000;
+
+		const int radius = 3;
+		const int iterations = 200;
+		WrapTable wrap(width, width);
+
+		// Radius 3 diamond sums and 4 neighbors, two modulos per access
+		{
+			long long checksum = 0;
+			auto start = chrono::high_resolution_clock::now();
+
+			for (int it = 0; it < iterations; ++it)
+				for (int i = 0; i < width; ++i)
+					for (int j = 0; j < width; ++j)
+					{
+						for (int k = 0; k <= radius * 2; ++k)
+							for (int l = 0; l <= radius * 2; ++l)
+							{
+								int new_k = (((i - radius + k) % width) + width) % width;
+								int new_l = (((j - radius + l) % width) + width) % width;
+								if (abs(k - radius) + abs(l - radius) <= radius)
+									checksum += halite[new_k * width + new_l];
+							}
+
+						checksum += halite[((((i - 1) % width) + width) % width) * width + j];
+						checksum += halite[((((i + 1) % width) + width) % width) * width + j];
+						checksum += halite[i * width + ((((j + 1) % width) + width) % width)];
+						checksum += halite[i * width + ((((j - 1) % width) + width) % width)];
+					}
+
+			report("Torus walk " + to_string(width) + "x" + to_string(width) + " (modulo)", chrono::high_resolution_clock::now() - start, iterations, checksum);
+		}
+
+		// Same walk through the wrap tables
+		{
+			long long checksum = 0;
+			auto start = chrono::high_resolution_clock::now();
+
+			for (int it = 0; it < iterations; ++it)
+				for (int i = 0; i < width; ++i)
+					for (int j = 0; j < width; ++j)
+					{
+						for (const WrappedCell& cell : wrap.diamond(j, i, radius))
+							checksum += halite[cell.index];
+
+						for (int neighbor : wrap.neighbors_of(i * width + j))
+							checksum += halite[neighbor];
+					}
+
+			report("Torus walk " + to_string(width) + "x" + to_string(width) + " (wrap tables)", chrono::high_resolution_clock::now() - start, iterations, checksum);
+		}
+	}
+}
+
+// Checksum of the main grids, to compare implementations
+static double grids_checksum(const Game& game)
+{
+	double checksum = 0.0;
+	for (int i = 0; i < game.game_map->height; ++i)
+		for (int j = 0; j < game.game_map->width; ++j)
+		{
+			checksum += game.scorer.grid_score_move[i][j] + game.scorer.grid_score_inspiration[i][j] + game.scorer.grid_score_enemies_distance_2[i][j];
+			checksum += game.scorer.grid_score_extract_smooth[i][j] + game.scorer.grid_score_neighbor_cell[i][j] + game.scorer.grid_score_dropoff[i][j];
+			checksum += game.scorer.grid_score_can_stay_still[i][j] * 1e-6;
+			for (auto& player : game.players)
+				checksum += game.scorer.get_grid_score_ships_nearby(player->id, Position(j, i));
+		}
+
+	return checksum;
+}
+
+void hlt::benchmark::scorer_update_grids(Game& game)
+{
+	const int iterations = 20;
+	auto start = chrono::high_resolution_clock::now();
+
+	for (int it = 0; it < iterations; ++it)
+		game.scorer.update_grids(game);
+
+	report("Scorer::update_grids", chrono::high_resolution_clock::now() - start, iterations, (long long)grids_checksum(game));
+}
+
+void hlt::benchmark::frame_tasks(Game& game)
+{
+	// Turn tasks of Game::update_frame, serially then on pools of workers
+	const int iterations = 20;
+	TaskGraph graph;
+	game.scorer.add_grid_tasks(graph, game, true);
+	graph.add("distance_fields", [&game]() { game.distance_fields.update(game); });
+	graph.add("distance_manager", [&game]() { game.distance_manager.fill_closest_shipyard_or_dropoff(game); }, { "grid_score_move", "distance_fields" });
+	graph.add("blocker", [&game]() { game.blocker.fill_positions_to_block_scores(game); });
+
+	auto frame_checksum = [&game]() {
+		double checksum = grids_checksum(game);
+		for (int i = 0; i < game.game_map->height; ++i)
+			for (int j = 0; j < game.game_map->width; ++j)
+				checksum += game.distance_manager.distance_cell_shipyard_or_dropoff[i][j];
+		for (auto& enemy_base_map : game.blocker.positions_to_block_scores)
+			for (auto& position_score : enemy_base_map.second)
+				checksum += position_score.second;
+		return checksum;
+	};
+
+	for (int workers = 0; workers <= 3; ++workers)
+	{
+		unique_ptr<ThreadPool> pool = workers ? make_unique<ThreadPool>(workers) : nullptr;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+			graph.run(pool.get());
+
+		report("Turn tasks on " + to_string(workers + 1) + " threads", chrono::high_resolution_clock::now() - start, iterations, (long long)frame_checksum());
+	}
+
+	string line = " ";
+	for (const char* name : { "grid_score_move", "grid_score_neighbor_cell", "grid_score_extract", "grid_score_dropoff", "grid_score_targets",
+		"grid_score_can_stay_still", "grid_ship_can_move_to_dangerous_cell", "distance_fields", "distance_manager", "blocker" })
+		line += " " + string(name) + " " + to_string(graph.task_ms(name)) + "ms";
+	cout << line << endl;
+}
+
+void hlt::benchmark::grid_kernels(Game& game)
+{
+	const int iterations = 200;
+	const kernels::Isa initial_isa = kernels::isa();
+	const int width = game.game_map->width;
+	const int height = game.game_map->height;
+
+	FloatPlane halite(width, height), shaped(width, height);
+	ShortPlane mask(width, height);
+	for (int index = 0; index < width * height; ++index)
+	{
+		halite[index] = (float)game.game_map->cell(index)->halite;
+		mask[index] = (index % 3 == 0);
+	}
+	PiecewiseLinear shape = PiecewiseLinear::strangle(100.0, 300.0, 600.0, 900.0, 1.0, 1.5, 1.5, 0.9);
+
+	for (kernels::Isa isa : { kernels::Isa::SCALAR, kernels::Isa::AVX2 })
+	{
+		if (!kernels::set_isa(isa))
+		{
+			cout << "Grid kernels: no " << kernels::isa_name(isa) << " on this cpu" << endl;
+			continue;
+		}
+
+		// Kernel chain on one plane
+		double checksum = 0.0;
+		auto start = chrono::high_resolution_clock::now();
+		for (int it = 0; it < iterations; ++it)
+		{
+			kernels::apply(shaped, halite, shape);
+			kernels::multiply(shaped, halite);
+			kernels::masked_scale(shaped, mask, 1.3f);
+			kernels::clamp(shaped, 0.0f, 1e6f);
+		}
+		for (int index = 0; index < width * height; ++index)
+			checksum += shaped[index];
+		report(string("Grid kernels apply + multiply + masked_scale + clamp (") + kernels::isa_name(isa) + ")", chrono::high_resolution_clock::now() - start, iterations, (long long)checksum);
+
+		// Post-processing of the extract and dropoff grids, on every cell
+		checksum = 0.0;
+		start = chrono::high_resolution_clock::now();
+		for (int it = 0; it < iterations / 10; ++it)
+		{
+			game.scorer.update_grid_score_extract(game, true);
+			game.scorer.update_grid_score_dropoff(game, true);
+		}
+		for (int i = 0; i < height; ++i)
+			for (int j = 0; j < width; ++j)
+				checksum += game.scorer.grid_score_extract_smooth[i][j] + game.scorer.grid_score_extract[i][j] + game.scorer.grid_score_dropoff[i][j];
+		report(string("Scorer extract + dropoff grids (") + kernels::isa_name(isa) + ")", chrono::high_resolution_clock::now() - start, iterations / 10, (long long)checksum);
+		cout << "  exact checksum " << std::hexfloat << checksum << std::defaultfloat << endl;
+	}
+
+	kernels::set_isa(initial_isa);
+}
+
+void hlt::benchmark::pathfinder_search(Game& game)
+{
+	// Paths from our ships to targets at most 12 cells away, one arena reset per batch like one per turn
+	mt19937 rng(5);
+	vector<pair<MapCell*, MapCell*>> searches;
+	for (const shared_ptr<Ship>& ship : game.me->my_ships)
+	{
+		int dx = (int)(rng() % 13) - 6;
+		int dy = (int)(rng() % 13) - 6;
+		MapCell* source = game.game_map->at(ship->position);
+		MapCell* target = game.game_map->cell(game.game_map->wrap.index(ship->position.x + dx, ship->position.y + dy));
+		searches.push_back(make_pair(source, target));
+	}
+
+	const int iterations = 20;
+	long long checksum = 0;
+	size_t heap_allocations = allocation_counter::count();
+	auto start = chrono::high_resolution_clock::now();
+
+	for (int it = 0; it < iterations; ++it)
+	{
+		Arena::turn().reset();
+		for (auto& search : searches)
+		{
+			checksum += game.pathfinder.dijkstra_path(search.first, search.second, game).size();
+			checksum += game.pathfinder.dijkstra_rtb(search.first, search.second, game, true).size();
+		}
+	}
+
+	const int total = iterations * (int)searches.size();
+	report("PathFinder dijkstra_path + dijkstra_rtb", chrono::high_resolution_clock::now() - start, total, checksum);
+	cout << "  " << heap_allocations_per(heap_allocations, (double)total) << " heap allocations per search pair, "
+		<< Arena::turn().bytes_used() / searches.size() << " arena bytes per search pair" << endl;
+}
+
+// dijkstra_path loop, with the neighbor list builder as a parameter; returns the number of expanded cells
+template <typename Neighbors>
+static long long astar_search(MapCell* source_cell, MapCell* target_cell, const Game& game, Neighbors neighbors)
+{
+	const string heuristic_constant = "A* Heuristic";
+	const int heuristic_weight = game.get_constant(heuristic_constant);
+	long long expansions = 0;
+
+	CellParents came_from;
+	came_from[source_cell] = source_cell;
+	CellFrontier frontier;
+	frontier.put(source_cell, 0);
+	CellCosts cost_so_far;
+	cost_so_far[source_cell] = 0;
+
+	while (!frontier.empty())
+	{
+		MapCell* current_cell = frontier.get();
+		expansions++;
+
+		if (current_cell == target_cell)
+			break;
+
+		for (MapCell* next_cell : neighbors(source_cell, target_cell, current_cell))
+		{
+			int new_cost = cost_so_far[current_cell] + game.pathfinder.compute_next_step_score(source_cell, current_cell, next_cell, game);
+
+			if ((cost_so_far.find(next_cell) == cost_so_far.end()) || (new_cost < cost_so_far[next_cell]))
+			{
+				cost_so_far[next_cell] = new_cost;
+				came_from[next_cell] = current_cell;
+				int distance = game.game_map->calculate_distance(game.game_map->position(next_cell), game.game_map->position(target_cell));
+				frontier.put(next_cell, new_cost + heuristic_weight * distance);
+			}
+		}
+	}
+
+	return expansions;
+}
+
+void hlt::benchmark::astar_expansions(Game& game)
+{
+	mt19937 rng(9);
+	vector<pair<MapCell*, MapCell*>> searches;
+	for (const shared_ptr<Ship>& ship : game.me->my_ships)
+	{
+		int dx = (int)(rng() % 17) - 8;
+		int dy = (int)(rng() % 17) - 8;
+		MapCell* source = game.game_map->at(ship->position);
+		searches.push_back(make_pair(source, game.game_map->cell(game.game_map->wrap.index(ship->position.x + dx, ship->position.y + dy))));
+	}
+
+	const int iterations = 20;
+
+	// Previous neighbor list: a std::vector allocated for every expanded cell
+	auto vector_neighbors = [&game](MapCell* source_cell, MapCell* target_cell, MapCell* cell)
+	{
+		vector<MapCell*> adjacent_cells;
+		Position source_position = game.game_map->position(source_cell);
+
+		for (int index : game.game_map->wrap.neighbors_of(game.game_map->index(cell)))
+		{
+			MapCell* adjacent_cell = game.game_map->cell(index);
+			Position adjacent_position = game.game_map->position(adjacent_cell);
+			int distance = game.game_map->calculate_distance(source_position, adjacent_position);
+
+			if ((distance > 4) || (game.scorer.get_grid_score_move(adjacent_position) < 9) || (adjacent_cell == target_cell))
+				adjacent_cells.push_back(adjacent_cell);
+		}
+
+		return adjacent_cells;
+	};
+	auto small_vector_neighbors = [&game](MapCell* source_cell, MapCell* target_cell, MapCell* cell)
+	{
+		return PathFinder::adjacent_cells_filtered(source_cell, target_cell, cell, game);
+	};
+
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		long long expansions = 0;
+		size_t heap_allocations = allocation_counter::count();
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			Arena::turn().reset();
+			for (auto& search : searches)
+				expansions += (variant == 0) ? astar_search(search.first, search.second, game, vector_neighbors) : astar_search(search.first, search.second, game, small_vector_neighbors);
+		}
+
+		chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+		report((variant == 0) ? "A* search (vector neighbor lists)" : "A* search (SmallVector neighbor lists)", elapsed, iterations * (int)searches.size(), expansions);
+		cout << "  " << (double)expansions / elapsed.count() / 1e6 << "M expansions/s, "
+			<< heap_allocations_per(heap_allocations, (double)expansions) << " heap allocations per expansion" << endl;
+	}
+}
+
+void hlt::benchmark::combat_cache(Game& game)
+{
+	Scorer& scorer = game.scorer;
+	CombatCache& cache = scorer.combat_cache;
+	const WrapTable& wrap = game.game_map->wrap;
+	const int iterations = 20;
+	const int greedy_rounds = 10; // objective searches of every ship during the greedy allocation
+
+	// Danger windows: every cell within 3 of my ships against every adjacent enemy
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		double checksum = 0.0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			if (variant == 1)
+				cache.begin_turn(scorer, game);
+
+			for (const shared_ptr<Ship>& ship : game.me->my_ships)
+			{
+				if (variant == 1)
+				{
+					cache.fill_window(*ship, scorer, game);
+					for (int cell = 0; cell < CombatCache::WINDOW_CELLS; ++cell)
+						for (int side = 0; side < CombatCache::SIDES; ++side)
+							checksum += min(cache.window_scores(ship->slot, cell)[side], Scorer::NO_DANGER);
+					continue;
+				}
+
+				for (int dy = -CombatCache::WINDOW_RADIUS; dy <= CombatCache::WINDOW_RADIUS; ++dy)
+					for (int dx = -(CombatCache::WINDOW_RADIUS - abs(dy)); dx <= CombatCache::WINDOW_RADIUS - abs(dy); ++dx)
+					{
+						Position position = Position(wrap.wrap_x(ship->position.x + dx), wrap.wrap_y(ship->position.y + dy));
+						SmallVector<shared_ptr<Ship>, 5> enemies = game.enemies_adjacent_to_position(position);
+
+						int side = 0;
+						for (auto& enemy_ship : enemies)
+							checksum += min(scorer.combat_score(ship, enemy_ship, position, game), Scorer::NO_DANGER), side++;
+						checksum += (double)(CombatCache::SIDES - side) * Scorer::NO_DANGER;
+					}
+			}
+		}
+
+		report((variant == 0) ? "Combat scores of the danger windows (combat_score)" : "Combat scores of the danger windows (CombatCache)",
+			chrono::high_resolution_clock::now() - start, iterations, (long long)checksum);
+	}
+
+	// Objective search: my ships against every enemy on its cell, once per greedy round
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		double checksum = 0.0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			cache.begin_turn(scorer, game);
+
+			for (int round = 0; round < greedy_rounds; ++round)
+				for (const shared_ptr<Ship>& ship : game.me->my_ships)
+					for (auto& player : game.players)
+						if (player->id != game.my_id)
+							for (auto& ship_iterator : player->ships)
+							{
+								const shared_ptr<Ship>& enemy_ship = ship_iterator.second;
+								checksum += (variant == 0) ? scorer.combat_score(ship, enemy_ship, enemy_ship->position, game) : cache.enemy_cell_score(*ship, *enemy_ship, scorer, game);
+							}
+		}
+
+		report((variant == 0) ? "Combat scores of the objective search (combat_score)" : "Combat scores of the objective search (CombatCache)",
+			chrono::high_resolution_clock::now() - start, iterations, (long long)checksum);
+	}
+
+	scorer.update_combat_cache(game);
+}
+
+void hlt::benchmark::objective_search(Game& game)
+{
+	// Greedy allocation of ObjectiveManager on the first ships: every round searches the best cell of
+	// each ship left, assigns the best one and decreases the extract score around its cell
+	Scorer& scorer = game.scorer;
+	const int ships = 40;
+	const int iterations = 3;
+	const Grid<double> extract_smooth = scorer.grid_score_extract_smooth;
+
+	// Off the turns of the HALITE_DEBUG checks, which scan every cell of each search
+	const int turn_number = game.turn_number;
+	game.turn_number += (game.turn_number % HalitePyramid::CHECK_PERIOD == 0);
+
+	double checksums[2] = { 0.0, 0.0 };
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		int searches = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			scorer.grid_score_extract_smooth = extract_smooth;
+			scorer.halite_pyramid.build(scorer.grid_score_extract_smooth, game.distance_manager.distance_cell_shipyard_or_dropoff);
+
+			vector<shared_ptr<Ship>> left(game.me->my_ships.begin(), game.me->my_ships.begin() + min(ships, (int)game.me->my_ships.size()));
+			while (!left.empty())
+			{
+				int best = 0;
+				Objective best_objective;
+				for (int i = 0; i < (int)left.size(); ++i)
+				{
+					bool can_attack = (left[i]->halite < 500) && (game.halite_on_position(left[i]->position) < 400);
+					Objective objective = (variant == 0) ? scorer.scan_objective_cell(left[i], game, can_attack) : scorer.search_objective_cell(left[i], game, can_attack);
+					searches++;
+					if ((i == 0) || (objective.score > best_objective.score))
+					{
+						best = i;
+						best_objective = objective;
+					}
+				}
+
+				checksums[variant] += best_objective.score + (double)(best_objective.target_position.y * game.game_map->width + best_objective.target_position.x);
+				if (best_objective.type == Objective_Type::EXTRACT_ZONE)
+				{
+					scorer.decreases_score_in_target_cell(left[best], best_objective.target_position, 0.0, game);
+					scorer.decreases_score_in_target_area(left[best], best_objective.target_position, game);
+				}
+				left.erase(left.begin() + best);
+			}
+		}
+
+		report((variant == 0) ? "Objective cell searches of the greedy allocation (scan)" : "Objective cell searches of the greedy allocation (HalitePyramid)",
+			chrono::high_resolution_clock::now() - start, searches, (long long)checksums[variant]);
+	}
+	cout << "  " << ((checksums[0] == checksums[1]) ? "same" : "different") << " objectives and scores" << endl;
+
+	scorer.grid_score_extract_smooth = extract_smooth;
+	scorer.halite_pyramid.build(scorer.grid_score_extract_smooth, game.distance_manager.distance_cell_shipyard_or_dropoff);
+	game.turn_number = turn_number;
+}
+
+void hlt::benchmark::objective_assignment(Game& game)
+{
+	// EXTRACT_ZONE allocation of ObjectiveManager on all my ships: the full loop searches every ship
+	// left each round, LazyGreedy only the ships whose best cell is in the square an assignment lowered
+	Scorer& scorer = game.scorer;
+	const WrapTable& wrap = game.game_map->wrap;
+	const int iterations = 3;
+	const Grid<double> extract_smooth = scorer.grid_score_extract_smooth;
+	const vector<shared_ptr<Ship>>& ships = game.me->my_ships;
+
+	// Off the turns of the HALITE_DEBUG checks, which scan every cell of each search
+	const int turn_number = game.turn_number;
+	game.turn_number += (game.turn_number % HalitePyramid::CHECK_PERIOD == 0);
+
+	auto search = [&](int ship) { return scorer.search_objective_cell(ships[ship], game, false); };
+	auto assign = [&](int ship, const Objective& objective, double& checksum)
+	{
+		checksum += objective.score + (double)(ship * game.game_map->width * game.game_map->height + objective.target_position.y * game.game_map->width + objective.target_position.x);
+		scorer.decreases_score_in_target_cell(ships[ship], objective.target_position, 0.0, game);
+		scorer.decreases_score_in_target_area(ships[ship], objective.target_position, game);
+	};
+
+	double checksums[2] = { 0.0, 0.0 };
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		int searches = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			scorer.grid_score_extract_smooth = extract_smooth;
+			scorer.halite_pyramid.build(scorer.grid_score_extract_smooth, game.distance_manager.distance_cell_shipyard_or_dropoff);
+
+			if (variant == 0)
+			{
+				vector<int> left(ships.size());
+				for (int i = 0; i < (int)left.size(); ++i)
+					left[i] = i;
+
+				while (!left.empty())
+				{
+					int best = 0;
+					Objective best_objective;
+					for (int i = 0; i < (int)left.size(); ++i)
+					{
+						Objective objective = search(left[i]);
+						searches++;
+						if ((i == 0) || (objective.score > best_objective.score))
+						{
+							best = i;
+							best_objective = objective;
+						}
+					}
+
+					assign(left[best], best_objective, checksums[variant]);
+					left.erase(left.begin() + best);
+				}
+			}
+			else
+			{
+				LazyGreedy greedy;
+				greedy.reset((int)ships.size());
+				while (!greedy.empty())
+				{
+					int best = greedy.pop(search);
+					const Position target = greedy.objective(best).target_position;
+					assign(best, greedy.objective(best), checksums[variant]);
+					greedy.invalidate([&wrap, &target](const Objective& objective)
+					{
+						return (wrap.distances_x_from(target.x)[objective.target_position.x] <= Scorer::TARGET_AREA_RADIUS) &&
+							(wrap.distances_y_from(target.y)[objective.target_position.y] <= Scorer::TARGET_AREA_RADIUS);
+					});
+				}
+				searches += greedy.searches;
+			}
+		}
+
+		report((variant == 0) ? "Objective assignment of " + to_string(ships.size()) + " ships (full loop)" : "Objective assignment of " + to_string(ships.size()) + " ships (LazyGreedy)",
+			chrono::high_resolution_clock::now() - start, iterations, (long long)checksums[variant]);
+		cout << "  " << searches / iterations << " searches per assignment" << endl;
+	}
+	cout << "  " << ((checksums[0] == checksums[1]) ? "same" : "different") << " objectives and scores" << endl;
+
+	scorer.grid_score_extract_smooth = extract_smooth;
+	scorer.halite_pyramid.build(scorer.grid_score_extract_smooth, game.distance_manager.distance_cell_shipyard_or_dropoff);
+	game.turn_number = turn_number;
+}
+
+void hlt::benchmark::distance_fields(Game& game)
+{
+	// Nearest own and enemy structure of every cell, and grid_score_enemies from the nearest enemy ship
+	const int width = game.game_map->width;
+	const int height = game.game_map->height;
+	const int iterations = 20;
+	const WrapTable& wrap = game.game_map->wrap;
+
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		long long checksum = 0;
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			if (variant == 0)
+			{
+				// Previous loops: over the structures for each cell, over the rows of each enemy ship
+				vector<Position> own_structures = game.my_shipyard_or_dropoff_positions();
+				vector<double> enemies(width * height, 0.0);
+				vector<int> distances(width);
+				for (const auto& player : game.players)
+					if (player->id != game.my_id)
+						for (auto& ship_iterator : player->ships)
+							for (int i = 0; i < height; ++i)
+							{
+								wrap.fill_distance_row(ship_iterator.second->position.x, ship_iterator.second->position.y, i, distances.data());
+								for (int j = 0; j < width; ++j)
+									enemies[i * width + j] = max(enemies[i * width + j], (4.0 - (double)distances[j]) / 4.0);
+							}
+
+				for (int i = 0; i < height; ++i)
+					for (int j = 0; j < width; ++j)
+					{
+						Position position = Position(j, i);
+						int own = INT_MAX;
+						for (const Position& structure : own_structures)
+							own = min(own, game.distance(position, structure));
+
+						int enemy = INT_MAX;
+						Position closest_enemy = game.my_shipyard_position();
+						for (const Position& structure : game.enemy_shipyard_or_dropoff_positions())
+						{
+							int distance = game.distance(position, structure);
+							if (distance <= enemy)
+								enemy = distance, closest_enemy = structure;
+						}
+
+						checksum += own + enemy + closest_enemy.x + closest_enemy.y + (long long)(4.0 * enemies[i * width + j]);
+					}
+			}
+			else
+			{
+				game.distance_fields.update(game);
+				game.scorer.update_grid_score_enemies(game);
+
+				for (int i = 0; i < height; ++i)
+					for (int j = 0; j < width; ++j)
+					{
+						Position position = Position(j, i);
+						Position closest_enemy = game.get_closest_enemy_shipyard_or_dropoff(position);
+						checksum += game.distance_fields.distance_own_structure(game.my_id, position) + game.distance_fields.distance_enemy_structure(game.my_id, position)
+							+ closest_enemy.x + closest_enemy.y + (long long)(4.0 * game.scorer.grid_score_enemies[i][j]);
+					}
+			}
+		}
+
+		report((variant == 0) ? "Structure distances and grid_score_enemies (loops over the sources)" : "Structure distances and grid_score_enemies (DistanceFields)",
+			chrono::high_resolution_clock::now() - start, iterations, checksum);
+	}
+}
+
+void hlt::benchmark::smoothing_incremental(Game& game)
+{
+	// Whole turns following the synthetic game, ships move and cells are mined; the checks of
+	// HALITE_DEBUG run on multiples of 50, which these turns stay clear of
+	mt19937 rng(19);
+	const int turns = 45;
+	const int cell_updates = 100;
+	vector<string> frames = synthetic_turns(turns, rng, game.turn_number + 1, cell_updates);
+
+	double incremental_ms = 0.0;
+	chrono::duration<double> rebuild_time(0);
+	int mismatching_turns = 0;
+	double checksum = 0.0;
+
+	for (const string& frame : frames)
+	{
+		stringstream source(frame);
+		input::set_source(source);
+		game.update_frame();
+
+		// The neighbor cell and dropoff grids are lazy, read them as the bot would
+		Scorer& scorer = game.scorer;
+		auto read_start = chrono::high_resolution_clock::now();
+		scorer.grids.require(Scorer::GRID_NEIGHBOR_CELL);
+		scorer.grids.require(Scorer::GRID_DROPOFF);
+		incremental_ms += game.frame_tasks.task_ms("grid_score_extract") + chrono::duration<double, milli>(chrono::high_resolution_clock::now() - read_start).count();
+
+		vector<Grid<double>> incremental = { scorer.grid_score_neighbor_cell, scorer.grid_score_extract_smooth, scorer.grid_score_extract, scorer.grid_score_dropoff };
+
+		auto start = chrono::high_resolution_clock::now();
+		scorer.update_grid_score_neighbor_cell(game, true);
+		scorer.update_grid_score_extract(game, true);
+		scorer.update_grid_score_dropoff(game, true);
+		rebuild_time += chrono::high_resolution_clock::now() - start;
+
+		vector<Grid<double>> rebuilt = { scorer.grid_score_neighbor_cell, scorer.grid_score_extract_smooth, scorer.grid_score_extract, scorer.grid_score_dropoff };
+		bool mismatching = false;
+		for (int i = 0; i < (int)rebuilt.size(); ++i)
+			mismatching |= !incremental[i].nearly_equal(rebuilt[i], DiamondConvolution::WEIGHTED_SUM_TOLERANCE);
+		mismatching_turns += mismatching;
+		for (const Grid<double>& grid : rebuilt)
+			checksum += grid.sum();
+	}
+
+	report("Halite smoothing grids per turn (full rebuild)", rebuild_time, turns, (long long)checksum);
+	report("Halite smoothing grids per turn (incremental)", chrono::duration<double>(incremental_ms / 1000.0), turns, (long long)checksum);
+	cout << "  " << mismatching_turns << " turns differ from the full rebuild" << endl;
+}
+
+void hlt::benchmark::grid_registry(Game& game)
+{
+	// Whole turns following the synthetic game: grids nobody reads are not computed, as
+	// grid_score_dropoff when no dropoff is wanted
+	mt19937 rng(23);
+	const int turns = 20;
+	vector<string> frames = synthetic_turns(turns, rng, game.turn_number + 1, 100);
+	Scorer& scorer = game.scorer;
+
+	auto grid_tasks_ms = [&scorer](const TaskGraph& graph) {
+		double ms = 0.0;
+		for (int id = 0; id < scorer.grids.size(); ++id)
+			ms += graph.task_ms(scorer.grids.name(id));
+		return ms;
+	};
+
+	double lazy_ms = 0.0;
+	double every_grid_ms = 0.0;
+	int computed = 0;
+	int skipped = 0;
+	for (const string& frame : frames)
+	{
+		stringstream source(frame);
+		input::set_source(source);
+		game.update_frame();
+
+		double turn_ms = grid_tasks_ms(game.frame_tasks);
+		lazy_ms += turn_ms;
+		computed += scorer.grids.computed_count();
+		skipped += scorer.grids.skipped_count();
+
+		// Before the registry the grids nobody read were computed on every turn as well
+		auto start = chrono::high_resolution_clock::now();
+		scorer.grids.require(Scorer::GRID_NEIGHBOR_CELL);
+		scorer.grids.require(Scorer::GRID_DROPOFF);
+		every_grid_ms += turn_ms + chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	}
+
+	report("Grids per turn (every grid)", chrono::duration<double>(every_grid_ms / 1000.0), turns, (long long)grids_checksum(game));
+	report("Grids per turn (registry)", chrono::duration<double>(lazy_ms / 1000.0), turns, (long long)grids_checksum(game));
+	cout << "  " << computed / (double)turns << " grids computed and " << skipped / (double)turns << " not computed per turn" << endl;
+}
+
+void hlt::benchmark::map_statistics(Game& game)
+{
+	// Frames setting BENCH_CELL_UPDATES random cells, the map is restored afterwards
+	mt19937 rng(17);
+	GameMap& map = *game.game_map;
+	const int cells = map.width * map.height;
+	const int turns = 500;
+
+	vector<uint16_t> saved(cells);
+	for (int index = 0; index < cells; ++index)
+		saved[index] = map.cell(index)->halite;
+
+	MapStatistics statistics;
+	statistics.reset(map);
+
+	chrono::duration<double> scan_time(0);
+	chrono::duration<double> incremental_time(0);
+	int mismatching_turns = 0;
+	long long checksum = 0;
+
+	for (int turn = 0; turn < turns; ++turn)
+	{
+		map.changes.clear();
+		for (int i = 0; i < BENCH_CELL_UPDATES; ++i)
+		{
+			MapCell* cell = map.cell((int)(rng() % cells));
+			uint16_t previous = cell->halite;
+			cell->halite = (uint16_t)(rng() % 1000);
+			map.changes.push_back({ map.index(cell), previous, cell->halite });
+		}
+
+		// Previous Game::update_frame: sum and full sort of the map
+		auto start = chrono::high_resolution_clock::now();
+		int total = 0;
+		vector<int> halite_all(cells);
+		for (int index = 0; index < cells; ++index)
+		{
+			total += map.cell(index)->halite;
+			halite_all[index] = map.cell(index)->halite;
+		}
+		sort(halite_all.begin(), halite_all.end());
+		int median = halite_all[(int)(0.5 * cells)];
+		scan_time += chrono::high_resolution_clock::now() - start;
+
+		start = chrono::high_resolution_clock::now();
+		statistics.apply(map.changes);
+		int incremental_total = statistics.total();
+		int incremental_median = statistics.percentile(0.5);
+		incremental_time += chrono::high_resolution_clock::now() - start;
+
+		mismatching_turns += (total != incremental_total) || (median != incremental_median);
+		checksum += total + median;
+	}
+
+	report("Map total and median per turn (scan and sort)", scan_time, turns, checksum);
+	report("Map total and median per turn (MapStatistics)", incremental_time, turns, checksum);
+	cout << "  " << mismatching_turns << " turns differ from the scan" << endl;
+
+	for (int index = 0; index < cells; ++index)
+		map.cell(index)->halite = saved[index];
+	map.changes.clear();
+}
+
+void hlt::benchmark::inspiration_grids(Game& game)
+{
+	const int width = game.game_map->width;
+	const int height = game.game_map->height;
+	const int iterations = 20;
+	const WrapTable& wrap = game.game_map->wrap;
+
+	long long checksums[2] = { 0, 0 };
+
+	// Previous build: a distance row per ship and map row, 4 thresholds per cell
+	vector<vector<int>> inspiration, inspiration_enemies, enemies_distance_2, enemies_distance_5, inspiration_enemies_6;
+	{
+		vector<int> distances(width);
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			inspiration = inspiration_enemies = enemies_distance_2 = enemies_distance_5 = inspiration_enemies_6 = vector<vector<int>>(height, vector<int>(width, 0));
+
+			for (const auto& player : game.players)
+				for (auto& ship_iterator : player->ships)
+				{
+					const Position& ship_position = ship_iterator.second->position;
+					bool is_me = (player->id == game.my_id);
+
+					for (int i = 0; i < height; ++i)
+					{
+						wrap.fill_distance_row(ship_position.x, ship_position.y, i, distances.data());
+
+						for (int j = 0; j < width; ++j)
+						{
+							int distance = distances[j];
+							if (distance <= 4)
+								(is_me ? inspiration_enemies : inspiration)[i][j] += 1;
+							if ((distance <= 2) && !is_me)
+								enemies_distance_2[i][j] += 1;
+							if ((distance <= 5) && !is_me)
+								enemies_distance_5[i][j] += 1;
+							if ((distance <= 6) && is_me)
+								inspiration_enemies_6[i][j] += 1;
+						}
+					}
+				}
+		}
+
+		chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+		checksums[0] = grid_checksum(inspiration, width, height) + grid_checksum(inspiration_enemies, width, height) + grid_checksum(enemies_distance_2, width, height)
+			+ grid_checksum(enemies_distance_5, width, height) + grid_checksum(inspiration_enemies_6, width, height);
+		report("Inspiration grids " + to_string(game.total_ships_number()) + " ships (distance rows)", elapsed, iterations, checksums[0]);
+	}
+
+	// Diamond stamps, as in Scorer
+	{
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+			game.scorer.rebuild_grid_score_inspiration(game);
+
+		chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+		const Scorer& scorer = game.scorer;
+		checksums[1] = grid_checksum(scorer.grid_score_inspiration, width, height) + grid_checksum(scorer.grid_score_inspiration_enemies, width, height) + grid_checksum(scorer.grid_score_enemies_distance_2, width, height)
+			+ grid_checksum(scorer.grid_score_enemies_distance_5, width, height) + grid_checksum(scorer.grid_score_inspiration_enemies_6, width, height);
+		report("Inspiration grids " + to_string(game.total_ships_number()) + " ships (diamond stamps)", elapsed, iterations, checksums[1]);
+	}
+
+	int mismatches = 0;
+	for (int i = 0; i < height; ++i)
+		for (int j = 0; j < width; ++j)
+		{
+			mismatches +=
+				(inspiration[i][j] != game.scorer.grid_score_inspiration[i][j]) +
+				(inspiration_enemies[i][j] != game.scorer.grid_score_inspiration_enemies[i][j]) +
+				(enemies_distance_2[i][j] != game.scorer.grid_score_enemies_distance_2[i][j]) +
+				(enemies_distance_5[i][j] != game.scorer.grid_score_enemies_distance_5[i][j]) +
+				(inspiration_enemies_6[i][j] != game.scorer.grid_score_inspiration_enemies_6[i][j]);
+		}
+	cout << "  " << ((checksums[0] == checksums[1]) ? "same" : "different") << " grids, " << mismatches << " cells differ over the 5 grids" << endl;
+}
+
+void hlt::benchmark::inspiration_incremental(Game& game)
+{
+	// Turns following the synthetic game, ships move one cell and a few die and spawn every turn
+	mt19937 rng(13);
+	const int turns = 100;
+	vector<string> frames = synthetic_turns(turns, rng, game.turn_number + 1);
+
+	chrono::duration<double> incremental_time(0);
+	chrono::duration<double> rebuild_time(0);
+	int mismatching_turns = 0;
+	long long checksum = 0;
+
+	game.scorer.rebuild_grid_score_inspiration(game);
+	game.scorer.inspiration_turn = game.turn_number;
+
+	for (const string& frame : frames)
+	{
+		stringstream source(frame);
+		input::set_source(source);
+		input::begin_frame();
+		game.turn_number = input::read_int();
+
+		game.game_map->ship_pool.begin_turn();
+		for (size_t p = 0; p < game.players.size(); ++p)
+		{
+			PlayerId player_id = input::read_int();
+			int num_ships = input::read_int();
+			int num_dropoffs = input::read_int();
+			Halite halite = input::read_int();
+			game.players[player_id]->_update(num_ships, num_dropoffs, halite, game.turn_number, game.game_map->ship_pool);
+		}
+
+		auto start = chrono::high_resolution_clock::now();
+		game.scorer.update_grid_score_inspiration(game);
+		incremental_time += chrono::high_resolution_clock::now() - start;
+
+		Grid<int> incremental = game.scorer.inspiration_planes;
+
+		start = chrono::high_resolution_clock::now();
+		game.scorer.rebuild_grid_score_inspiration(game);
+		rebuild_time += chrono::high_resolution_clock::now() - start;
+
+		const Grid<int>& rebuilt = game.scorer.inspiration_planes;
+		mismatching_turns += (incremental != rebuilt);
+		for (int plane = 0; plane < rebuilt.plane_count(); ++plane)
+			checksum += rebuilt.plane(plane).reduce(0, [](int total, int count) { return total + count; });
+	}
+
+	report("Inspiration grids per turn (full rebuild)", rebuild_time, turns, checksum);
+	report("Inspiration grids per turn (incremental)", incremental_time, turns, checksum);
+	cout << "  " << mismatching_turns << " turns differ from the full rebuild" << endl;
+}
+
+void hlt::benchmark::diamond_smoothing(Game& game)
+{
+	// Halite sums of the neighbor cell (radius 2, 0.1 / (1 + d)), extract (radius 3, 1 / d) and dropoff (radius 7, flat) grids
+	const WrapTable& wrap = game.game_map->wrap;
+	const int cells = game.game_map->width * game.game_map->height;
+	const int iterations = 20;
+
+	vector<int> halite(cells);
+	vector<int> rich_halite(cells);
+	for (int index = 0; index < cells; ++index)
+	{
+		halite[index] = game.game_map->cell(index)->halite;
+		rich_halite[index] = (halite[index] > 500) ? halite[index] : 0;
+	}
+
+	vector<double> neighbor_cell(cells), extract(cells), dropoff(cells);
+
+	// Square scan with a distance check per tap
+	{
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+			for (int y = 0; y < game.game_map->height; ++y)
+				for (int x = 0; x < game.game_map->width; ++x)
+				{
+					int index = y * game.game_map->width + x;
+					neighbor_cell[index] = extract[index] = dropoff[index] = 0.0;
+
+					for (const WrappedCell& cell : wrap.diamond(x, y, 2))
+						if (halite[cell.index] > 500)
+							neighbor_cell[index] += (double)halite[cell.index] * 0.1 / (1.0 + cell.distance);
+					for (const WrappedCell& cell : wrap.diamond(x, y, 3))
+						extract[index] += (double)halite[cell.index] / max((double)cell.distance, 1.0);
+					for (const WrappedCell& cell : wrap.diamond(x, y, 7))
+						dropoff[index] += (double)halite[cell.index];
+				}
+
+		double checksum = 0.0;
+		for (int index = 0; index < cells; ++index)
+			checksum += neighbor_cell[index] + extract[index] + dropoff[index];
+		report("Diamond smoothing r2 + r3 + r7 (taps)", chrono::high_resolution_clock::now() - start, iterations, (long long)checksum);
+	}
+
+	// Diagonal prefix sums
+	{
+		DiamondConvolution convolution;
+		double max_difference = 0.0, max_relative_difference = 0.0;
+		double checksum = 0.0;
+		auto compare = [&](double sum, double tap_sum)
+		{
+			max_difference = max(max_difference, fabs(sum - tap_sum));
+			max_relative_difference = max(max_relative_difference, fabs(sum - tap_sum) / max(1.0, fabs(tap_sum)));
+		};
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+		{
+			checksum = 0.0;
+			max_difference = max_relative_difference = 0.0;
+
+			convolution.compute_rings(wrap, rich_halite, 2);
+			for (int index = 0; index < cells; ++index)
+			{
+				double sum = 0.0;
+				for (int distance = 0; distance <= 2; ++distance)
+					sum += (double)convolution.ring_sum(distance, index) * 0.1 / (1.0 + distance);
+				checksum += sum;
+				compare(sum, neighbor_cell[index]);
+			}
+
+			convolution.compute_rings(wrap, halite, 3);
+			for (int index = 0; index < cells; ++index)
+			{
+				double sum = 0.0;
+				for (int distance = 0; distance <= 3; ++distance)
+					sum += (double)convolution.ring_sum(distance, index) / max((double)distance, 1.0);
+				checksum += sum;
+				compare(sum, extract[index]);
+			}
+
+			convolution.compute_diamond(wrap, halite, 7);
+			for (int index = 0; index < cells; ++index)
+			{
+				double sum = (double)convolution.diamond_sum(7, index);
+				checksum += sum;
+				compare(sum, dropoff[index]);
+			}
+		}
+
+		report("Diamond smoothing r2 + r3 + r7 (DiamondConvolution)", chrono::high_resolution_clock::now() - start, iterations, (long long)checksum);
+		cout << "  max difference with the taps: " << max_difference << ", relative " << max_relative_difference
+			<< ((max_relative_difference <= DiamondConvolution::WEIGHTED_SUM_TOLERANCE) ? " within" : " beyond") << " the tolerance of " << DiamondConvolution::WEIGHTED_SUM_TOLERANCE << endl;
+	}
+}
+
+// Heap bytes and allocations of grids, and of the vector<vector> rows they replaced: one outer vector and one row per plane
+struct GridFootprint
+{
+	size_t grid_bytes = 0, grid_allocations = 0;
+	size_t rows_bytes = 0, rows_allocations = 0;
+
+	template<typename T> void add(const Grid<T>& grid)
+	{
+		if (!grid.memory_bytes())
+			return;
+
+		grid_bytes += grid.memory_bytes();
+		grid_allocations += 1;
+		rows_bytes += grid.plane_count() * grid.height * (sizeof(vector<T>) + grid.width * sizeof(T));
+		rows_allocations += grid.plane_count() * (grid.height + 1);
+	}
+};
+
+void hlt::benchmark::grid_memory(Game& game)
+{
+	// Footprint of the grids of the synthetic game, allocator overhead left out
+	GridFootprint footprint;
+	const Scorer& scorer = game.scorer;
+	const DistanceManager& distance_manager = game.distance_manager;
+	const Blocker& blocker = game.blocker;
+	for (const Grid<double>* grid : { &scorer.grid_score_highway, &scorer.grid_score_enemies, &scorer.grid_score_extract, &scorer.grid_score_dropoff, &scorer.grid_score_extract_smooth,
+		&scorer.grid_score_extract_nearby, &scorer.grid_score_neighbor_cell, &scorer.grid_score_ships_nearby, &scorer.grid_score_can_stay_still })
+		footprint.add(*grid);
+	for (const Grid<int>* grid : { &scorer.grid_score_move, &scorer.inspiration_planes, &scorer.grid_score_allies_around,
+		&distance_manager.distance_cell_shipyard_or_dropoff, &distance_manager.distances, &blocker.sides })
+		footprint.add(*grid);
+	footprint.add(distance_manager.closest_shipyard_or_dropoff);
+
+	cout << "Scorer, DistanceManager and Blocker grids " << game.game_map->width << "x" << game.game_map->height << ": "
+		<< footprint.rows_bytes / 1024 << "KB in " << footprint.rows_allocations << " allocations (vector<vector>), "
+		<< footprint.grid_bytes / 1024 << "KB in " << footprint.grid_allocations << " allocations (Grid)" << endl;
+
+	// The 13 single plane grids of the Scorer: allocate, fill, copy and sum each of them
+	const int grids = 13;
+	const int iterations = 200;
+
+	for (int variant = 0; variant < 2; ++variant)
+	{
+		double checksum = 0.0;
+		size_t heap_allocations = allocation_counter::count();
+		auto start = chrono::high_resolution_clock::now();
+
+		for (int it = 0; it < iterations; ++it)
+			for (int g = 0; g < grids; ++g)
+			{
+				double value = (double)(it + g);
+				if (variant == 0)
+				{
+					vector<vector<double>> grid(BENCH_WIDTH, vector<double>(BENCH_WIDTH, value));
+					vector<vector<double>> copy = grid;
+					for (const vector<double>& row : copy)
+						for (double cell : row)
+							checksum += cell;
+				}
+				else
+				{
+					Grid<double> grid(BENCH_WIDTH, BENCH_WIDTH, 1, value);
+					Grid<double> copy = grid;
+					checksum += copy.sum();
+				}
+			}
+
+		report((variant == 0) ? "Scorer grids allocate + copy + sum (vector<vector>)" : "Scorer grids allocate + copy + sum (Grid)",
+			chrono::high_resolution_clock::now() - start, iterations, (long long)checksum);
+		cout << "  " << heap_allocations_per(heap_allocations, (double)(iterations * grids)) << " heap allocations per grid" << endl;
+	}
+}
+
+int hlt::benchmark::run(unordered_map<string, int> constants)
+{
+	parse_frame();
+	player_update();
+	wrap_tables();
+
+	Game& game = synthetic_game(constants);
+	scorer_update_grids(game);
+	frame_tasks(game);
+	grid_memory(game); // grids sized by the frame tasks
+	inspiration_grids(game);
+	diamond_smoothing(game);
+	grid_kernels(game);
+	pathfinder_search(game);
+	astar_expansions(game);
+	combat_cache(game);
+	objective_search(game);
+	objective_assignment(game);
+	distance_fields(game);
+	map_statistics(game);
+	inspiration_incremental(game); // plays turns on the synthetic game, keep last
+	smoothing_incremental(game); // plays whole turns after them
+	grid_registry(game);
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+namespace hlt
+{
+	struct Game;
+
+	/*
+	Offline benchmarks, run with "MyBot --benchmark". They work on synthetic
+	64x64 4 players data and print their timings on stdout.
+	*/
+	namespace benchmark
+	{
+		int run(unordered_map<string, int> constants);
+
+		void parse_frame();
+		void player_update();
+		void wrap_tables();
+		void scorer_update_grids(Game& game);
+		void frame_tasks(Game& game);
+		void grid_memory(Game& game);
+		void inspiration_grids(Game& game);
+		void diamond_smoothing(Game& game);
+		void grid_kernels(Game& game);
+		void pathfinder_search(Game& game);
+		void astar_expansions(Game& game);
+		void combat_cache(Game& game);
+		void objective_search(Game& game);
+		void objective_assignment(Game& game);
+		void distance_fields(Game& game);
+		void map_statistics(Game& game);
+		void inspiration_incremental(Game& game);
+		void smoothing_incremental(Game& game);
+		void grid_registry(Game& game);
+	}
+}
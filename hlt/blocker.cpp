@@ -105,7 +105,7 @@ void Blocker::fill_positions_to_block_scores(const Game& game)
 	}
 }
 
-unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const Position& enemy_base, const Game& game) const
+unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const Position& enemy_base, const Game& game)
 {
 	Position north = game.game_map->directional_offset(enemy_base, Direction::NORTH);
 	Position south = game.game_map->directional_offset(enemy_base, Direction::SOUTH);
@@ -118,13 +118,11 @@ unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const P
 	int height = game.game_map->height;
 	int reach = 6;
 
-	vector<vector<int>> grid = vector<vector<int>>(height, vector<int>(width, 0));
+	sides.resize(width, height);
 
 	for (int i = 0; i < height; ++i)
 		for (int j = 0; j < width; ++j)
 		{
-			grid[i][j] = 0;
-
 			Position position = Position(j, i);
 
 			if (game.distance(position, enemy_base) > reach)
@@ -136,8 +134,8 @@ unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const P
 			int halite_enemy = 0;
 			int halite_ally = 0;
 
-			if (game.enemy_in_cell(position) && (game.ship_on_position(position)->owner == game.mapcell(enemy_base)->structure->owner))
-				halite_enemy += game.mapcell(position)->ship->halite;
+			if (game.enemy_in_cell(position) && (game.playerid_on_position(position) == game.mapcell(enemy_base)->structure_owner))
+				halite_enemy += game.ship_on_position(position)->halite;
 
 			if (game.ally_in_cell(position))
 				halite_ally += 500;
@@ -146,32 +144,32 @@ unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const P
 			{
 				if ((dx == 0) && (dy == 0)) // enemy base
 				{
-					grid[i][j] = 0;
+					sides[i][j] = 0;
 				}
 				else if ((dx < 0) && (dy < 0)) // north west
 				{
-					grid[i][j] = 1;
+					sides[i][j] = 1;
 
 					score_north += 0.5 * (halite_enemy - halite_ally);
 					score_west += 0.5 * (halite_enemy - halite_ally);
 				}
 				else if ((dx > 0) && (dy < 0)) // north est
 				{
-					grid[i][j] = 1;
+					sides[i][j] = 1;
 
 					score_north += 0.5 * (halite_enemy - halite_ally);
 					score_east += 0.5 * (halite_enemy - halite_ally);
 				}
 				else if ((dx < 0) && (dy > 0)) // south west
 				{
-					grid[i][j] = 2;
+					sides[i][j] = 2;
 
 					score_south += 0.5 * (halite_enemy - halite_ally);
 					score_west += 0.5 * (halite_enemy - halite_ally);
 				}
 				else // south east
 				{
-					grid[i][j] = 2;
+					sides[i][j] = 2;
 
 					score_south += 0.5 * (halite_enemy - halite_ally);
 					score_east += 0.5 * (halite_enemy - halite_ally);
@@ -181,12 +179,12 @@ unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const P
 			{
 				if (dx < 0) // west
 				{
-					grid[i][j] = 3;
+					sides[i][j] = 3;
 					score_west += halite_enemy - halite_ally;
 				}
 				else // east
 				{
-					grid[i][j] = 4;
+					sides[i][j] = 4;
 					score_east += halite_enemy - halite_ally;
 				}
 			}
@@ -194,12 +192,12 @@ unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const P
 			{
 				if (dy < 0) // north
 				{
-					grid[i][j] = 1;
+					sides[i][j] = 1;
 					score_north += halite_enemy - halite_ally;
 				}
 				else // south
 				{
-					grid[i][j] = 2;
+					sides[i][j] = 2;
 					score_south += halite_enemy - halite_ally;
 				}
 			}	
@@ -216,7 +214,7 @@ unordered_map<Position, double> Blocker::position_to_block_on_enemy_base(const P
 	//	line += "" + positions[i].to_string_position() + ": " + to_string(scores[i]) + ", ";
 	//log::log(line);
 
-	//log::log_vectorvector(grid);
+	//log::log_grid(sides);
 
 	return scores;
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "command.hpp"
 #include "map_cell.hpp"
 #include "priority_queue.hpp"
+#include "grid.hpp"
 
 #include <vector>
 #include <algorithm>
@@ -24,11 +25,13 @@ namespace hlt
 	public:
 		unordered_map<Position, unordered_map<Position, double>> positions_to_block_scores;
 		PlayerId player_to_block;
+		// Side of the enemy base each cell within reach blocks, reused for every base
+		Grid<int> sides;
 
 		Blocker() : player_to_block(0) {};
 
 		void fill_positions_to_block_scores(const Game& game);
-		unordered_map<Position, double> position_to_block_on_enemy_base(const Position& enemy_base, const Game& game) const;
+		unordered_map<Position, double> position_to_block_on_enemy_base(const Position& enemy_base, const Game& game);
 
 		Objective find_best_objective_cell(shared_ptr<Ship> ship, const Game& game) const;
 		void decrease_score_in_position(const Position& position, const Game& game);
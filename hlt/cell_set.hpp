@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Set of flat cell indexes of a map, in insertion order. Inserting and testing are O(1),
+	clearing is O(size), so a set reused every turn costs what was put in it.
+	*/
+	class CellSet
+	{
+	public:
+		typedef vector<int>::const_iterator const_iterator;
+
+		void resize(int cells)
+		{
+			if ((int)member.size() != cells)
+			{
+				member.assign(cells, 0);
+				list.clear();
+			}
+		}
+
+		inline bool contains(int index) const { return member[index] != 0; }
+		inline void insert(int index)
+		{
+			if (member[index])
+				return;
+			member[index] = 1;
+			list.push_back(index);
+		}
+		void insert_all()
+		{
+			for (int index = 0; index < (int)member.size(); ++index)
+				insert(index);
+		}
+		void clear()
+		{
+			for (int index : list)
+				member[index] = 0;
+			list.clear();
+		}
+
+		inline int size() const { return (int)list.size(); }
+		inline bool full() const { return list.size() == member.size(); }
+		inline const_iterator begin() const { return list.begin(); }
+		inline const_iterator end() const { return list.end(); }
+
+	private:
+		vector<char> member;
+		vector<int> list;
+	};
+}
@@ -13,15 +13,15 @@ using namespace std;
 void CollisionResolver::fill_positions_enemies(Game& game)
 {
 	positions_enemies.clear();
-	for (vector<MapCell>& row : game.game_map->cells)
-		for (MapCell& cell : row)
-			if (cell.is_occupied_by_enemy(game.me->id))
-				positions_enemies[cell.ship] = cell.ship->position;
+	for (const auto& player : game.players)
+		if (player->id != game.me->id)
+			for (auto& ship_iterator : player->ships)
+				positions_enemies[ship_iterator.second] = ship_iterator.second->position;
 }
 
-unordered_map<shared_ptr<Ship>, Position> CollisionResolver::find_any_collisions(const Game& game)
+ShipSlotMap<Position> CollisionResolver::find_any_collisions(const Game& game)
 {
-	unordered_map<shared_ptr<Ship>, Position> collisions;
+	ShipSlotMap<Position> collisions;
 
 	for (auto& ship_move1 : game.positions_next_turn)
 	{
@@ -94,7 +94,7 @@ bool CollisionResolver::collision_one_ship_rtb(vector<shared_ptr<Ship>> collisio
 	));
 }
 
-bool CollisionResolver::resolve_collisions_one_ship_escaping(unordered_map<shared_ptr<Ship>, Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game)
+bool CollisionResolver::resolve_collisions_one_ship_escaping(ShipSlotMap<Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game)
 {
 	shared_ptr<Ship> ship1 = collisions_ordered[0];
 	shared_ptr<Ship> ship2 = collisions_ordered[1];
@@ -138,8 +138,8 @@ bool CollisionResolver::resolve_collisions_one_ship_escaping(unordered_map<share
 		return false;
 
 	// try to find best place for moving ship to go
-	vector<double> scores = { -99999999.0 }; // to reach 10m around -200 score
-	vector<Position> positions = { ship_to_move->position };
+	SmallVector<double, 5> scores = { -99999999.0 }; // to reach 10m around -200 score
+	SmallVector<Position, 5> positions = { ship_to_move->position };
 
 	for (auto& position : game.adjacent_positions_to_position(ship_to_move->position))
 	{
@@ -174,7 +174,7 @@ bool CollisionResolver::resolve_collisions_one_ship_escaping(unordered_map<share
 	return true;
 }
 
-bool CollisionResolver::resolve_collisions_one_ship_rtb(unordered_map<shared_ptr<Ship>, Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game)
+bool CollisionResolver::resolve_collisions_one_ship_rtb(ShipSlotMap<Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game)
 {
 	shared_ptr<Ship> ship1 = collisions_ordered[0];
 	shared_ptr<Ship> ship2 = collisions_ordered[1];
@@ -191,8 +191,8 @@ bool CollisionResolver::resolve_collisions_one_ship_rtb(unordered_map<shared_ptr
 		return false;
 
 	// try to find best place for moving ship to go
-	vector<double> scores = { -99999999.0 }; // to reach 10m around -200 score
-	vector<Position> positions = { ship_to_move->position };
+	SmallVector<double, 5> scores = { -99999999.0 }; // to reach 10m around -200 score
+	SmallVector<Position, 5> positions = { ship_to_move->position };
 
 	for (auto& position : game.adjacent_positions_to_position(ship_to_move->position))
 	{
@@ -226,7 +226,7 @@ bool CollisionResolver::resolve_collisions_one_ship_rtb(unordered_map<shared_ptr
 	return true;
 }
 
-void CollisionResolver::edit_collisions(unordered_map<shared_ptr<Ship>, Position> collisions, Game& game)
+void CollisionResolver::edit_collisions(ShipSlotMap<Position> collisions, Game& game)
 {
 	// First order ships/positions in increasing order of halite
 	PriorityQueue<shared_ptr<Ship>, int> ships_in_priority;
@@ -415,10 +415,10 @@ void CollisionResolver::check_rtb_ships_safe(Game& game)
 		if (
 			ship->is_objective(Objective_Type::BACK_TO_BASE) && 
 			(ship->position == position_next_turn) &&
-			(game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, position_next_turn) <= -400.0)
+			(game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, position_next_turn, game) <= -400.0)
 		)
 		{
-			vector<Position> adjacent_positions = game.adjacent_positions_to_position(ship->position);
+			SmallVector<Position, 4> adjacent_positions = game.adjacent_positions_to_position(ship->position);
 
 			for (auto& position : adjacent_positions)
 			{
@@ -439,9 +439,9 @@ void CollisionResolver::check_rtb_ships_safe(Game& game)
 	}
 }
 
-vector<Command> CollisionResolver::resolve_moves(Game& game)
+void CollisionResolver::resolve_moves(Game& game)
 {
-	vector<Command> resolved_moves;
+	vector<Command>& resolved_moves = game.command_queue;
 
 	// Initialize with all ship's first moves, eventually with enemy's positions
 	fill_positions_enemies(game);
@@ -449,7 +449,7 @@ vector<Command> CollisionResolver::resolve_moves(Game& game)
 	// While own collisions exist, edit ships one by one
 	for (int repeat = 0; repeat < 2; repeat++)
 	{
-		unordered_map<shared_ptr<Ship>, Position> collisions = find_any_collisions(game);
+		ShipSlotMap<Position> collisions = find_any_collisions(game);
 		int i = 0;
 		while (collisions.size())
 		{
@@ -479,6 +479,4 @@ vector<Command> CollisionResolver::resolve_moves(Game& game)
 			resolved_moves.push_back(ship_position.first->move(direction));
 		}
 	}
-
-	return resolved_moves;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "position.hpp"
 #include "direction.hpp"
 #include "ship.hpp"
+#include "ship_pool.hpp"
 #include "shipyard.hpp"
 #include "command.hpp"
 
@@ -17,27 +18,27 @@ namespace hlt
 	class CollisionResolver
 	{
 		private:
-		unordered_map<shared_ptr<Ship>, Position> positions_enemies;
+		ShipSlotMap<Position> positions_enemies;
 
 		public:
 		CollisionResolver() {}
 
 		// Move Resolve
-		unordered_map<shared_ptr<Ship>, Position> find_any_collisions(const Game& game);
+		ShipSlotMap<Position> find_any_collisions(const Game& game);
 		bool position_collides_with_existing(shared_ptr<Ship> ship, const Position& position, const Game& game);
 		bool is_ship_switching_places(shared_ptr<Ship> ship, Game& game) const;
-		void edit_collisions(unordered_map<shared_ptr<Ship>, Position> collisions, Game& game);
+		void edit_collisions(ShipSlotMap<Position> collisions, Game& game);
 		void fill_positions_enemies(Game& game);
 		void exchange_ships(Game& game);
 		void exchange_ships_on_base(Game& game);
 		void check_rtb_ships_safe(Game& game);
-		vector<Command> resolve_moves(Game& game);
+		void resolve_moves(Game& game); // appends to Game::command_queue
 
 		// Resolve when one ship is escaping
 		bool collision_one_ship_escaping(vector<shared_ptr<Ship>> collisions_ordered, Game& game);
-		bool resolve_collisions_one_ship_escaping(unordered_map<shared_ptr<Ship>, Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game);
+		bool resolve_collisions_one_ship_escaping(ShipSlotMap<Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game);
 
 		bool collision_one_ship_rtb(vector<shared_ptr<Ship>> collisions_ordered, Game& game);
-		bool resolve_collisions_one_ship_rtb(unordered_map<shared_ptr<Ship>, Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game);
+		bool resolve_collisions_one_ship_rtb(ShipSlotMap<Position> collisions, vector<shared_ptr<Ship>> collisions_ordered, Game& game);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "combat_cache.hpp"
+#include "scorer.hpp"
+#include "game.hpp"
+
+using namespace hlt;
+using namespace std;
+
+constexpr double CombatCache::NO_ENEMY;
+
+CombatCache::CombatCache() : width(0), height(0), windows_filled(0), rows_filled(0), row_queries(0)
+{
+	int window_cell = 0;
+	for (int dy = -WINDOW_RADIUS; dy <= WINDOW_RADIUS; ++dy)
+		for (int dx = -WINDOW_RADIUS; dx <= WINDOW_RADIUS; ++dx)
+			window_index[(dy + WINDOW_RADIUS) * WINDOW_WIDTH + dx + WINDOW_RADIUS] = (abs(dx) + abs(dy) <= WINDOW_RADIUS) ? window_cell++ : -1;
+}
+
+void CombatCache::begin_turn(const Scorer& scorer, const Game& game)
+{
+	const GameMap& map = *game.game_map;
+	width = map.width;
+	height = map.height;
+
+	int slots = map.ship_pool.capacity();
+	windows.resize(slots);
+	window_filled.assign(slots, 0);
+	windows_filled = 0;
+
+	const double* allies_plane = scorer.grid_score_ships_nearby.data(game.my_id);
+
+	enemy_index.assign(slots, -1);
+	enemies.clear();
+	for (auto& player : game.players)
+	{
+		if (player->id == game.my_id)
+			continue;
+
+		const double* enemies_plane = scorer.grid_score_ships_nearby.data(player->id);
+		for (auto& ship_iterator : player->ships)
+		{
+			const Ship& ship = *ship_iterator.second;
+			int index = map.wrap.index(ship.position.x, ship.position.y);
+			const MapCell& cell = map.cells[index];
+
+			enemy_index[ship.slot] = (int)enemies.size();
+			enemies.push_back({ (double)ship.halite, (double)cell.halite, allies_plane[index], enemies_plane[index], cell.has_structure() && (cell.structure_owner != game.my_id) });
+		}
+	}
+
+	rows.resize(slots * enemies.size());
+	row_filled.assign(slots, 0);
+	rows_filled = 0;
+	row_queries = 0;
+}
+
+void CombatCache::fill_window(const Ship& my_ship, const Scorer& scorer, const Game& game)
+{
+	const GameMap& map = *game.game_map;
+	const WrapTable& wrap = map.wrap;
+	const double* allies_plane = scorer.grid_score_ships_nearby.data(my_ship.owner);
+	const double halite_ally = (double)my_ship.halite;
+
+	array<double, WINDOW_CELLS * SIDES>& window = windows[my_ship.slot];
+	double* out = window.data();
+
+	// Same cell order as window_index: rows of the diamond from the top, left to right
+	for (int dy = -WINDOW_RADIUS; dy <= WINDOW_RADIUS; ++dy)
+		for (int dx = -(WINDOW_RADIUS - abs(dy)); dx <= WINDOW_RADIUS - abs(dy); ++dx)
+		{
+			int index = wrap.index(my_ship.position.x + dx, my_ship.position.y + dy);
+			const MapCell& cell = map.cells[index];
+			double halite_cell = (double)cell.halite;
+			double allies_nearby = allies_plane[index];
+			bool enemy_dropoff = cell.has_structure() && (cell.structure_owner != game.my_id);
+
+			for (Direction direction : ALL_CARDINALS)
+			{
+				const MapCell& side = map.cells[wrap.neighbor(index, direction)];
+				if (!side.is_occupied_by_enemy(game.my_id))
+				{
+					*out++ = NO_ENEMY;
+					continue;
+				}
+
+				const Ship& enemy_ship = *map.ship_pool.at(side.ship);
+				double enemies_nearby = scorer.grid_score_ships_nearby.data(enemy_ship.owner)[index];
+				*out++ = combat_value(halite_ally, (double)enemy_ship.halite, halite_cell, allies_nearby, enemies_nearby, enemy_dropoff);
+			}
+		}
+
+	window_filled[my_ship.slot] = 1;
+	windows_filled++;
+}
+
+void CombatCache::fill_row(const Ship& my_ship) const
+{
+	const double halite_ally = (double)my_ship.halite;
+	double* out = rows.data() + my_ship.slot * enemies.size();
+
+	for (const EnemyCell& enemy : enemies)
+		*out++ = combat_value(halite_ally, enemy.halite, enemy.halite_cell, enemy.allies_nearby, enemy.enemies_nearby, enemy.enemy_dropoff);
+
+	row_filled[my_ship.slot] = 1;
+	rows_filled++;
+}
+
+double CombatCache::enemy_cell_score(const Ship& my_ship, const Ship& enemy_ship, const Scorer& scorer, const Game& game) const
+{
+	int enemy = ((size_t)enemy_ship.slot < enemy_index.size()) ? enemy_index[enemy_ship.slot] : -1;
+	if ((enemy < 0) || (my_ship.owner != game.my_id) || ((size_t)my_ship.slot >= row_filled.size()))
+	{
+		log::log("Error: CombatCache: no combat score of ship " + to_string(my_ship.id) + " against ship " + to_string(enemy_ship.id));
+		exit(1);
+	}
+
+	row_queries++;
+	if (!row_filled[my_ship.slot])
+		fill_row(my_ship);
+
+	return rows[my_ship.slot * enemies.size() + enemy];
+}
+
+double CombatCache::score(const shared_ptr<Ship>& my_ship, const shared_ptr<Ship>& enemy_ship, const Position& position, const Scorer& scorer, const Game& game) const
+{
+	if (has_window(my_ship->slot))
+	{
+		int cell = window_cell(my_ship->position, position);
+		if (cell >= 0)
+		{
+			const WrapTable& wrap = game.game_map->wrap;
+			int index = wrap.index(position.x, position.y);
+			int enemy_cell = wrap.index(enemy_ship->position.x, enemy_ship->position.y);
+
+			for (int side = 0; side < SIDES; ++side)
+				if (wrap.neighbor(index, ALL_CARDINALS[side]) == enemy_cell)
+					return window_scores(my_ship->slot, cell)[side];
+		}
+	}
+
+	return scorer.combat_score(my_ship, enemy_ship, position, game);
+}
+
+void CombatCache::log_stats() const
+{
+	log::log("Combat cache: " + to_string(windows_filled) + " windows, " + to_string(rows_filled) + " rows of " + to_string(enemies.size()) + " enemies for " + to_string(row_queries) + " queries");
+}
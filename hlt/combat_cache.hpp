@@ -0,0 +1,119 @@
+#pragma once
+
+#include "ship.hpp"
+#include "position.hpp"
+#include "direction.hpp"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cfloat>
+
+using namespace std;
+
+namespace hlt
+{
+	struct Game;
+	class Scorer;
+
+	/*
+	Combat scores of the turn (Scorer::combat_score), keyed by ship slots and cells. They
+	only depend on the cargo of both ships, the halite of the cell and the ship pressure
+	grids, none of which changes during a turn once grid_score_targets is done.
+
+	Windows hold the scores of one of my ships moving to each cell of its radius
+	WINDOW_RADIUS diamond against the enemy on each side of the cell, the cell itself
+	included, in ALL_CARDINALS order. They are filled in one pass per ship by fill_window.
+	Rows hold the scores of one of my ships attacking every enemy on the enemy's own cell;
+	a row is filled on its first query, from the main thread only.
+	*/
+	class CombatCache
+	{
+	public:
+		static const int WINDOW_RADIUS = 3;
+		static const int WINDOW_WIDTH = 2 * WINDOW_RADIUS + 1;
+		static const int WINDOW_CELLS = 2 * WINDOW_RADIUS * (WINDOW_RADIUS + 1) + 1;
+		static const int SIDES = 5; // ALL_CARDINALS, STILL is an enemy on the cell itself
+		static constexpr double NO_ENEMY = DBL_MAX;
+
+		CombatCache();
+
+		// Score of my ship fighting an enemy ship on a cell from the cargos, the cell halite and the ship pressures
+		static inline double combat_value(double halite_ally, double halite_enemy, double halite_cell, double allies_nearby, double enemies_nearby, bool enemy_dropoff)
+		{
+			double halite_total = (halite_ally + halite_enemy + halite_cell);
+
+			double score_attack_allies_nearby = max(allies_nearby - max(900.0 - halite_ally, 0.0), 0.0);
+			double score_attack_enemies_nearby = max(enemies_nearby - max(900.0 - halite_enemy, 0.0), 0.0);
+
+			double proba_of_me_getting_back = (score_attack_allies_nearby + score_attack_enemies_nearby > 0.0) ? score_attack_allies_nearby / (score_attack_allies_nearby + score_attack_enemies_nearby) : 0.0;
+
+			// do not attack on enemy dropoffs
+			if (enemy_dropoff)
+				proba_of_me_getting_back = 0.0;
+
+			double score_ally = -halite_ally + halite_total * proba_of_me_getting_back;
+			double score_enemy = -halite_enemy + halite_total * (1.0 - proba_of_me_getting_back);
+
+			return score_ally - score_enemy;
+		}
+
+		// Forgets the previous turn and reads the enemies, once the ship pressure grids are up to date
+		void begin_turn(const Scorer& scorer, const Game& game);
+
+		// Scores of my ship against the enemies next to every cell of its window
+		void fill_window(const Ship& my_ship, const Scorer& scorer, const Game& game);
+		inline bool has_window(int slot) const { return ((size_t)slot < window_filled.size()) && window_filled[slot]; }
+		// SIDES scores of the window cell, NO_ENEMY on the sides without an enemy
+		inline const double* window_scores(int slot, int window_cell) const { return windows[slot].data() + window_cell * SIDES; }
+		// Window cell of the position for a ship on center, -1 outside of the window
+		inline int window_cell(const Position& center, const Position& position) const
+		{
+			// Toroidal offset, maps are much larger than the window
+			int dx = position.x - center.x;
+			int dy = position.y - center.y;
+			dx += (dx > width / 2) ? -width : ((dx < -width / 2) ? width : 0);
+			dy += (dy > height / 2) ? -height : ((dy < -height / 2) ? height : 0);
+
+			if ((abs(dx) > WINDOW_RADIUS) || (abs(dy) > WINDOW_RADIUS))
+				return -1;
+			return window_index[(dy + WINDOW_RADIUS) * WINDOW_WIDTH + dx + WINDOW_RADIUS];
+		}
+
+		// Score of my ship attacking the enemy on the enemy's cell
+		double enemy_cell_score(const Ship& my_ship, const Ship& enemy_ship, const Scorer& scorer, const Game& game) const;
+
+		// Score of any of my ships, enemy and cell: cached when held, computed otherwise
+		double score(const shared_ptr<Ship>& my_ship, const shared_ptr<Ship>& enemy_ship, const Position& position, const Scorer& scorer, const Game& game) const;
+
+		void log_stats() const;
+
+	private:
+		// An enemy ship on its own cell, everything combat_value needs but my cargo
+		struct EnemyCell
+		{
+			double halite;
+			double halite_cell;
+			double allies_nearby;
+			double enemies_nearby;
+			bool enemy_dropoff;
+		};
+
+		int width;
+		int height;
+		int window_index[WINDOW_WIDTH * WINDOW_WIDTH]; // by (dy, dx) offset, -1 out of the diamond
+
+		vector<array<double, WINDOW_CELLS * SIDES>> windows; // by slot of my ship
+		vector<char> window_filled;
+		int windows_filled;
+
+		vector<int> enemy_index; // by slot, -1 for my ships
+		vector<EnemyCell> enemies;
+		mutable vector<double> rows; // slot of my ship * enemies + enemy index
+		mutable vector<char> row_filled;
+		mutable int rows_filled;
+		mutable int row_queries;
+
+		void fill_row(const Ship& my_ship) const;
+	};
+}
@@ -1,22 +1,45 @@
 #include "command.hpp"
 
-#include <iostream>
-
-constexpr char GENERATE= 'g';
-constexpr char CONSTRUCT[] = "c ";
-constexpr char MOVE[] = "m ";
-
-
 hlt::Command hlt::command::spawn_ship() {
-    return std::string(1, GENERATE);
+    return Command(Command::Action::SPAWN, 0, Direction::STILL);
 }
 
 hlt::Command hlt::command::transform_ship_into_dropoff_site(EntityId id) 
 {
-    return CONSTRUCT + std::to_string(id);
+    return Command(Command::Action::CONSTRUCT, id, Direction::STILL);
 }
 
 hlt::Command hlt::command::move(EntityId id, hlt::Direction direction) 
 {
-    return MOVE + std::to_string(id) + ' ' + static_cast<char>(direction);
+    return Command(Command::Action::MOVE, id, direction);
+}
+
+void hlt::Command::append_to(std::string& out) const
+{
+    out.push_back(static_cast<char>(action));
+
+    if (action != Action::SPAWN)
+    {
+        char digits[16];
+        int n = 0;
+        unsigned int value = static_cast<unsigned int>(id);
+
+        do
+        {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+
+        out.push_back(' ');
+        while (n)
+            out.push_back(digits[--n]);
+
+        if (action == Action::MOVE)
+        {
+            out.push_back(' ');
+            out.push_back(static_cast<char>(direction));
+        }
+    }
+
+    out.push_back(' ');
 }
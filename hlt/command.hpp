@@ -7,7 +7,28 @@
 
 namespace hlt 
 {
-    typedef std::string Command;
+    /*
+    Compact engine command, serialized only once per turn by Game::end_turn.
+    */
+    struct Command
+    {
+        enum class Action : char
+        {
+            SPAWN = 'g',
+            CONSTRUCT = 'c',
+            MOVE = 'm',
+        };
+
+        Action action;
+        Direction direction;
+        EntityId id;
+
+        Command() : action(Action::MOVE), direction(Direction::STILL), id(0) {}
+        Command(Action action, EntityId id, Direction direction) : action(action), direction(direction), id(id) {}
+
+        // Append the engine text of the command, followed by a space
+        void append_to(std::string& out) const;
+    };
 
     namespace command 
 	{
@@ -2,7 +2,6 @@
 #include "log.hpp"
 
 #include <unordered_map>
-#include <sstream>
 #include <vector>
 
 using namespace hlt;
@@ -58,35 +57,31 @@ static bool get_bool(std::unordered_map<std::string, std::string>& map, const st
 }
 
 void hlt::constants::populate_constants(const std::string& string_from_engine) {
-    std::string input;
-    for (char c : string_from_engine) {
+    std::vector<std::string> tokens;
+    size_t token_start = 0;
+
+    // Tokens are split on the JSON punctuation in place, no intermediate stream.
+    for (size_t i = 0; i <= string_from_engine.size(); ++i) {
+        char c = (i < string_from_engine.size()) ? string_from_engine[i] : ' ';
         switch (c) {
             case '{':
             case '}':
             case ',':
             case ':':
             case '"':
-                input.push_back(' ');
+            case ' ':
+            case '\r':
+            case '\n':
+                if (i > token_start) {
+                    tokens.emplace_back(string_from_engine, token_start, i - token_start);
+                }
+                token_start = i + 1;
                 break;
             default:
-                input.push_back(c);
                 break;
         }
     }
 
-    std::stringstream input_stream = std::stringstream(input);
-    std::vector<std::string> tokens;
-
-    for (;;) {
-        std::string token;
-        if (!std::getline(input_stream, token, ' ')) {
-            break;
-        }
-        if (!token.empty()) {
-            tokens.push_back(token);
-        }
-    }
-
     if ((tokens.size() % 2) != 0) {
         log::log("Error: constants: expected even total number of key and value tokens from server.");
         exit(1);
@@ -1,3 +1,8 @@
 #pragma once
 
-#define HALITE_LOCAL true
\ No newline at end of file
+#define HALITE_LOCAL true
+// Consistency checks of the incremental structures against full rebuilds, off in the shipped bot
+// and turned on by the HALITE_DEBUG option of CMake
+#ifndef HALITE_DEBUG
+#define HALITE_DEBUG false
+#endif
\ No newline at end of file
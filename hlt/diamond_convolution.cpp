@@ -0,0 +1,148 @@
+#include "diamond_convolution.hpp"
+
+using namespace hlt;
+using namespace std;
+
+constexpr double DiamondConvolution::WEIGHTED_SUM_TOLERANCE;
+
+void DiamondConvolution::compute_rings(const WrapTable& wrap, const vector<int>& values, int max_radius)
+{
+	prepare(wrap, values, max_radius);
+	first_radius = 0;
+	for (int r = 0; r <= max_radius; ++r)
+		compute_radius(wrap, values, r);
+}
+
+void DiamondConvolution::compute_diamond(const WrapTable& wrap, const vector<int>& values, int radius)
+{
+	prepare(wrap, values, radius);
+	first_radius = radius;
+	compute_radius(wrap, values, radius);
+}
+
+void DiamondConvolution::add(const WrapTable& wrap, int index, int delta)
+{
+	for (const WrappedCell& cell : wrap.diamond(index % width, index / width, radius))
+		for (int r = max(cell.distance, first_radius); r <= radius; ++r)
+			sums[r][cell.index] += delta;
+}
+
+void DiamondConvolution::prepare(const WrapTable& wrap, const vector<int>& values, int max_radius)
+{
+	if ((max_radius < 0) || (2 * max_radius + 1 > wrap.width) || (2 * max_radius + 1 > wrap.height))
+	{
+		log::log("Error: DiamondConvolution: radius " + to_string(max_radius) + " does not fit the map");
+		exit(1);
+	}
+
+	width = wrap.width;
+	height = wrap.height;
+	radius = max_radius;
+	build_prefix_sums(wrap, values);
+
+	if ((int)sums.size() < radius + 1)
+		sums.resize(radius + 1);
+}
+
+void DiamondConvolution::build_prefix_sums(const WrapTable& wrap, const vector<int>& values)
+{
+	margin = radius + 2;
+	padded_width = width + 2 * margin;
+	const int padded_height = height + 2 * margin;
+
+	down_right.resize(padded_width * padded_height);
+	down_left.resize(padded_width * padded_height);
+
+	for (int y = 0; y < padded_height; ++y)
+	{
+		const int* row = values.data() + wrap.wrap_y(y - margin) * width;
+
+		for (int x = 0; x < padded_width; ++x)
+		{
+			int value = row[wrap.wrap_x(x - margin)];
+			int index = y * padded_width + x;
+
+			down_right[index] = value + (((y > 0) && (x > 0)) ? down_right[index - padded_width - 1] : 0);
+			down_left[index] = value + (((y > 0) && (x + 1 < padded_width)) ? down_left[index - padded_width + 1] : 0);
+		}
+	}
+}
+
+void DiamondConvolution::compute_radius(const WrapTable& wrap, const vector<int>& values, int r)
+{
+	vector<int>& out = sums[r];
+	out.resize(width * height);
+
+	// First row cell by cell
+	for (int x = 0; x < width; ++x)
+	{
+		int sum = 0;
+		for (const WrappedCell& cell : wrap.diamond(x, 0, r))
+			sum += values[cell.index];
+		out[x] = sum;
+	}
+
+	// Every next row from the row above, in padded coordinates (X, Y) = (x + margin, y + margin)
+	for (int y = 1; y < height; ++y)
+	{
+		const int Y = y + margin;
+		const int* above = out.data() + (y - 1) * width;
+		int* current = out.data() + y * width;
+
+		for (int x = 0; x < width; ++x)
+		{
+			const int X = x + margin;
+
+			// Bottom V of the diamond on (X, Y): (X - r, Y) to (X, Y + r) to (X + r, Y)
+			int added = (diagonal_down_right(Y + r, X) - diagonal_down_right(Y - 1, X - r - 1))
+				+ (r ? (diagonal_down_left(Y + r - 1, X + 1) - diagonal_down_left(Y - 1, X + r + 1)) : 0);
+
+			// Top V of the diamond on (X, Y - 1): (X - r, Y - 1) to (X, Y - 1 - r) to (X + r, Y - 1)
+			int removed = (diagonal_down_left(Y - 1, X - r) - diagonal_down_left(Y - 2 - r, X + 1))
+				+ (r ? (diagonal_down_right(Y - 1, X + r) - diagonal_down_right(Y - 1 - r, X)) : 0);
+
+			current[x] = above[x] + added - removed;
+		}
+	}
+}
+
+void IncrementalDiamondSums::begin(const WrapTable& wrap, int new_radius)
+{
+	int cells = wrap.width * wrap.height;
+	if (((int)values.size() != cells) || (new_radius != radius))
+	{
+		values.assign(cells, 0);
+		radius = new_radius;
+		built = false;
+	}
+
+	changes.clear();
+	dirty.resize(cells);
+	dirty.clear();
+}
+
+void IncrementalDiamondSums::update(const WrapTable& wrap, bool rebuild)
+{
+	// Past a map of changed cells, recomputing is cheaper
+	if (!built || rebuild || ((int)changes.size() * DiamondConvolution::diamond_cells(radius) >= (int)values.size()))
+	{
+		if (rings)
+			convolution.compute_rings(wrap, values, radius);
+		else
+			convolution.compute_diamond(wrap, values, radius);
+
+		built = true;
+		dirty.insert_all();
+	}
+	else
+	{
+		for (const pair<int, int>& change : changes)
+		{
+			convolution.add(wrap, change.first, change.second);
+			for (const WrappedCell& cell : wrap.diamond(change.first % wrap.width, change.first / wrap.width, radius))
+				dirty.insert(cell.index);
+		}
+	}
+
+	changes.clear();
+}
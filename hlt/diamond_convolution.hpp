@@ -0,0 +1,107 @@
+#pragma once
+
+#include "wrap_table.hpp"
+#include "cell_set.hpp"
+
+#include <vector>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Toroidal diamond sums of an integer grid: the sum of the values at manhattan distance
+	<= radius of every cell, for all cells at once, in O(1) per cell and radius.
+
+	The grid is copied into a plane padded by radius + 2 cells of wrapped values on each
+	side. Prefix sums along both diagonals are then built over the padded plane. Moving a
+	diamond one row down adds its bottom V and removes the top V of the previous diamond,
+	and each V is two diagonal segments read from the prefix sums. Only the first row is
+	summed cell by cell.
+
+	Sums are exact integers, so radial weight profiles are applied to exact ring sums:
+	sum over d of weight(d) * ring_sum(d). That adds one term per ring instead of one per
+	cell, which rounds differently from a loop over the cells: weighted grids match such a
+	loop within WEIGHTED_SUM_TOLERANCE (relative), and are compared with it.
+	*/
+	class DiamondConvolution
+	{
+	public:
+		// Relative difference allowed between weighted sums added in different orders, about 4e-16 measured on 64x64
+		static constexpr double WEIGHTED_SUM_TOLERANCE = 1e-12;
+
+		DiamondConvolution() : width(0), height(0), radius(-1), first_radius(0) {}
+
+		// Diamond sums of values (row-major, width * height) for every radius <= max_radius, for ring_sum
+		void compute_rings(const WrapTable& wrap, const vector<int>& values, int max_radius);
+		// Diamond sums of values for this radius only
+		void compute_diamond(const WrapTable& wrap, const vector<int>& values, int radius);
+
+		// Sum of the values at distance <= r of the cell, r must have been computed
+		inline int diamond_sum(int r, int index) const { return sums[r][index]; }
+		// Diamond sums of every cell for radius r, row-major
+		inline const vector<int>& diamond_sums(int r) const { return sums[r]; }
+		// Sum of the values at distance exactly d of the cell, after compute_rings
+		inline int ring_sum(int d, int index) const { return d ? (sums[d][index] - sums[d - 1][index]) : sums[0][index]; }
+
+		// Follows a change of delta of the value of a cell: every computed sum around it moves by delta
+		void add(const WrapTable& wrap, int index, int delta);
+		inline int max_radius() const { return radius; }
+		static inline int diamond_cells(int r) { return 2 * r * (r + 1) + 1; }
+
+	private:
+		int width;
+		int height;
+		int radius;
+		int first_radius; // sums below it are not computed
+		int margin;
+		int padded_width;
+		vector<int> down_right; // down_right[y][x] = padded[y][x] + down_right[y - 1][x - 1]
+		vector<int> down_left; // down_left[y][x] = padded[y][x] + down_left[y - 1][x + 1]
+		vector<vector<int>> sums;
+
+		void prepare(const WrapTable& wrap, const vector<int>& values, int max_radius);
+		void build_prefix_sums(const WrapTable& wrap, const vector<int>& values);
+		void compute_radius(const WrapTable& wrap, const vector<int>& values, int r);
+
+		inline int diagonal_down_right(int y, int x) const { return down_right[y * padded_width + x]; }
+		inline int diagonal_down_left(int y, int x) const { return down_left[y * padded_width + x]; }
+	};
+
+	/*
+	Integer grid and its diamond sums kept from turn to turn. Values are set cell by cell,
+	then update() moves the sums by delta around each changed cell, in O(changes * diamond
+	cells), or recomputes them when that would cost more. Cells whose sums changed are left
+	in dirty until the next begin().
+	*/
+	class IncrementalDiamondSums
+	{
+	public:
+		IncrementalDiamondSums(bool rings) : rings(rings), radius(-1), built(false) {}
+
+		// Starts a turn; a new map size or radius rebuilds everything on update()
+		void begin(const WrapTable& wrap, int radius);
+		inline void set(int index, int value)
+		{
+			if (values[index] == value)
+				return;
+			changes.push_back(make_pair(index, value - values[index]));
+			values[index] = value;
+		}
+		// Sums up to date with the values, recomputed from scratch when rebuild is set
+		void update(const WrapTable& wrap, bool rebuild);
+
+		// True once sums were computed, after that only changed values need to be set
+		inline bool is_built() const { return built; }
+		inline const DiamondConvolution& sums() const { return convolution; }
+		CellSet dirty;
+
+	private:
+		bool rings; // every radius up to radius, for ring sums, or only radius
+		int radius;
+		bool built;
+		vector<int> values;
+		vector<pair<int, int>> changes; // index and delta
+		DiamondConvolution convolution;
+	};
+}
@@ -0,0 +1,247 @@
+#include "distance_fields.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+
+using namespace hlt;
+using namespace std;
+
+void DistanceFields::search(const WrapTable& wrap, const vector<pair<int, int>>& sources, int* distance, int* nearest, vector<int>& queue)
+{
+	const int cells = wrap.width * wrap.height;
+	fill(distance, distance + cells, UNREACHED);
+	if (nearest)
+		fill(nearest, nearest + cells, -1);
+
+	// Every cell is queued once
+	queue.resize(cells);
+	int* head = queue.data();
+	int* tail = queue.data();
+	for (const pair<int, int>& source : sources)
+	{
+		if (distance[source.first] == UNREACHED)
+		{
+			distance[source.first] = 0;
+			*tail++ = source.first;
+		}
+		if (nearest)
+			nearest[source.first] = max(nearest[source.first], source.second);
+	}
+
+	// A cell is dequeued after every cell of the previous layer, so its label is already the highest of its nearest sources
+	while (head != tail)
+	{
+		int cell = *head++;
+		int next_distance = distance[cell] + 1;
+
+		for (int neighbor : wrap.neighbors_of(cell))
+		{
+			if (distance[neighbor] == UNREACHED)
+			{
+				distance[neighbor] = next_distance;
+				*tail++ = neighbor;
+				if (nearest)
+					nearest[neighbor] = nearest[cell];
+			}
+			else if (nearest && (distance[neighbor] == next_distance))
+				nearest[neighbor] = max(nearest[neighbor], nearest[cell]);
+		}
+	}
+}
+
+void DistanceFields::update_structures(const Game& game)
+{
+	const WrapTable& wrap = game.game_map->wrap;
+	const int cells = wrap.width * wrap.height;
+
+	own_structures.assign(players, vector<Position>());
+	enemy_structures.assign(players, vector<Position>());
+	for (const auto& player : game.players)
+	{
+		own_structures[player->id].push_back(player->shipyard->position);
+		for (auto& dropoff : player->dropoffs)
+			own_structures[player->id].push_back(dropoff.second->position);
+
+		sources.clear();
+		for (int i = 0; i < (int)own_structures[player->id].size(); ++i)
+			sources.push_back(make_pair(wrap.index(own_structures[player->id][i].x, own_structures[player->id][i].y), i));
+		search(wrap, sources, own_structure_distance.data(player->id), own_structure_nearest.data(player->id), queue);
+	}
+
+	// Enemy structures in the order of enemy_shipyard_or_dropoff_positions, the nearest of the other players
+	// with the last one on ties, as a loop over that list would keep it
+	for (const auto& player : game.players)
+	{
+		int* distance = enemy_structure_distance.data(player->id);
+		int* nearest = enemy_structure_nearest.data(player->id);
+		fill(distance, distance + cells, UNREACHED);
+		fill(nearest, nearest + cells, -1);
+
+		for (const auto& enemy : game.players)
+		{
+			if (enemy->id == player->id)
+				continue;
+
+			int offset = (int)enemy_structures[player->id].size();
+			const int* enemy_distance = own_structure_distance.data(enemy->id);
+			const int* enemy_nearest = own_structure_nearest.data(enemy->id);
+			for (int index = 0; index < cells; ++index)
+				if (enemy_distance[index] <= distance[index])
+				{
+					distance[index] = enemy_distance[index];
+					nearest[index] = offset + enemy_nearest[index];
+				}
+			enemy_structures[player->id].insert(enemy_structures[player->id].end(), own_structures[enemy->id].begin(), own_structures[enemy->id].end());
+		}
+	}
+
+	structures_built = true;
+}
+
+bool DistanceFields::same_structures(const Game& game) const
+{
+	for (const auto& player : game.players)
+	{
+		const vector<Position>& structures = own_structures[player->id];
+		if ((structures.size() != player->dropoffs.size() + 1) || (structures[0] != player->shipyard->position))
+			return false;
+
+		int i = 1;
+		for (auto& dropoff : player->dropoffs)
+			if (structures[i++] != dropoff.second->position)
+				return false;
+	}
+	return true;
+}
+
+void DistanceFields::update(const Game& game)
+{
+	Stopwatch s("Updating distance fields");
+
+	const GameMap& map = *game.game_map;
+	const WrapTable& wrap = map.wrap;
+	const int cells = map.width * map.height;
+
+	int new_players = 0;
+	for (const auto& player : game.players)
+		new_players = max(new_players, player->id + 1);
+
+	if ((new_players != players) || (own_structure_distance.width != map.width) || (own_structure_distance.height != map.height))
+	{
+		players = new_players;
+		structures_built = false;
+		for (Grid<int>* grid : { &own_structure_distance, &own_structure_nearest, &enemy_structure_distance, &enemy_structure_nearest, &ship_distance, &enemy_ship_distance })
+			grid->resize(map.width, map.height, players);
+		ship_territory.resize(map.width, map.height);
+	}
+
+	if (!structures_built || !same_structures(game))
+		update_structures(game);
+
+	for (const auto& player : game.players)
+	{
+		sources.clear();
+		for (auto& ship_iterator : player->ships)
+			sources.push_back(make_pair(wrap.index(ship_iterator.second->position.x, ship_iterator.second->position.y), 0));
+		search(wrap, sources, ship_distance.data(player->id), nullptr, queue);
+	}
+
+	// Enemy ships and territory from the ship fields of every player
+	for (const auto& player : game.players)
+	{
+		int* distance = enemy_ship_distance.data(player->id);
+		fill(distance, distance + cells, UNREACHED);
+		for (const auto& enemy : game.players)
+			if (enemy->id != player->id)
+			{
+				const int* enemy_distance = ship_distance.data(enemy->id);
+				for (int index = 0; index < cells; ++index)
+					distance[index] = min(distance[index], enemy_distance[index]);
+			}
+	}
+
+	for (int index = 0; index < cells; ++index)
+	{
+		int distance = UNREACHED, owner = NO_PLAYER;
+		for (const auto& player : game.players)
+		{
+			int player_distance = ship_distance.data(player->id)[index];
+			if (player_distance < distance)
+			{
+				distance = player_distance;
+				owner = player->id;
+			}
+			else if ((player_distance == distance) && (distance != UNREACHED))
+				owner = CONTESTED;
+		}
+		ship_territory.data()[index] = owner;
+	}
+}
+
+void DistanceFields::check(const Game& game) const
+{
+	const GameMap& map = *game.game_map;
+	const WrapTable& wrap = map.wrap;
+
+	// Nearest source by a loop over the sources, the last one on ties
+	auto closest = [&wrap](const vector<Position>& positions, int x, int y)
+	{
+		pair<int, int> best = make_pair(UNREACHED, -1);
+		for (int i = 0; i < (int)positions.size(); ++i)
+		{
+			int distance = wrap.distance(x, y, positions[i].x, positions[i].y);
+			if (distance <= best.first)
+				best = make_pair(distance, i);
+		}
+		return best;
+	};
+
+	// Sources as the frame lists them, which the structure fields kept from an earlier turn must still match
+	vector<vector<Position>> structures(players), ships(players), enemy_structures_of(players), enemy_ships_of(players);
+	for (const auto& player : game.players)
+	{
+		structures[player->id].push_back(player->shipyard->position);
+		for (auto& dropoff : player->dropoffs)
+			structures[player->id].push_back(dropoff.second->position);
+		for (auto& ship_iterator : player->ships)
+			ships[player->id].push_back(ship_iterator.second->position);
+	}
+	for (const auto& player : game.players)
+		for (const auto& enemy : game.players)
+			if (enemy->id != player->id)
+			{
+				enemy_structures_of[player->id].insert(enemy_structures_of[player->id].end(), structures[enemy->id].begin(), structures[enemy->id].end());
+				enemy_ships_of[player->id].insert(enemy_ships_of[player->id].end(), ships[enemy->id].begin(), ships[enemy->id].end());
+			}
+
+	for (int y = 0; y < map.height; ++y)
+		for (int x = 0; x < map.width; ++x)
+		{
+			Position position = Position(x, y);
+
+			// Every ship of every player within distance of the cell, then the players who own one
+			int territory_distance = UNREACHED;
+			for (const auto& player : game.players)
+				territory_distance = min(territory_distance, closest(ships[player->id], x, y).first);
+			int owner = NO_PLAYER;
+			for (const auto& player : game.players)
+				if ((territory_distance != UNREACHED) && (closest(ships[player->id], x, y).first == territory_distance))
+					owner = (owner == NO_PLAYER) ? player->id : CONTESTED;
+
+			for (const auto& player : game.players)
+			{
+				pair<int, int> own = closest(structures[player->id], x, y);
+				pair<int, int> enemy = closest(enemy_structures_of[player->id], x, y);
+				pair<int, int> ship = closest(enemy_ships_of[player->id], x, y);
+
+				if ((own.first != distance_own_structure(player->id, position)) || (own.second != own_structure_nearest.at(position, player->id)) ||
+					(enemy.first != enemy_structure_distance.at(position, player->id)) || (enemy.second != enemy_structure_nearest.at(position, player->id)) ||
+					(closest(ships[player->id], x, y).first != distance_ship(player->id, position)) || (ship.first != distance_enemy_ship(player->id, position)) ||
+					(owner != territory(position)))
+				{
+					log::log("Error: DistanceFields: fields of player " + to_string(player->id) + " differ from the sources on " + position.to_string_position());
+					return;
+				}
+			}
+		}
+}
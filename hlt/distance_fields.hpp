@@ -0,0 +1,78 @@
+#pragma once
+
+#include "types.hpp"
+#include "position.hpp"
+#include "grid.hpp"
+#include "wrap_table.hpp"
+
+#include <vector>
+#include <climits>
+
+using namespace std;
+
+namespace hlt
+{
+	struct Game;
+
+	/*
+	Distance fields of the turn, planes indexed by player id:
+	- own structures: distance to the nearest shipyard or dropoff of the player, and which one
+	- enemy structures: the same for the structures of the other players
+	- ships, enemy ships: distance to the nearest ship of the player, of the other players
+	and territory gives the player whose ships reach each cell first.
+
+	The fields of the own structures and of the ships are multi-source breadth first searches
+	on the torus, from every source at once in O(cells) whatever the number of sources. Enemy
+	fields and territory are cell by cell minima of the fields of the players. Nearest
+	structures break ties as the loops over the structure lists did, the last one in list
+	order wins, and structure fields are only searched again when the lists changed.
+	*/
+	class DistanceFields
+	{
+	public:
+		static const int UNREACHED = INT_MAX;
+		static const int NO_PLAYER = -1;
+		static const int CONTESTED = -2; // reached first by ships of several players
+		static const int CHECK_PERIOD = 50;
+
+		DistanceFields() : players(0), structures_built(false) {}
+
+		void update(const Game& game);
+
+		inline int distance_own_structure(PlayerId player, const Position& position) const { return own_structure_distance.at(position, player); }
+		inline Position closest_own_structure(PlayerId player, const Position& position) const { return own_structures[player][own_structure_nearest.at(position, player)]; }
+		// The own structure fields of the player were searched from these positions, in this order
+		inline bool searched_with(PlayerId player, const vector<Position>& structures) const { return structures_built && (own_structures[player] == structures); }
+		inline bool has_enemy_structure(PlayerId player) const { return !enemy_structures[player].empty(); }
+		// Needs has_enemy_structure
+		inline int distance_enemy_structure(PlayerId player, const Position& position) const { return enemy_structure_distance.at(position, player); }
+		inline Position closest_enemy_structure(PlayerId player, const Position& position) const { return enemy_structures[player][enemy_structure_nearest.at(position, player)]; }
+		// UNREACHED without ships
+		inline int distance_ship(PlayerId player, const Position& position) const { return ship_distance.at(position, player); }
+		inline int distance_enemy_ship(PlayerId player, const Position& position) const { return enemy_ship_distance.at(position, player); }
+		// Player id, NO_PLAYER without ships or CONTESTED
+		inline int territory(const Position& position) const { return ship_territory.at(position); }
+
+		// Compares with the distances to every source, logs the first difference
+		void check(const Game& game) const;
+
+		// Distance of every cell to its nearest sources (cell, label), and if nearest is set, the highest label of those sources
+		static void search(const WrapTable& wrap, const vector<pair<int, int>>& sources, int* distance, int* nearest, vector<int>& queue);
+
+	private:
+		int players;
+		bool structures_built;
+		vector<vector<Position>> own_structures;
+		vector<vector<Position>> enemy_structures;
+		Grid<int> own_structure_distance, own_structure_nearest;
+		Grid<int> enemy_structure_distance, enemy_structure_nearest;
+		Grid<int> ship_distance, enemy_ship_distance;
+		Grid<int> ship_territory;
+		vector<int> queue;
+		vector<pair<int, int>> sources;
+
+		// Structures of the players in the order the fields were searched with
+		bool same_structures(const Game& game) const;
+		void update_structures(const Game& game);
+	};
+}
@@ -9,59 +9,94 @@
 using namespace hlt;
 using namespace std;
 
-void DistanceManager::fill_closest_shipyard_or_dropoff(const Game& game)
+// My shipyard then my dropoffs, with the number of enemies around each
+void DistanceManager::gather_bases(const Game& game, vector<Position>& base_or_dropoffs, vector<int>& enemies_around) const
 {
-	int width = game.game_map->width;
-	int height = game.game_map->height;
 	int radius = 3;
 
-	// gather dropoffs
-	vector<Position> base_or_dropoffs;
+	base_or_dropoffs.clear();
 	base_or_dropoffs.push_back(game.my_shipyard_position());
 	for (auto& dropoff_iterator : game.me->dropoffs)
 		base_or_dropoffs.push_back(dropoff_iterator.second->position);
 
-	// count enemies around each dropoff
-	unordered_map<Position, int> enemies_around;
-	for (auto& dropoff : base_or_dropoffs)
-	{
-		enemies_around[dropoff] = 0;
+	const WrapTable& wrap = game.game_map->wrap;
+	enemies_around.assign(base_or_dropoffs.size(), 0);
+	for (size_t d = 0; d < base_or_dropoffs.size(); ++d)
+		for (const WrappedCell& cell : wrap.diamond(base_or_dropoffs[d].x, base_or_dropoffs[d].y, radius))
+			if (game.scorer.grid_score_move[cell.y][cell.x] == 10)
+				enemies_around[d] += 1;
+}
 
-		for (int i = 0; i < height; ++i)
-			for (int j = 0; j < width; ++j)
-				if ((game.distance(Position(j, i), dropoff) <= radius) && (game.scorer.grid_score_move[i][j] == 10))
-					enemies_around[dropoff] += 1;
-		
-		log::log("Dropoff: " + dropoff.to_string_position() + " has " + to_string(enemies_around[dropoff]) + " enemies around.");
-	}
+// Closest dropoff of each cell from a distance grid per dropoff, discounted by the number of enemies around
+void DistanceManager::fill_from_distance_grids(const Game& game, const vector<Position>& base_or_dropoffs, const vector<int>& enemies_around, Grid<Position>& closest, Grid<int>& distance_closest)
+{
+	int width = game.game_map->width;
+	int height = game.game_map->height;
+	const WrapTable& wrap = game.game_map->wrap;
+
+	// distance grid from each dropoff
+	distances.resize(width, height, (int)base_or_dropoffs.size());
+	for (size_t d = 0; d < base_or_dropoffs.size(); ++d)
+		wrap.fill_distance_grid(base_or_dropoffs[d].x, base_or_dropoffs[d].y, distances.data((int)d));
 
 	// Find closest dropoff from each cell, discount by number of enemies around
 	for (int i = 0; i < height; ++i)
 		for (int j = 0; j < width; ++j)
 		{
-			Position position = Position(j, i);
-			Position closest_shipyard = Position();
+			size_t closest_shipyard = 0;
 			double min_distance = DBL_MAX;
 
-			for (auto& dropoff : base_or_dropoffs)
+			for (size_t d = 0; d < base_or_dropoffs.size(); ++d)
 			{
-				double distance = (double)game.distance(position, dropoff);
+				double distance = (double)distances.data((int)d)[i * width + j];
 				
-				distance *= pow(1.1, max(enemies_around[dropoff] - 4, 0));
+				distance *= pow(1.1, max(enemies_around[d] - 4, 0));
 
-				if (enemies_around[dropoff] >= 10)
+				if (enemies_around[d] >= 10)
 					distance = 9999999.0;
 
 				if (distance <= min_distance)
 				{
 					min_distance = distance;
-					closest_shipyard = dropoff;
+					closest_shipyard = d;
 				}
 			}
 
-			closest_shipyard_or_dropoff[i][j] = closest_shipyard;
-			distance_cell_shipyard_or_dropoff[i][j] = game.distance(closest_shipyard, position);
+			closest[i][j] = base_or_dropoffs[closest_shipyard];
+			distance_closest[i][j] = distances.data((int)closest_shipyard)[i * width + j];
 		}
+}
+
+void DistanceManager::fill_closest_shipyard_or_dropoff(const Game& game)
+{
+	int width = game.game_map->width;
+	int height = game.game_map->height;
+
+	vector<Position> base_or_dropoffs;
+	vector<int> enemies_around;
+	gather_bases(game, base_or_dropoffs, enemies_around);
+	for (size_t d = 0; d < base_or_dropoffs.size(); ++d)
+		log::log("Dropoff: " + base_or_dropoffs[d].to_string_position() + " has " + to_string(enemies_around[d]) + " enemies around.");
+
+	// Same discount for every dropoff keeps the nearest one, read from the distance fields when they were searched
+	// from these dropoffs: not after a dropoff was planned during the turn
+	bool same_discount = game.distance_fields.searched_with(game.my_id, base_or_dropoffs);
+	for (size_t d = 0; d < base_or_dropoffs.size(); ++d)
+		same_discount &= (enemies_around[d] < 10) && (max(enemies_around[d] - 4, 0) == max(enemies_around[0] - 4, 0));
+
+	if (same_discount)
+	{
+		for (int i = 0; i < height; ++i)
+			for (int j = 0; j < width; ++j)
+			{
+				Position position = Position(j, i);
+				closest_shipyard_or_dropoff[i][j] = game.distance_fields.closest_own_structure(game.my_id, position);
+				distance_cell_shipyard_or_dropoff[i][j] = game.distance_fields.distance_own_structure(game.my_id, position);
+			}
+		return;
+	}
+
+	fill_from_distance_grids(game, base_or_dropoffs, enemies_around, closest_shipyard_or_dropoff, distance_cell_shipyard_or_dropoff);
 
 	//for (unsigned int i = 0; i < closest_shipyard_or_dropoff.size(); ++i)
 	//{
@@ -79,4 +114,22 @@ void DistanceManager::fill_closest_shipyard_or_dropoff(const Game& game)
 
 	//	hlt::log::log(line);
 	//}
+}
+void DistanceManager::check(const Game& game)
+{
+	vector<Position> base_or_dropoffs;
+	vector<int> enemies_around;
+	gather_bases(game, base_or_dropoffs, enemies_around);
+
+	Grid<Position> closest(game.game_map->width, game.game_map->height);
+	Grid<int> distance_closest(game.game_map->width, game.game_map->height);
+	fill_from_distance_grids(game, base_or_dropoffs, enemies_around, closest, distance_closest);
+
+	for (int i = 0; i < game.game_map->height; ++i)
+		for (int j = 0; j < game.game_map->width; ++j)
+			if ((closest[i][j] != closest_shipyard_or_dropoff[i][j]) || (distance_closest[i][j] != distance_cell_shipyard_or_dropoff[i][j]))
+			{
+				log::log("Error: DistanceManager: closest dropoff of " + Position(j, i).to_string_position() + " is " + closest_shipyard_or_dropoff[i][j].to_string_position() + " instead of " + closest[i][j].to_string_position());
+				return;
+			}
 }
\ No newline at end of file
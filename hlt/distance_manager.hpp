@@ -2,6 +2,7 @@
 
 #include "position.hpp"
 #include "ship.hpp"
+#include "grid.hpp"
 
 #include <unordered_map>
 #include <utility>
@@ -14,17 +15,28 @@ namespace hlt
 	class DistanceManager
 	{
 		public:
-		vector<vector<Position>> closest_shipyard_or_dropoff;
-		vector<vector<int>> distance_cell_shipyard_or_dropoff;
+		Grid<Position> closest_shipyard_or_dropoff;
+		Grid<int> distance_cell_shipyard_or_dropoff;
+		// Distances from each of my shipyard and dropoffs, one plane each
+		Grid<int> distances;
+
+		static const int CHECK_PERIOD = 50;
 
 		DistanceManager() {}
 
 		void fill_closest_shipyard_or_dropoff(const Game& game);
 
+		// Compares with a distance grid per dropoff, logs the first difference
+		void check(const Game& game);
+
 		Position get_closest_shipyard_or_dropoff(const Position& position) const { return closest_shipyard_or_dropoff[position.y][position.x]; }
 		Position get_closest_shipyard_or_dropoff(shared_ptr<Ship> ship) const { return get_closest_shipyard_or_dropoff(ship->position); }
 
 		inline int get_distance_cell_shipyard_or_dropoff(const Position& position) const { return distance_cell_shipyard_or_dropoff[position.y][position.x]; }
 		inline int get_distance_cell_shipyard_or_dropoff(shared_ptr<Ship> ship) const { return get_distance_cell_shipyard_or_dropoff(ship->position); }
+
+		private:
+		void gather_bases(const Game& game, vector<Position>& base_or_dropoffs, vector<int>& enemies_around) const;
+		void fill_from_distance_grids(const Game& game, const vector<Position>& base_or_dropoffs, const vector<int>& enemies_around, Grid<Position>& closest, Grid<int>& distance_closest);
 	};
 }
\ No newline at end of file
@@ -9,10 +9,10 @@ namespace hlt
     struct Dropoff : Entity 
 	{
 		bool fake;
+		int last_seen_turn;
 
-		Dropoff(PlayerId owner, EntityId id, int x, int y) : Entity(owner, id, x, y), fake(false) {}
-		Dropoff(PlayerId owner, EntityId id, int x, int y, bool fake) : Entity(owner, id, x, y), fake(fake) {}
-        static std::shared_ptr<Dropoff> _generate(PlayerId player_id);
+		Dropoff(PlayerId owner, EntityId id, int x, int y) : Entity(owner, id, x, y), fake(false), last_seen_turn(-1) {}
+		Dropoff(PlayerId owner, EntityId id, int x, int y, bool fake) : Entity(owner, id, x, y), fake(fake), last_seen_turn(-1) {}
 
 		string to_string_dropoff() const { return "Dropoff(" + position.to_string_position() + ")"; }
     };
@@ -1,10 +1,10 @@
 #include "game.hpp"
 #include "input.hpp"
 
-#include <sstream>
 #include <ctime>
 #include <stdint.h>
 #include <algorithm>
+#include <thread>
 
 using namespace std;
 
@@ -14,11 +14,10 @@ hlt::Game::Game(unordered_map<string, int> constants) :
 {
     std::ios_base::sync_with_stdio(false);
 
-    hlt::constants::populate_constants(hlt::get_string());
+    hlt::constants::populate_constants(input::read_line());
 
-    int num_players;
-    std::stringstream input(get_string());
-    input >> num_players >> my_id;
+    int num_players = input::read_int();
+    my_id = input::read_int();
 
     log::open(my_id);
 
@@ -27,6 +26,7 @@ hlt::Game::Game(unordered_map<string, int> constants) :
     
     me = players[my_id];
     game_map = GameMap::_generate();
+    input::end_frame();
 
 	// My stuff
 	number_of_players = players.size();
@@ -40,8 +40,18 @@ hlt::Game::Game(unordered_map<string, int> constants) :
 	objective_manager = ObjectiveManager();
 	blocker = Blocker();
 
-	distance_manager.closest_shipyard_or_dropoff = vector<vector<Position>>(game_map->height, vector<Position>(game_map->width, Position()));
-	distance_manager.distance_cell_shipyard_or_dropoff = vector<vector<int>>(game_map->height, vector<int>(game_map->width, 0));
+	distance_manager.closest_shipyard_or_dropoff.resize(game_map->width, game_map->height);
+	distance_manager.distance_cell_shipyard_or_dropoff.resize(game_map->width, game_map->height);
+
+	// Workers for the turn tasks, none runs them serially
+	int worker_threads = min(get_constant("Worker Threads"), max((int)thread::hardware_concurrency() - 1, 0));
+	if (worker_threads > 0)
+		thread_pool = make_unique<ThreadPool>(worker_threads);
+	log::log("Turn tasks on " + to_string(worker_threads + 1) + " threads");
+
+	// Turn output, sized for a full fleet so that no allocation happens during the game
+	command_queue.reserve(512);
+	turn_output.reserve(8192);
 }
 
 void hlt::Game::ready(const std::string& name, unsigned int rng_seed)
@@ -55,42 +65,52 @@ void hlt::Game::update_frame()
 	Stopwatch s("Update Frame");
 
 	start = clock();
-    hlt::get_sstream() >> turn_number;
+	heap_allocations_at_start = allocation_counter::count();
+	Arena::turn().reset(); // scratch memory of the previous turn is gone from here
+    input::begin_frame();
+    turn_number = input::read_int();
     log::log("=============== TURN " + std::to_string(turn_number) + " ================");
 
 	// Any extra info in game, gamemap, mapcells, shipyard will stay over next turn
 
-	// Update players: get new halite, recreate all new ships & dropoffs
+	// Update players: get new halite, reconcile ships & dropoffs with the frame
+    game_map->ship_pool.begin_turn();
     for (size_t i = 0; i < players.size(); ++i) 
 	{
-        PlayerId current_player_id;
-        int num_ships;
-        int num_dropoffs;
-        Halite halite;
-        hlt::get_sstream() >> current_player_id >> num_ships >> num_dropoffs >> halite;
+        PlayerId current_player_id = input::read_int();
+        int num_ships = input::read_int();
+        int num_dropoffs = input::read_int();
+        Halite halite = input::read_int();
 
-        players[current_player_id]->_update(num_ships, num_dropoffs, halite);
+        players[current_player_id]->_update(num_ships, num_dropoffs, halite, turn_number, game_map->ship_pool);
     }
 
 	// Reset halite on each cell and empty cells
     game_map->_update();
+    input::end_frame();
+
+	// Map statistics follow the cells set by the frame
+	if (!map_statistics.initialized())
+		map_statistics.reset(*game_map);
+	else
+		map_statistics.apply(game_map->changes);
+	if (turn_number <= 1)
+		map_statistics.set_initial_total();
+#if HALITE_DEBUG
+	if (turn_number % MapStatistics::CHECK_PERIOD == 0)
+		map_statistics.check(*game_map);
+#endif
 
 	// Add ships, shipyard and dropoffs to cells
     for (const auto& player : players) 
 	{
         for (auto& ship_iterator : player->ships) 
-		{
-            auto ship = ship_iterator.second;
-            game_map->at(ship)->mark_unsafe(ship);
-        }
+            game_map->mark_unsafe(ship_iterator.second);
 
-        game_map->at(player->shipyard)->structure = player->shipyard; // Shipyard never flushed
+        game_map->mark_structure(*player->shipyard); // Shipyard never flushed
 
         for (auto& dropoff_iterator : player->dropoffs) 
-		{
-            auto dropoff = dropoff_iterator.second;
-            game_map->at(dropoff)->structure = dropoff;
-        }
+            game_map->mark_structure(*dropoff_iterator.second);
     }
 
 	command_queue.clear();
@@ -103,38 +123,35 @@ void hlt::Game::update_frame()
 	objective_manager.turn_since_last_dropoff++;
 	objective_manager.flush_objectives();
 
-	// Scorer
-	scorer.update_grids(*this);
-	scorer.halite_total = 0;
-	for (vector<MapCell>& row : game_map->cells)
-		for (MapCell& cell : row)
-			scorer.halite_total += cell.halite;
-	if (turn_number <= 1)
-		scorer.halite_initial = scorer.halite_total;
-
-	scorer.halite_percentile = 0;
-	int i = 0;
-	vector<int> halite_all = vector<int>(game_map->width * game_map->height, 0);
-	for (vector<MapCell>& row : game_map->cells)
-		for (MapCell& cell : row)
-			halite_all[i++] = cell.halite;
-	std::sort(halite_all.begin(), halite_all.end());
-	scorer.halite_percentile = halite_all[(int)(0.5 * game_map->width * game_map->height)];
-
-	// Distance manager
-	distance_manager.fill_closest_shipyard_or_dropoff(*this);
-
-	// Blocker
-	blocker.fill_positions_to_block_scores(*this);
+	// Scorer grids, distance manager and blocker
+	{
+		Stopwatch s("Updating grids");
+		scorer.begin_turn(*this);
+		frame_tasks.clear();
+		scorer.add_grid_tasks(frame_tasks, *this);
+		frame_tasks.add("distance_fields", [this]() { distance_fields.update(*this); });
+		frame_tasks.add("distance_manager", [this]() { distance_manager.fill_closest_shipyard_or_dropoff(*this); }, { "grid_score_move", "distance_fields" });
+		frame_tasks.add("blocker", [this]() { blocker.fill_positions_to_block_scores(*this); });
+		frame_tasks.run(thread_pool.get());
+		frame_tasks.log_timings();
+		scorer.grids.touch(GridSource::BASE_DISTANCES);
+	}
+#if HALITE_DEBUG
+	if (turn_number % DistanceFields::CHECK_PERIOD == 0)
+		distance_fields.check(*this);
+#endif
 }
 
 bool hlt::Game::end_turn(const std::vector<hlt::Command>& commands) 
 {
+    // Whole turn serialized in one buffer, sent with a single write and flush
+    turn_output.clear();
     for (const auto& command : commands) 
-	{
-        std::cout << command << ' ';
-    }
-    std::cout << std::endl;
+        command.append_to(turn_output);
+    turn_output.push_back('\n');
+
+    std::cout.write(turn_output.data(), turn_output.size());
+    std::cout.flush();
     return std::cout.good();
 }
 
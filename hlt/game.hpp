@@ -10,9 +10,14 @@
 #include "move_solver.hpp"
 #include "blocker.hpp"
 #include "distance_manager.hpp"
+#include "distance_fields.hpp"
 #include "objective_manager.hpp"
 #include "defines.hpp"
 #include "stopwatch.hpp"
+#include "arena.hpp"
+#include "small_vector.hpp"
+#include "task_graph.hpp"
+#include "map_statistics.hpp"
 
 #include <vector>
 #include <iostream>
@@ -40,17 +45,21 @@ namespace hlt
 
 		// For timer
 		clock_t start;
+		size_t heap_allocations_at_start;
 
 		// Movement management
 		CollisionResolver collision_resolver;
 		PathFinder pathfinder;
 		
-		unordered_map<shared_ptr<Ship>, Position> positions_next_turn;
+		ShipSlotMap<Position> positions_next_turn;
 		vector<Command> command_queue;
+		string turn_output; // serialized commands, reused every turn
 
 		// Scoring
 		Scorer scorer;
+		MapStatistics map_statistics;
 		DistanceManager distance_manager;
+		DistanceFields distance_fields;
 
 		// Move Solver
 		MoveSolver move_solver;
@@ -61,12 +70,17 @@ namespace hlt
 		// Blocker
 		Blocker blocker;
 
+		// Grid updates of the turn, run on the workers when there are any
+		unique_ptr<ThreadPool> thread_pool;
+		TaskGraph frame_tasks;
+
 		Game(unordered_map<string, int> constants);
 
 		void resolve_moves()
 		{
 			Stopwatch s("Collising Resolve");
-			command_queue = collision_resolver.resolve_moves(*this);
+			command_queue.clear();
+			collision_resolver.resolve_moves(*this);
 		}
 
 		void assign_ship_to_target_position(shared_ptr<Ship> ship, const Position& position)
@@ -120,7 +134,7 @@ namespace hlt
 				exit(1);
 			}
 
-			return ((double)scorer.halite_total / (double)total_ships_number() >= limit);
+			return ((double)map_statistics.total() / (double)total_ships_number() >= limit);
 		}
 
 		void generate_new_ships()
@@ -160,11 +174,11 @@ namespace hlt
 
 			if (players.size() == 2)
 			{
-				max_allowed_ships = min(150, (int)(20.0 + 0.00015 * (double)scorer.halite_initial));
+				max_allowed_ships = min(150, (int)(20.0 + 0.00015 * (double)map_statistics.initial_total()));
 			}
 			else if (players.size() == 4)
 			{
-				max_allowed_ships = min(150, (int)(20.0 + 0.0001 * (double)scorer.halite_initial));
+				max_allowed_ships = min(150, (int)(20.0 + 0.0001 * (double)map_statistics.initial_total()));
 
 				if (game_map->width == 32)
 					max_allowed_ships = (int)(0.8 * max_allowed_ships) + 1;
@@ -190,45 +204,40 @@ namespace hlt
 		inline MapCell* mapcell(int x, int y) const { return game_map->at(y, x); }
 		inline bool enemy_in_cell(const MapCell& cell) const { return cell.is_occupied_by_enemy(my_id); }
 		inline bool enemy_in_cell(const Position& position) const { return game_map->at(position)->is_occupied_by_enemy(my_id); }
-		inline bool enemy_dropoff_in_cell(const Position& position) const { return game_map->at(position)->has_structure() && (game_map->at(position)->structure->owner != my_id); }
+		inline bool enemy_dropoff_in_cell(const Position& position) const { return game_map->at(position)->has_structure() && (game_map->at(position)->structure_owner != my_id); }
 		bool enemy_in_adjacent_cell(const Position& position) const
 		{
-			return
-				game_map->at(game_map->directional_offset(position, Direction::NORTH))->is_occupied_by_enemy(my_id) ||
-				game_map->at(game_map->directional_offset(position, Direction::SOUTH))->is_occupied_by_enemy(my_id) ||
-				game_map->at(game_map->directional_offset(position, Direction::EAST))->is_occupied_by_enemy(my_id) ||
-				game_map->at(game_map->directional_offset(position, Direction::WEST))->is_occupied_by_enemy(my_id) ||
-				game_map->at(position)->is_occupied_by_enemy(my_id);
+			MapCell* cell = game_map->at(position);
+
+			for (Direction direction : ALL_CARDINALS)
+				if (game_map->neighbor(cell, direction)->is_occupied_by_enemy(my_id))
+					return true;
+
+			return false;
 		}
 		inline bool ally_in_cell(const Position& position) const { return game_map->at(position)->is_occupied_by_ally(my_id); }
 		inline int halite_on_position(const Position& position) const { return mapcell(position)->halite; }
 		inline bool position_has_ship(const Position& position) const { return mapcell(position)->is_occupied(); }
-		inline shared_ptr<Ship> ship_on_position(const Position& position) const { return mapcell(position)->ship; }
-		PlayerId playerid_on_position(const Position& position) const { return mapcell(position)->ship->owner; }
-		vector<shared_ptr<Ship>> enemies_adjacent_to_position(const Position& position) const
+		inline shared_ptr<Ship> ship_on_position(const Position& position) const { return game_map->ship_in_cell(mapcell(position)); }
+		PlayerId playerid_on_position(const Position& position) const { return mapcell(position)->ship_owner; }
+		SmallVector<shared_ptr<Ship>, 5> enemies_adjacent_to_position(const Position& position) const
 		{
-			vector<shared_ptr<Ship>> enemies;
-
-			if (game_map->at(game_map->directional_offset(position, Direction::NORTH))->is_occupied_by_enemy(my_id))
-				enemies.push_back(ship_on_position(game_map->directional_offset(position, Direction::NORTH)));
-
-			if (game_map->at(game_map->directional_offset(position, Direction::SOUTH))->is_occupied_by_enemy(my_id))
-				enemies.push_back(ship_on_position(game_map->directional_offset(position, Direction::SOUTH)));
+			SmallVector<shared_ptr<Ship>, 5> enemies;
+			MapCell* cell = game_map->at(position);
 
-			if (game_map->at(game_map->directional_offset(position, Direction::EAST))->is_occupied_by_enemy(my_id))
-				enemies.push_back(ship_on_position(game_map->directional_offset(position, Direction::EAST)));
-
-			if (game_map->at(game_map->directional_offset(position, Direction::WEST))->is_occupied_by_enemy(my_id))
-				enemies.push_back(ship_on_position(game_map->directional_offset(position, Direction::WEST)));
-
-			if (game_map->at(position)->is_occupied_by_enemy(my_id))
-				enemies.push_back(ship_on_position(position));
+			// North, south, east, west then the cell itself
+			for (Direction direction : ALL_CARDINALS)
+			{
+				MapCell* neighbor = game_map->neighbor(cell, direction);
+				if (neighbor->is_occupied_by_enemy(my_id))
+					enemies.push_back(game_map->ship_in_cell(neighbor));
+			}
 
 			return enemies;
 		}
-		vector<Position> adjacent_positions_to_position(const Position& position) const
+		SmallVector<Position, 4> adjacent_positions_to_position(const Position& position) const
 		{
-			vector<Position> positions;
+			SmallVector<Position, 4> positions;
 
 			positions.push_back(game_map->directional_offset(position, Direction::NORTH));
 			positions.push_back(game_map->directional_offset(position, Direction::SOUTH));
@@ -237,31 +246,17 @@ namespace hlt
 
 			return positions;
 		}
-		vector<Position> nearby_positions_to_position(const Position& position, int d) const
+		ArenaVector<Position> nearby_positions_to_position(const Position& position, int d) const
 		{
-			vector<Position> positions;
-
-			int width = game_map->width;
-			int height = game_map->height;
-
-			int target_x = position.x;
-			int target_y = position.y;
+			ArenaVector<Position> positions;
 
-			for (int i = 0; i <= d * 2; ++i)
-				for (int j = 0; j <= d * 2; ++j)
-				{
-					int new_x = (((target_x - d + i) % width) + width) % width;
-					int new_y = (((target_y - d + j) % height) + height) % height;
-					Position new_position = Position(new_x, new_y);
-
-					if (distance(position, new_position) <= d)
-						positions.push_back(new_position);
-				}
+			for (const WrappedCell& cell : game_map->wrap.diamond(position.x, position.y, d))
+				positions.push_back(Position(cell.x, cell.y));
 
 			return positions;
 		}
 
-		inline int get_constant(string name) const { return constants.at(name); }
+		inline int get_constant(const string& name) const { return constants.at(name); }
 		inline double turn_percent() const { return (double)turn_number / (double)constants::MAX_TURNS; }
 		inline double turns_remaining_percent() const { return (double)(constants::MAX_TURNS - turn_number) / (double)constants::MAX_TURNS; }
 		inline int turns_remaining() const { return constants::MAX_TURNS - turn_number; }
@@ -301,7 +296,7 @@ namespace hlt
 			
 			return positions;
 		}
-		shared_ptr<Ship> ship_on_shipyard() const { return game_map->at(my_shipyard_position())->ship; }
+		shared_ptr<Ship> ship_on_shipyard() const { return ship_on_position(my_shipyard_position()); }
 		Position get_closest_shipyard_or_dropoff(shared_ptr<Ship> ship, bool with_fakes = true) const
 		{
 			return get_closest_shipyard_or_dropoff(ship->position, with_fakes);
@@ -329,22 +324,9 @@ namespace hlt
 		}
 		Position get_closest_enemy_shipyard_or_dropoff(const Position& position) const
 		{
-			int min_distance = INT_MAX;
-			Position closest_shipyard = my_shipyard_position();
-			vector<Position> enemy_positions = enemy_shipyard_or_dropoff_positions();
-
-			for (auto& enemy_position : enemy_positions)
-			{
-				int distance = game_map->calculate_distance(position, enemy_position);
-
-				if (distance <= min_distance)
-				{
-					min_distance = distance;
-					closest_shipyard = enemy_position;
-				}
-			}
-
-			return closest_shipyard;
+			if (!distance_fields.has_enemy_structure(my_id))
+				return my_shipyard_position();
+			return distance_fields.closest_enemy_structure(my_id, position);
 		}
 		Position get_closest_enemy_shipyard_or_dropoff(shared_ptr<Ship> ship) const { return get_closest_enemy_shipyard_or_dropoff(ship->position); }
 		bool is_shipyard_or_dropoff(const Position& position) const { return mapcell(position)->is_shipyard_or_dropoff(my_id); }
@@ -417,7 +399,7 @@ namespace hlt
 
 			return is_four_player_game() &&
 				(turns_remaining_percent() <= 0.5) &&
-				(scorer.halite_total <= (int)limit) &&
+				(map_statistics.total() <= (int)limit) &&
 				(scorer.get_grid_score_extract_nearby(ship->position) <= 300);
 		}
 
@@ -441,10 +423,9 @@ namespace hlt
 
 			// Log all enemys ships
 			//log::log("Enemy ships:");
-			//for (vector<MapCell>& row : game_map->cells)
-			//	for (MapCell& cell : row)
-			//		if (cell.is_occupied_by_enemy(me->id))
-			//			log::log(cell.ship->to_string_ship());
+			//for (MapCell& cell : game_map->cells)
+			//	if (cell.is_occupied_by_enemy(me->id))
+			//		log::log(game_map->ship_in_cell(&cell)->to_string_ship());
 
 			//log::log("");
 		}
@@ -452,8 +433,10 @@ namespace hlt
 		{
 			log::log("END TURN");
 			log::log("Total ships: " + to_string(my_ships_number()));
-			log::log("Total halite: " + to_string(scorer.halite_total));
-			log::log("50th pctl halite: " + to_string(scorer.halite_percentile));
+			log::log("Total halite: " + to_string(map_statistics.total()));
+			log::log("50th pctl halite: " + to_string(map_statistics.percentile(0.5)));
+			scorer.combat_cache.log_stats();
+			scorer.grids.log_stats();
 		
 			// Log all predicted direction
 			for (auto& ship_position : positions_next_turn)
@@ -464,6 +447,8 @@ namespace hlt
 			//	log::log(command);
 
 			log::log("Time taken: " + to_string((clock() - start) / (double)CLOCKS_PER_SEC));
+			log::log("Turn arena: " + to_string(Arena::turn().peak_bytes_used()) + " bytes at most in " + to_string(Arena::turn().allocation_count()) + " allocations" +
+				(allocation_counter::enabled() ? ", heap allocations: " + to_string(allocation_counter::count() - heap_allocations_at_start) : ""));
 			log::log("");
 		}
 
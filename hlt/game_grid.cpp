@@ -11,7 +11,7 @@ Position GameGrid::compute_shortest_path(const Position& source_position, const
 	MapCell* source_cell = game.game_map->at(source_position);
 	MapCell* target_cell = game.game_map->at(target_position);
 
-	//log::log("Source: " + source_cell->position.to_string_position() + ", Target: " + target_cell->position.to_string_position());
+	//log::log("Source: " + game.game_map->position(source_cell).to_string_position() + ", Target: " + game.game_map->position(target_cell).to_string_position());
 
 	clock_t start = clock();
 	list<Position> optimal_path = dijkstra(source_cell, target_cell, game);
@@ -23,7 +23,7 @@ Position GameGrid::compute_shortest_path(const Position& source_position, const
 	if (optimal_path.size() > 1)
 		return *(next(optimal_path.begin()));
 	else
-		return source_cell->position;
+		return game.game_map->position(source_cell);
 }
 
 MapCell* GameGrid::get_lowest_distance_cell(const list<MapCell*>& unsettled_cells, const list<MapCell*>& settled_cells, const Game& game)
@@ -39,7 +39,7 @@ MapCell* GameGrid::get_lowest_distance_cell(const list<MapCell*>& unsettled_cell
 	{
 		for (MapCell* unsettled_cell : unsettled_cells)
 		{
-			int distance = game.game_map->calculate_distance(unsettled_cell->position, settled_cell->position);
+			int distance = game.game_map->calculate_distance(game.game_map->position(unsettled_cell), game.game_map->position(settled_cell));
 			if (distance < closest_distance)
 			{
 				closest_distance = distance;
@@ -55,10 +55,8 @@ vector<MapCell*> GameGrid::adjacent_cells(MapCell* cell, const Game& game)
 {
 	vector<MapCell*> adjacent_cells;
 
-	adjacent_cells.push_back(game.game_map->at(game.game_map->directional_offset(cell->position, Direction::NORTH)));
-	adjacent_cells.push_back(game.game_map->at(game.game_map->directional_offset(cell->position, Direction::SOUTH)));
-	adjacent_cells.push_back(game.game_map->at(game.game_map->directional_offset(cell->position, Direction::EAST)));
-	adjacent_cells.push_back(game.game_map->at(game.game_map->directional_offset(cell->position, Direction::WEST)));
+	for (int index : game.game_map->wrap.neighbors_of(game.game_map->index(cell)))
+		adjacent_cells.push_back(game.game_map->cell(index));
 
 	return adjacent_cells;
 }
@@ -73,7 +71,7 @@ list<Position> GameGrid::dijkstra(MapCell* source_cell, MapCell* target_cell, co
 
 	// The output array. distances[i] will hold the shortest distance from source to i 
 	vector<int> distances(N, INT_MAX);
-	distances[to_index(source_cell)] = 0;
+	distances[to_index(game.game_map->position(source_cell))] = 0;
 
 	// settled_positions[i] = true if vertex i is included in shortest path tree or shortest distance from src to i is finalized 
 	list<MapCell*> unsettled_cells;
@@ -90,21 +88,21 @@ list<Position> GameGrid::dijkstra(MapCell* source_cell, MapCell* target_cell, co
 		MapCell* current_cell = get_lowest_distance_cell(unsettled_cells, settled_cells, game);
 
 		// If current cell is the target, return it's path
-		if (current_cell->position == target_cell->position)
+		if (current_cell == target_cell)
 		{
-			shortest_path[to_index(target_cell)].push_back(target_cell->position);
-			return shortest_path[to_index(target_cell)];
+			shortest_path[to_index(game.game_map->position(target_cell))].push_back(game.game_map->position(target_cell));
+			return shortest_path[to_index(game.game_map->position(target_cell))];
 		}
 
 		unsettled_cells.remove(current_cell);
-		int index_current = to_index(current_cell);
+		int index_current = to_index(game.game_map->position(current_cell));
 
-		//log::log("Current cell:" + current_cell->position.to_string_position());
-		//log::log("Target cell:" + target_cell->position.to_string_position());
+		//log::log("Current cell:" + game.game_map->position(current_cell).to_string_position());
+		//log::log("Target cell:" + game.game_map->position(target_cell).to_string_position());
 
 		for (MapCell* adjacent_cell : adjacent_cells(current_cell, game))
 		{
-			int index_adjacent = to_index(adjacent_cell);
+			int index_adjacent = to_index(game.game_map->position(adjacent_cell));
 
 			if (find(settled_cells.begin(), settled_cells.end(), adjacent_cell) == settled_cells.end())
 			{
@@ -112,13 +110,13 @@ list<Position> GameGrid::dijkstra(MapCell* source_cell, MapCell* target_cell, co
 				int adjacent_distance = distances[index_adjacent];
 				int edge_weight       = (int)ceil(0.1 * current_cell->halite);
 
-				//log::log("Adjacent: " + adjacent_cell->position.to_string_position() + ": " + to_string(source_distance) + ", " + to_string(adjacent_distance) + ", " + to_string(edge_weight));
+				//log::log("Adjacent: " + game.game_map->position(adjacent_cell).to_string_position() + ": " + to_string(source_distance) + ", " + to_string(adjacent_distance) + ", " + to_string(edge_weight));
 
 				if (source_distance + edge_weight < adjacent_distance)
 				{
 					distances[index_adjacent] = source_distance + edge_weight;
 					shortest_path[index_adjacent] = shortest_path[index_current];
-					shortest_path[index_adjacent].push_back(current_cell->position);
+					shortest_path[index_adjacent].push_back(game.game_map->position(current_cell));
 				}
 
 				unsettled_cells.push_back(adjacent_cell);
@@ -128,15 +126,15 @@ list<Position> GameGrid::dijkstra(MapCell* source_cell, MapCell* target_cell, co
 
 		//log::log("Settled: ");
 		//for (MapCell* pos : settled_cells)
-		//	log::log(pos->position.to_string_position());
+		//	log::log(game.game_map->position(pos).to_string_position());
 
 		//log::log("Unsettled: ");
 		//for (MapCell* pos : unsettled_cells)
-		//	log::log(pos->position.to_string_position());
+		//	log::log(game.game_map->position(pos).to_string_position());
 
 		//if (shortest_path[index_current].size())
 		//{
-		//	log::log("Shortest path of " + current_cell->position.to_string_position());
+		//	log::log("Shortest path of " + game.game_map->position(current_cell).to_string_position());
 		//	for (Position& pos : shortest_path[index_current])
 		//		log::log(pos.to_string_position());
 		//}
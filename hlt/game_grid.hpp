@@ -25,7 +25,7 @@ namespace hlt
 		GameGrid() : width(0) {}
 		GameGrid(int width) : width(width) {}
 
-		int to_index(MapCell* cell) const { return cell->position.x * width + cell->position.y; }
+		int to_index(const Position& position) const { return position.x * width + position.y; }
 
 		// Dijkstra
 		public:
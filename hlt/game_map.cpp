@@ -11,20 +11,20 @@ using namespace std;
 
 void GameMap::_update()
 {
-    for (int y = 0; y < height; ++y) 
-		for (int x = 0; x < width; ++x)
-			cells[y][x].ship.reset();
+    for (MapCell& cell : cells)
+        cell.flush_ship();
 
-    int update_count;
-    get_sstream() >> update_count;
+    int update_count = input::read_int();
+    changes.clear();
 
     for (int i = 0; i < update_count; ++i) 
 	{
-        int x;
-        int y;
-        int halite;
-        get_sstream() >> x >> y >> halite;
-        cells[y][x].halite = halite;
+        int x = input::read_int();
+        int y = input::read_int();
+        MapCell* updated = cell(x, y);
+        uint16_t previous = updated->halite;
+        updated->halite = (uint16_t)input::read_int();
+        changes.push_back({ index(updated), previous, updated->halite });
     }
 }
 
@@ -32,23 +32,13 @@ unique_ptr<GameMap> GameMap::_generate()
 {
     unique_ptr<GameMap> map = make_unique<GameMap>();
 
-    get_sstream() >> map->width >> map->height;
-    map->cells.resize((size_t)map->height);
+    map->width = input::read_int();
+    map->height = input::read_int();
+    map->wrap = WrapTable(map->width, map->height);
+    map->cells.reserve((size_t)(map->width * map->height));
 
-    for (int y = 0; y < map->height; ++y) 
-	{
-        auto in = get_sstream();
-
-        map->cells[y].reserve((size_t)map->width);
-
-        for (int x = 0; x < map->width; ++x) 
-		{
-            Halite halite;
-            in >> halite;
-
-            map->cells[y].push_back(MapCell(x, y, halite));
-        }
-    }
+    for (int i = 0; i < map->width * map->height; ++i)
+        map->cells.push_back(MapCell(input::read_int()));
 
     return map;
 }
@@ -3,6 +3,9 @@
 #include "types.hpp"
 #include "map_cell.hpp"
 #include "constants.hpp"
+#include "wrap_table.hpp"
+#include "ship_pool.hpp"
+#include "small_vector.hpp"
 
 #include <vector>
 #include <math.h>
@@ -12,22 +15,56 @@ using namespace std;
 namespace hlt 
 {
 	struct Game;
+
+	// Halite of a cell set by a frame, previous is its halite before that line of the frame
+	struct CellChange
+	{
+		int index;
+		uint16_t previous;
+		uint16_t halite;
+	};
+
 	struct GameMap
 	{
 		int width;
 		int height;
-		vector<vector<MapCell>> cells;
+		vector<MapCell> cells; // row-major, cell (x, y) is cells[y * width + x]
+		ShipPool ship_pool; // ships of all players, MapCell::ship is a slot of the pool
+		vector<CellChange> changes; // cells set by the last _update, in frame order
+		WrapTable wrap;
 
-		inline MapCell* at(const Position& position)
+		inline int index(const Position& position) const
 		{
 			Position normalized = normalize(position);
-			return &cells[normalized.y][normalized.x];
+			return normalized.y * width + normalized.x;
 		}
-		inline MapCell* at(int x, int y) { return at(normalize(Position(x, y))); }
+		inline MapCell* at(const Position& position) { return &cells[index(position)]; }
+		inline MapCell* at(int x, int y) { return at(Position(x, y)); }
 		inline MapCell* at(const Entity& entity) { return at(entity.position); }
 		inline MapCell* at(const Entity* entity) { return at(entity->position); }
 		inline MapCell* at(const shared_ptr<Entity>& entity) { return at(entity->position); }
 
+		// Unchecked accessors, coordinates must already be on the map
+		inline MapCell* cell(int x, int y) { return &cells[y * width + x]; }
+		inline MapCell* cell(int index) { return &cells[index]; }
+
+		inline int index(const MapCell* cell) const { return (int)(cell - cells.data()); }
+		inline MapCell* neighbor(const MapCell* cell, Direction d) { return &cells[wrap.neighbor(index(cell), d)]; }
+		inline Position position(const MapCell* cell) const
+		{
+			int i = index(cell);
+			return Position(i % width, i / width);
+		}
+		inline shared_ptr<Ship> ship_in_cell(const MapCell* cell) const { return cell->is_occupied() ? ship_pool.at(cell->ship) : shared_ptr<Ship>(); }
+
+		void mark_unsafe(const shared_ptr<Ship>& ship)
+		{
+			MapCell* cell = at(ship->position);
+			cell->ship = (uint16_t)ship->slot;
+			cell->ship_owner = (int8_t)ship->owner;
+		}
+		void mark_structure(const Entity& structure) { at(structure.position)->structure_owner = (int8_t)structure.owner; }
+
 		Position directional_offset(const Position& position, Direction d) const
 		{
 			int dx = 0;
@@ -53,17 +90,12 @@ namespace hlt
 				exit(1);
 			}
 
-			int new_x = position.x + dx;
-			int new_y = position.y + dy;
-
-			return Position(((new_x % width) + width) % width, ((new_y % height) + height) % height);
+			return Position(wrap.wrap_x(position.x + dx), wrap.wrap_y(position.y + dy));
 		}
 
 		Position normalize(const Position& position) const
 		{
-			const int x = ((position.x % width) + width) % width;
-			const int y = ((position.y % height) + height) % height;
-			return { x, y };
+			return { wrap.wrap_x(position.x), wrap.wrap_y(position.y) };
 		}
 
 		inline int calculate_distance(const Position& source, const Position& target) const
@@ -71,10 +103,7 @@ namespace hlt
 			const auto& normalized_source = normalize(source);
 			const auto& normalized_target = normalize(target);
 
-			const int dx = abs(normalized_source.x - normalized_target.x);
-			const int dy = abs(normalized_source.y - normalized_target.y);
-
-			return min(dx, width - dx) + min(dy, height - dy);
+			return wrap.distance(normalized_source.x, normalized_source.y, normalized_target.x, normalized_target.y);
 		}
 
 		int calculate_distance_inf(const Position& source, const Position& target) const
@@ -82,13 +111,7 @@ namespace hlt
 			const auto& normalized_source = normalize(source);
 			const auto& normalized_target = normalize(target);
 
-			const int dx = abs(normalized_source.x - normalized_target.x);
-			const int dy = abs(normalized_source.y - normalized_target.y);
-
-			const int toroidal_dx = min(dx, width - dx);
-			const int toroidal_dy = min(dy, height - dy);
-
-			return max(toroidal_dx, toroidal_dy);
+			return max(wrap.distance_x(normalized_source.x, normalized_target.x), wrap.distance_y(normalized_source.y, normalized_target.y));
 		}
 
 		int calculate_distance_from_axis(const Position& source, const Position& target) const
@@ -96,13 +119,7 @@ namespace hlt
 			const auto& normalized_source = normalize(source);
 			const auto& normalized_target = normalize(target);
 
-			const int dx = abs(normalized_source.x - normalized_target.x);
-			const int dy = abs(normalized_source.y - normalized_target.y);
-
-			const int toroidal_dx = min(dx, width - dx);
-			const int toroidal_dy = min(dy, height - dy);
-
-			return min(toroidal_dx, toroidal_dy);
+			return min(wrap.distance_x(normalized_source.x, normalized_target.x), wrap.distance_y(normalized_source.y, normalized_target.y));
 		}
 
 		Direction get_move(const Position& source, const Position& destination)
@@ -127,7 +144,7 @@ namespace hlt
 			return Direction::STILL;
 		}
 
-		vector<Direction> get_unsafe_moves(const Position& source, const Position& destination)
+		SmallVector<Direction, 2> get_unsafe_moves(const Position& source, const Position& destination)
 		{
 			const auto& normalized_source = normalize(source);
 			const auto& normalized_destination = normalize(destination);
@@ -137,7 +154,7 @@ namespace hlt
 			const int wrapped_dx = width - dx;
 			const int wrapped_dy = height - dy;
 
-			vector<Direction> possible_moves;
+			SmallVector<Direction, 2> possible_moves;
 
 			if ((normalized_source.x == normalized_destination.x) && (normalized_source.y == normalized_destination.y))
 			{
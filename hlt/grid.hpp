@@ -0,0 +1,211 @@
+#pragma once
+
+#include "position.hpp"
+
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+using namespace std;
+
+namespace hlt
+{
+	// Cell on the torus of width * height cells, from coordinates anywhere
+	static inline int wrapped_index(int x, int y, int width, int height)
+	{
+		x %= width;
+		y %= height;
+		return (y + ((y < 0) ? height : 0)) * width + x + ((x < 0) ? width : 0);
+	}
+
+	// Contiguous cells of a grid row, for loops the compiler vectorizes
+	template <typename T>
+	class GridRow
+	{
+	public:
+		GridRow(T* values, int width) : values(values), width(width) {}
+
+		inline T& operator[](int x) const { return values[x]; }
+		inline T* data() const { return values; }
+		inline int size() const { return width; }
+		inline T* begin() const { return values; }
+		inline T* end() const { return values + width; }
+
+	private:
+		T* values;
+		int width;
+	};
+
+	/*
+	One plane of a Grid: width * height cells, row-major, flat indexes as the WrapTable ones.
+	A view does not own its cells, copies of a view are the same cells.
+	*/
+	template <typename T>
+	class GridView
+	{
+	public:
+		GridView() : width(0), height(0), values(nullptr) {}
+		GridView(T* values, int width, int height) : width(width), height(height), values(values) {}
+
+		inline GridRow<T> operator[](int y) const { return GridRow<T>(values + y * width, width); }
+		inline T* data() const { return values; }
+		inline int size() const { return width * height; }
+
+		// Coordinates anywhere on the torus
+		inline int index(int x, int y) const { return wrapped_index(x, y, width, height); }
+		inline T& at(int x, int y) const { return values[index(x, y)]; }
+		inline T& at(const Position& position) const { return values[index(position.x, position.y)]; }
+
+		void fill(const T& value) const { std::fill(values, values + size(), value); }
+		template <typename R, typename Op>
+		R reduce(R init, Op op) const
+		{
+			for (int i = 0; i < size(); ++i)
+				init = op(init, values[i]);
+			return init;
+		}
+
+		int width;
+		int height;
+
+	private:
+		T* values;
+	};
+
+	/*
+	Flat width * height grid in a single allocation aligned on ALIGNMENT bytes, replacing the
+	vector<vector<T>> planes: grid[y][x] reads the same, rows are contiguous and whole grids
+	copy, fill and compare in one pass.
+
+	A grid may stack several planes of the same size, each starting on an ALIGNMENT boundary,
+	so that related planes share the allocation. Indexing a grid is indexing its first plane.
+	Resizing keeps the allocation when it is large enough and sets every cell.
+	*/
+	template <typename T>
+	class Grid
+	{
+	public:
+		static const int ALIGNMENT = 64;
+		static_assert(ALIGNMENT % sizeof(T) == 0, "Planes start on an ALIGNMENT boundary");
+		static_assert(is_trivially_destructible<T>::value, "Grid cells are never destroyed");
+
+		Grid() : width(0), height(0), planes(0), plane_stride(0), capacity(0), values(nullptr) {}
+		Grid(int width, int height, int planes = 1, const T& value = T()) : Grid() { resize(width, height, planes, value); }
+		Grid(const Grid& other) : Grid() { *this = other; }
+		Grid(Grid&& other) noexcept : Grid() { swap(other); }
+		Grid& operator=(const Grid& other)
+		{
+			if (this != &other)
+			{
+				reshape(other.width, other.height, other.planes);
+				std::copy(other.values, other.values + planes * plane_stride, values);
+			}
+			return *this;
+		}
+		Grid& operator=(Grid&& other) noexcept
+		{
+			swap(other);
+			return *this;
+		}
+
+		void resize(int new_width, int new_height, int new_planes = 1, const T& value = T())
+		{
+			reshape(new_width, new_height, new_planes);
+			std::fill(values, values + planes * plane_stride, value);
+		}
+
+		inline GridRow<T> operator[](int y) { return GridRow<T>(values + y * width, width); }
+		inline GridRow<const T> operator[](int y) const { return GridRow<const T>(values + y * width, width); }
+		inline T* data(int plane = 0) { return values + plane * plane_stride; }
+		inline const T* data(int plane = 0) const { return values + plane * plane_stride; }
+		inline GridView<T> plane(int plane) { return GridView<T>(data(plane), width, height); }
+		inline GridView<const T> plane(int plane) const { return GridView<const T>(data(plane), width, height); }
+
+		// Cells of a plane and number of planes
+		inline int size() const { return width * height; }
+		inline int plane_count() const { return planes; }
+		// Bytes held by the grid, alignment included
+		inline size_t memory_bytes() const { return capacity ? capacity * sizeof(T) + ALIGNMENT : 0; }
+
+		// Coordinates anywhere on the torus
+		inline int index(int x, int y) const { return wrapped_index(x, y, width, height); }
+		inline T& at(int x, int y, int plane = 0) { return data(plane)[index(x, y)]; }
+		inline const T& at(int x, int y, int plane = 0) const { return data(plane)[index(x, y)]; }
+		inline T& at(const Position& position, int plane = 0) { return at(position.x, position.y, plane); }
+		inline const T& at(const Position& position, int plane = 0) const { return at(position.x, position.y, plane); }
+
+		// Every plane
+		void fill(const T& value) { std::fill(values, values + planes * plane_stride, value); }
+		// First plane
+		template <typename R, typename Op>
+		R reduce(R init, Op op) const { return plane(0).reduce(init, op); }
+		T sum() const { return reduce(T(), [](const T& total, const T& value) { return total + value; }); }
+		T max_value() const { return reduce(values[0], [](const T& best, const T& value) { return max(best, value); }); }
+
+		bool operator==(const Grid& other) const
+		{
+			if ((width != other.width) || (height != other.height) || (planes != other.planes))
+				return false;
+			for (int plane = 0; plane < planes; ++plane)
+				if (!equal(data(plane), data(plane) + size(), other.data(plane)))
+					return false;
+			return true;
+		}
+		bool operator!=(const Grid& other) const { return !(*this == other); }
+		// Same shape and every cell within tolerance * max(1, |value|) of the other, for grids of floating point sums
+		bool nearly_equal(const Grid& other, double tolerance) const
+		{
+			if ((width != other.width) || (height != other.height) || (planes != other.planes))
+				return false;
+			for (int plane = 0; plane < planes; ++plane)
+				for (int index = 0; index < size(); ++index)
+				{
+					double value = (double)data(plane)[index], other_value = (double)other.data(plane)[index];
+					if (fabs(value - other_value) > tolerance * max(1.0, max(fabs(value), fabs(other_value))))
+						return false;
+				}
+			return true;
+		}
+
+		int width;
+		int height;
+
+	private:
+		int planes;
+		int plane_stride; // cells from one plane to the next, a multiple of ALIGNMENT bytes
+		int capacity;
+		unique_ptr<char[]> buffer;
+		T* values;
+
+		// New dimensions, values of the cells are left as they are
+		void reshape(int new_width, int new_height, int new_planes)
+		{
+			width = new_width;
+			height = new_height;
+			planes = new_planes;
+			plane_stride = (int)((width * height * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT / sizeof(T));
+			if (planes * plane_stride <= capacity)
+				return;
+
+			capacity = planes * plane_stride;
+			buffer.reset(new char[capacity * sizeof(T) + ALIGNMENT]);
+			uintptr_t address = reinterpret_cast<uintptr_t>(buffer.get());
+			values = reinterpret_cast<T*>((address + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+			uninitialized_fill(values, values + capacity, T());
+		}
+
+		void swap(Grid& other)
+		{
+			std::swap(width, other.width);
+			std::swap(height, other.height);
+			std::swap(planes, other.planes);
+			std::swap(plane_stride, other.plane_stride);
+			std::swap(capacity, other.capacity);
+			buffer.swap(other.buffer);
+			std::swap(values, other.values);
+		}
+	};
+}
@@ -0,0 +1,403 @@
+#include "grid_kernels.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define HLT_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HLT_TARGET_AVX2
+#else
+#define HLT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define HLT_KERNELS_X86 0
+#endif
+
+using namespace hlt;
+using namespace std;
+
+using kernels::Isa;
+
+static bool cpu_has_avx2()
+{
+#if HLT_KERNELS_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+	if (!os_saves_avx)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+#else
+	return false;
+#endif
+}
+
+static Isa current_isa = cpu_has_avx2() ? Isa::AVX2 : Isa::SCALAR;
+
+#if HLT_KERNELS_X86
+#define AVX2_DISPATCH(call) if (current_isa == Isa::AVX2) { call; return; }
+#else
+#define AVX2_DISPATCH(call)
+#endif
+
+Isa kernels::isa()
+{
+	return current_isa;
+}
+
+bool kernels::set_isa(Isa isa)
+{
+	if ((isa == Isa::AVX2) && !cpu_has_avx2())
+		return false;
+
+	current_isa = isa;
+	return true;
+}
+
+const char* kernels::isa_name(Isa isa)
+{
+	return (isa == Isa::AVX2) ? "avx2" : "scalar";
+}
+
+PiecewiseLinear::PiecewiseLinear(const vector<double>& knots_x, const vector<double>& knots_y) : segments((int)knots_x.size() - 1), y0((float)knots_y[0])
+{
+	if ((knots_x.size() != knots_y.size()) || (segments < 1) || (segments > MAX_SEGMENTS))
+	{
+		log::log("Error: PiecewiseLinear: needs 2 to " + to_string(MAX_SEGMENTS + 1) + " knots");
+		exit(1);
+	}
+
+	for (int k = 0; k < segments; ++k)
+	{
+		if (knots_x[k + 1] <= knots_x[k])
+		{
+			log::log("Error: PiecewiseLinear: knots must be increasing");
+			exit(1);
+		}
+
+		x[k] = (float)knots_x[k];
+		inverse_dx[k] = (float)(1.0 / (knots_x[k + 1] - knots_x[k]));
+		dy[k] = (float)(knots_y[k + 1] - knots_y[k]);
+	}
+}
+
+PiecewiseLinear PiecewiseLinear::butterfly(double x_min, double x_mid, double x_max, double y_min, double y_mid, double y_max)
+{
+	return PiecewiseLinear({ x_min, x_mid, x_max }, { y_min, y_mid, y_max });
+}
+
+PiecewiseLinear PiecewiseLinear::strangle(double x_min, double x_mid1, double x_mid2, double x_max, double y_min, double y_mid1, double y_mid2, double y_max)
+{
+	return PiecewiseLinear({ x_min, x_mid1, x_mid2, x_max }, { y_min, y_mid1, y_mid2, y_max });
+}
+
+#if HLT_KERNELS_X86
+namespace avx2
+{
+	// Mask lanes of 8 int16 mask cells: all ones where the cell is 0
+	HLT_TARGET_AVX2 static inline __m256 mask_is_zero(const int16_t* mask)
+	{
+		__m256i wide = _mm256_cvtepi16_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(mask)));
+		return _mm256_castsi256_ps(_mm256_cmpeq_epi32(wide, _mm256_setzero_si256()));
+	}
+
+	HLT_TARGET_AVX2 static int load(float* out, const int* values, int n)
+	{
+		int i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_store_ps(out + i, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i))));
+		return i;
+	}
+
+	HLT_TARGET_AVX2 static void convert(float* out, const int16_t* plane, int n)
+	{
+		for (int i = 0; i < n; i += 8)
+		{
+			__m256i wide = _mm256_cvtepi16_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(plane + i)));
+			_mm256_store_ps(out + i, _mm256_cvtepi32_ps(wide));
+		}
+	}
+
+	HLT_TARGET_AVX2 static void fill(float* out, float value, int n)
+	{
+		__m256 v = _mm256_set1_ps(value);
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, v);
+	}
+
+	HLT_TARGET_AVX2 static void add(float* out, const float* plane, int n)
+	{
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_add_ps(_mm256_load_ps(out + i), _mm256_load_ps(plane + i)));
+	}
+
+	HLT_TARGET_AVX2 static void add(float* out, float value, int n)
+	{
+		__m256 v = _mm256_set1_ps(value);
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_add_ps(_mm256_load_ps(out + i), v));
+	}
+
+	HLT_TARGET_AVX2 static void multiply(float* out, const float* plane, int n)
+	{
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_mul_ps(_mm256_load_ps(out + i), _mm256_load_ps(plane + i)));
+	}
+
+	HLT_TARGET_AVX2 static void scale(float* out, float factor, int n)
+	{
+		__m256 f = _mm256_set1_ps(factor);
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_mul_ps(_mm256_load_ps(out + i), f));
+	}
+
+	HLT_TARGET_AVX2 static void multiply_add(float* out, const float* plane, float factor, int n)
+	{
+		__m256 f = _mm256_set1_ps(factor);
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_add_ps(_mm256_load_ps(out + i), _mm256_mul_ps(_mm256_load_ps(plane + i), f)));
+	}
+
+	HLT_TARGET_AVX2 static void clamp(float* out, float low, float high, int n)
+	{
+		__m256 l = _mm256_set1_ps(low);
+		__m256 h = _mm256_set1_ps(high);
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_min_ps(_mm256_max_ps(_mm256_load_ps(out + i), l), h));
+	}
+
+	HLT_TARGET_AVX2 static void apply(float* out, const float* plane, const PiecewiseLinear& shape, int n)
+	{
+		__m256 zero = _mm256_setzero_ps();
+		__m256 one = _mm256_set1_ps(1.0f);
+
+		for (int i = 0; i < n; i += 8)
+		{
+			__m256 x = _mm256_load_ps(plane + i);
+			__m256 y = _mm256_set1_ps(shape.y0);
+
+			for (int k = 0; k < shape.segments; ++k)
+			{
+				__m256 t = _mm256_mul_ps(_mm256_sub_ps(x, _mm256_set1_ps(shape.x[k])), _mm256_set1_ps(shape.inverse_dx[k]));
+				t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+				y = _mm256_add_ps(y, _mm256_mul_ps(t, _mm256_set1_ps(shape.dy[k])));
+			}
+
+			_mm256_store_ps(out + i, y);
+		}
+	}
+
+	HLT_TARGET_AVX2 static void masked_assign(float* out, const int16_t* mask, float value, int n)
+	{
+		__m256 v = _mm256_set1_ps(value);
+		for (int i = 0; i < n; i += 8)
+			_mm256_store_ps(out + i, _mm256_blendv_ps(v, _mm256_load_ps(out + i), mask_is_zero(mask + i)));
+	}
+
+	HLT_TARGET_AVX2 static void masked_scale(float* out, const int16_t* mask, float factor, int n)
+	{
+		__m256 f = _mm256_set1_ps(factor);
+		for (int i = 0; i < n; i += 8)
+		{
+			__m256 o = _mm256_load_ps(out + i);
+			_mm256_store_ps(out + i, _mm256_blendv_ps(_mm256_mul_ps(o, f), o, mask_is_zero(mask + i)));
+		}
+	}
+
+	HLT_TARGET_AVX2 static void scale_by_power(float* out, const int16_t* exponent, const float* powers, int n)
+	{
+		__m256i low = _mm256_setzero_si256();
+		__m256i high = _mm256_set1_epi32(kernels::MAX_EXPONENT);
+		for (int i = 0; i < n; i += 8)
+		{
+			__m256i e = _mm256_cvtepi16_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(exponent + i)));
+			e = _mm256_min_epi32(_mm256_max_epi32(e, low), high);
+			_mm256_store_ps(out + i, _mm256_mul_ps(_mm256_load_ps(out + i), _mm256_i32gather_ps(powers, e, 4)));
+		}
+	}
+
+	HLT_TARGET_AVX2 static void add(int16_t* out, int16_t value, int n)
+	{
+		__m256i v = _mm256_set1_epi16(value);
+		for (int i = 0; i < n; i += 16)
+		{
+			__m256i* o = reinterpret_cast<__m256i*>(out + i);
+			_mm256_store_si256(o, _mm256_add_epi16(_mm256_load_si256(o), v));
+		}
+	}
+
+	HLT_TARGET_AVX2 static void clamp(int16_t* out, int16_t low, int16_t high, int n)
+	{
+		__m256i l = _mm256_set1_epi16(low);
+		__m256i h = _mm256_set1_epi16(high);
+		for (int i = 0; i < n; i += 16)
+		{
+			__m256i* o = reinterpret_cast<__m256i*>(out + i);
+			_mm256_store_si256(o, _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(o), l), h));
+		}
+	}
+}
+#endif
+
+void kernels::load(FloatPlane& out, const vector<int>& values)
+{
+	float* o = out.data();
+	int i = 0;
+#if HLT_KERNELS_X86
+	if (current_isa == Isa::AVX2)
+		i = avx2::load(o, values.data(), out.size());
+#endif
+	for (; i < out.size(); ++i)
+		o[i] = (float)values[i];
+}
+
+void kernels::load(FloatPlane& out, const Grid<double>& grid)
+{
+	const double* values = grid.data();
+	for (int i = 0; i < out.size(); ++i)
+		out[i] = (float)values[i];
+}
+
+void kernels::load(ShortPlane& out, const Grid<int>& grid)
+{
+	const int* values = grid.data();
+	for (int i = 0; i < out.size(); ++i)
+		out[i] = (int16_t)min(max(values[i], (int)INT16_MIN), (int)INT16_MAX);
+}
+
+void kernels::store(const FloatPlane& plane, Grid<double>& grid)
+{
+	double* values = grid.data();
+	for (int i = 0; i < plane.size(); ++i)
+		values[i] = (double)plane[i];
+}
+
+void kernels::convert(FloatPlane& out, const ShortPlane& plane)
+{
+	AVX2_DISPATCH(avx2::convert(out.data(), plane.data(), out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] = (float)plane[i];
+}
+
+void kernels::fill(FloatPlane& out, float value)
+{
+	AVX2_DISPATCH(avx2::fill(out.data(), value, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] = value;
+}
+
+void kernels::copy(FloatPlane& out, const FloatPlane& plane)
+{
+	memcpy(out.data(), plane.data(), out.padded_size() * sizeof(float));
+}
+
+void kernels::add(FloatPlane& out, const FloatPlane& plane)
+{
+	AVX2_DISPATCH(avx2::add(out.data(), plane.data(), out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] += plane[i];
+}
+
+void kernels::add(FloatPlane& out, float value)
+{
+	AVX2_DISPATCH(avx2::add(out.data(), value, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] += value;
+}
+
+void kernels::multiply(FloatPlane& out, const FloatPlane& plane)
+{
+	AVX2_DISPATCH(avx2::multiply(out.data(), plane.data(), out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] *= plane[i];
+}
+
+void kernels::scale(FloatPlane& out, float factor)
+{
+	AVX2_DISPATCH(avx2::scale(out.data(), factor, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] *= factor;
+}
+
+void kernels::multiply_add(FloatPlane& out, const FloatPlane& plane, float factor)
+{
+	AVX2_DISPATCH(avx2::multiply_add(out.data(), plane.data(), factor, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] += plane[i] * factor;
+}
+
+void kernels::clamp(FloatPlane& out, float low, float high)
+{
+	AVX2_DISPATCH(avx2::clamp(out.data(), low, high, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] = min(max(out[i], low), high);
+}
+
+void kernels::apply(FloatPlane& out, const FloatPlane& plane, const PiecewiseLinear& shape)
+{
+	AVX2_DISPATCH(avx2::apply(out.data(), plane.data(), shape, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+	{
+		float y = shape.y0;
+		for (int k = 0; k < shape.segments; ++k)
+		{
+			float t = (plane[i] - shape.x[k]) * shape.inverse_dx[k];
+			t = min(max(t, 0.0f), 1.0f);
+			y += t * shape.dy[k];
+		}
+		out[i] = y;
+	}
+}
+
+void kernels::masked_assign(FloatPlane& out, const ShortPlane& mask, float value)
+{
+	AVX2_DISPATCH(avx2::masked_assign(out.data(), mask.data(), value, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		if (mask[i])
+			out[i] = value;
+}
+
+void kernels::masked_scale(FloatPlane& out, const ShortPlane& mask, float factor)
+{
+	AVX2_DISPATCH(avx2::masked_scale(out.data(), mask.data(), factor, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		if (mask[i])
+			out[i] *= factor;
+}
+
+void kernels::scale_by_power(FloatPlane& out, const ShortPlane& exponent, double base)
+{
+	float powers[MAX_EXPONENT + 1];
+	for (int e = 0; e <= MAX_EXPONENT; ++e)
+		powers[e] = (float)pow(base, e);
+
+	AVX2_DISPATCH(avx2::scale_by_power(out.data(), exponent.data(), powers, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] *= powers[min(max((int)exponent[i], 0), MAX_EXPONENT)];
+}
+
+void kernels::add(ShortPlane& out, int16_t value)
+{
+	AVX2_DISPATCH(avx2::add(out.data(), value, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] = (int16_t)(out[i] + value);
+}
+
+void kernels::clamp(ShortPlane& out, int16_t low, int16_t high)
+{
+	AVX2_DISPATCH(avx2::clamp(out.data(), low, high, out.padded_size()));
+	for (int i = 0; i < out.padded_size(); ++i)
+		out[i] = min(max(out[i], low), high);
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "grid.hpp"
+
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Row-major width * height plane of floats or int16, aligned on 32 bytes and padded to a
+	whole number of AVX2 registers, so that kernels run full vectors without a tail. Padding
+	cells hold values of no meaning. Resizing to fewer cells keeps the buffer and its values.
+	*/
+	template <typename T>
+	class Plane
+	{
+	public:
+		static const int ALIGNMENT = 32;
+		static const int LANES = ALIGNMENT / sizeof(T);
+
+		Plane() : width(0), height(0), cells(0), padded_cells(0), capacity(0), values(nullptr) {}
+		Plane(int width, int height) : Plane() { resize(width, height); }
+		Plane(const Plane& other) : Plane() { *this = other; }
+		Plane& operator=(const Plane& other)
+		{
+			if (this != &other)
+			{
+				resize(other.width, other.height);
+				if (padded_cells)
+					memcpy(values, other.values, padded_cells * sizeof(T));
+			}
+			return *this;
+		}
+
+		void resize(int new_width, int new_height)
+		{
+			if ((new_width == width) && (new_height == height))
+				return;
+
+			width = new_width;
+			height = new_height;
+			cells = width * height;
+			padded_cells = (cells + LANES - 1) / LANES * LANES;
+			if (padded_cells <= capacity)
+				return;
+
+			capacity = padded_cells;
+			buffer.reset(new char[padded_cells * sizeof(T) + ALIGNMENT]);
+			uintptr_t address = reinterpret_cast<uintptr_t>(buffer.get());
+			values = reinterpret_cast<T*>((address + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+			memset(values, 0, padded_cells * sizeof(T));
+		}
+
+		inline T& operator[](int index) { return values[index]; }
+		inline const T& operator[](int index) const { return values[index]; }
+		inline T* data() { return values; }
+		inline const T* data() const { return values; }
+		inline int size() const { return cells; }
+		inline int padded_size() const { return padded_cells; }
+
+		int width;
+		int height;
+
+	private:
+		int cells;
+		int padded_cells;
+		int capacity;
+		unique_ptr<char[]> buffer;
+		T* values;
+	};
+
+	typedef Plane<float> FloatPlane;
+	typedef Plane<int16_t> ShortPlane;
+
+	/*
+	Piecewise-linear function through increasing knots, constant outside of them, written as
+	y0 + sum over segments of clamp((x - x_k) / (x_k+1 - x_k), 0, 1) * (y_k+1 - y_k) so that
+	it evaluates without branches.
+	*/
+	struct PiecewiseLinear
+	{
+		static const int MAX_SEGMENTS = 4;
+
+		int segments;
+		float y0;
+		float x[MAX_SEGMENTS];
+		float inverse_dx[MAX_SEGMENTS];
+		float dy[MAX_SEGMENTS];
+
+		PiecewiseLinear(const vector<double>& knots_x, const vector<double>& knots_y);
+
+		// Scorer::butterfly and Scorer::strangle
+		static PiecewiseLinear butterfly(double x_min, double x_mid, double x_max, double y_min, double y_mid, double y_max);
+		static PiecewiseLinear strangle(double x_min, double x_mid1, double x_mid2, double x_max, double y_min, double y_mid1, double y_mid2, double y_max);
+	};
+
+	/*
+	Element-wise kernels over planes, AVX2 when the cpu has it and scalar otherwise. Both
+	paths do the same float operations in the same order, so their results are identical.
+	Planes given to a kernel must have the same size; masks are int16 planes, set when non 0.
+	*/
+	namespace kernels
+	{
+		enum class Isa { SCALAR, AVX2 };
+
+		Isa isa();
+		// Switches the kernels to isa, false when the cpu does not have it
+		bool set_isa(Isa isa);
+		const char* isa_name(Isa isa);
+
+		// Conversions from and to the Scorer grids, values beyond int16 are saturated
+		void load(FloatPlane& out, const vector<int>& values);
+		void load(FloatPlane& out, const Grid<double>& grid);
+		void load(ShortPlane& out, const Grid<int>& grid);
+		void store(const FloatPlane& plane, Grid<double>& grid);
+		void convert(FloatPlane& out, const ShortPlane& plane);
+
+		void fill(FloatPlane& out, float value);
+		void copy(FloatPlane& out, const FloatPlane& plane);
+		void add(FloatPlane& out, const FloatPlane& plane);
+		void add(FloatPlane& out, float value);
+		void multiply(FloatPlane& out, const FloatPlane& plane);
+		void scale(FloatPlane& out, float factor);
+		// out += plane * factor
+		void multiply_add(FloatPlane& out, const FloatPlane& plane, float factor);
+		void clamp(FloatPlane& out, float low, float high);
+		// out = shape(plane)
+		void apply(FloatPlane& out, const FloatPlane& plane, const PiecewiseLinear& shape);
+		// out = mask ? value : out
+		void masked_assign(FloatPlane& out, const ShortPlane& mask, float value);
+		// out = mask ? out * factor : out
+		void masked_scale(FloatPlane& out, const ShortPlane& mask, float factor);
+		// out *= base ^ exponent, exponents are clamped to [0, MAX_EXPONENT]
+		static const int MAX_EXPONENT = 15;
+		void scale_by_power(FloatPlane& out, const ShortPlane& exponent, double base);
+
+		void add(ShortPlane& out, int16_t value);
+		void clamp(ShortPlane& out, int16_t low, int16_t high);
+	}
+}
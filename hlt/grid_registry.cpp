@@ -0,0 +1,165 @@
+#include "grid_registry.hpp"
+#include "log.hpp"
+
+#include <cstdlib>
+
+using namespace hlt;
+using namespace std;
+
+void GridRegistry::add(int id, const string& name, initializer_list<GridSource> sources, initializer_list<int> inputs, initializer_list<int> optional_inputs,
+	Evaluation evaluation, function<void()> update)
+{
+	if (id != (int)grids.size())
+	{
+		log::log("Error: GridRegistry: grid " + name + " added with id " + to_string(id) + " instead of " + to_string(grids.size()));
+		exit(1);
+	}
+	for (int input : inputs)
+		if (input >= id)
+		{
+			log::log("Error: GridRegistry: grid " + name + " reads grid " + to_string(input) + ", which is not added before it");
+			exit(1);
+		}
+	for (int input : optional_inputs)
+		if (input >= id)
+		{
+			log::log("Error: GridRegistry: grid " + name + " reads grid " + to_string(input) + ", which is not added before it");
+			exit(1);
+		}
+
+	unique_ptr<Grid> grid = make_unique<Grid>();
+	grid->name = name;
+	grid->sources = sources;
+	grid->inputs = inputs;
+	grid->optional_inputs = optional_inputs;
+	grid->evaluation = evaluation;
+	grid->update = move(update);
+	grid->source_versions_seen.fill(0);
+	grid->input_versions_seen.assign(grid->inputs.size() + grid->optional_inputs.size(), 0);
+
+	grids.push_back(move(grid));
+}
+
+void GridRegistry::begin_turn()
+{
+	for (unique_ptr<Grid>& grid : grids)
+		grid->state = TurnState::SKIPPED;
+	touch(GridSource::TURN);
+}
+
+void GridRegistry::touch(GridSource source)
+{
+	source_versions[(int)source]++;
+}
+
+bool GridRegistry::is_stale(const Grid& grid) const
+{
+	if (grid.version == 0)
+		return true;
+
+	for (GridSource source : grid.sources)
+		if (grid.source_versions_seen[(int)source] != source_versions[(int)source])
+			return true;
+
+	int i = 0;
+	for (int input : grid.inputs)
+		if (grid.input_versions_seen[i++] != grids[input]->version)
+			return true;
+	for (int input : grid.optional_inputs)
+		if (grid.input_versions_seen[i++] != grids[input]->version)
+			return true;
+
+	return false;
+}
+
+void GridRegistry::update(Grid& grid)
+{
+	grid.update();
+
+	// Optional inputs required by the update are seen at their new version
+	grid.version++;
+	grid.source_versions_seen = source_versions;
+	int i = 0;
+	for (int input : grid.inputs)
+		grid.input_versions_seen[i++] = grids[input]->version;
+	for (int input : grid.optional_inputs)
+		grid.input_versions_seen[i++] = grids[input]->version;
+	grid.state = TurnState::COMPUTED;
+}
+
+void GridRegistry::require(int id)
+{
+	Grid& grid = *grids[id];
+	lock_guard<mutex> guard(grid.lock);
+
+	for (int input : grid.inputs)
+		require(input);
+
+	if (is_stale(grid))
+		update(grid);
+	else if (grid.state == TurnState::SKIPPED)
+		grid.state = TurnState::UP_TO_DATE;
+}
+
+void GridRegistry::compute(int id)
+{
+	Grid& grid = *grids[id];
+	lock_guard<mutex> guard(grid.lock);
+	update(grid);
+}
+
+bool GridRegistry::is_task(const Grid& grid, bool every_grid) const
+{
+	return (grid.evaluation == Evaluation::EAGER) || (every_grid && (grid.evaluation == Evaluation::LAZY));
+}
+
+void GridRegistry::add_tasks(TaskGraph& graph, bool every_grid)
+{
+	for (int id = 0; id < (int)grids.size(); ++id)
+	{
+		const Grid& grid = *grids[id];
+		if (!is_task(grid, every_grid))
+			continue;
+
+		// Other inputs are computed within the task that requires them
+		vector<string> dependencies;
+		for (const vector<int>* inputs : { &grid.inputs, &grid.optional_inputs })
+			for (int input : *inputs)
+				if (is_task(*grids[input], every_grid))
+					dependencies.push_back(grids[input]->name);
+
+		if (every_grid)
+			graph.add(grid.name, [this, id]() { compute(id); }, dependencies);
+		else
+			graph.add(grid.name, [this, id]() { require(id); }, dependencies);
+	}
+}
+
+int GridRegistry::computed_count() const
+{
+	int count = 0;
+	for (const unique_ptr<Grid>& grid : grids)
+		count += (grid->state == TurnState::COMPUTED);
+	return count;
+}
+
+int GridRegistry::skipped_count() const
+{
+	int count = 0;
+	for (const unique_ptr<Grid>& grid : grids)
+		count += (grid->state != TurnState::COMPUTED);
+	return count;
+}
+
+void GridRegistry::log_stats() const
+{
+	string computed, up_to_date, skipped;
+	for (const unique_ptr<Grid>& grid : grids)
+	{
+		string& names = (grid->state == TurnState::COMPUTED) ? computed : ((grid->state == TurnState::UP_TO_DATE) ? up_to_date : skipped);
+		names += (names.empty() ? "" : ", ") + grid->name;
+	}
+
+	log::log("Grids computed: " + (computed.empty() ? "none" : computed));
+	log::log("Grids up to date: " + (up_to_date.empty() ? "none" : up_to_date) + ", not read: " + (skipped.empty() ? "none" : skipped));
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "task_graph.hpp"
+
+#include <vector>
+#include <array>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <initializer_list>
+
+using namespace std;
+
+namespace hlt
+{
+	// What a grid is computed from besides other grids, each source has its own version
+	enum class GridSource : int
+	{
+		HALITE,         // halite of the cells
+		SHIPS,          // ship positions, spawns and destructions
+		CARGO,          // halite carried by the ships
+		STRUCTURES,     // shipyards and dropoffs
+		TURN,           // turn number, and state changed during a turn such as objectives
+		BASE_DISTANCES, // closest shipyard or dropoff of the distance manager, touched by its callers
+		COUNT
+	};
+
+	/*
+	Grids with the sources and the grids they are computed from. A grid keeps the versions of
+	its inputs it was last computed with and is only computed again when it is read after one
+	of them changed: require brings the inputs up to date first, then the grid when it is stale.
+
+	Eager grids are read every turn and run as tasks of the turn, after the eager grids they
+	read. Lazy grids are left out of the tasks and computed on their first require of the
+	turn, from any thread: each grid has its own lock, taken before the locks of its inputs.
+	On request grids are lazy grids kept out of every_grid tasks too: grids the bot does not
+	read, or that read state computed outside of the registry.
+
+	Optional inputs are grids the update only requires on some turns. They count for
+	staleness like the others but are not required before the update.
+	*/
+	class GridRegistry
+	{
+	public:
+		enum class Evaluation { EAGER, LAZY, ON_REQUEST };
+
+		// Adds grid id, which must be the number of grids added so far, after its inputs
+		void add(int id, const string& name, initializer_list<GridSource> sources, initializer_list<int> inputs, initializer_list<int> optional_inputs,
+			Evaluation evaluation, function<void()> update);
+		inline bool empty() const { return grids.empty(); }
+		inline int size() const { return (int)grids.size(); }
+		inline const string& name(int id) const { return grids[id]->name; }
+
+		// New turn, every grid reading TURN is stale
+		void begin_turn();
+		// Grids reading the source are stale
+		void touch(GridSource source);
+
+		// Computes the grid if it or any of its inputs is stale
+		void require(int id);
+		// Computes the grid whatever its inputs, which must be up to date
+		void compute(int id);
+		inline int version(int id) const { return grids[id]->version; }
+
+		// Tasks of the eager grids, or of the eager and lazy grids with every_grid
+		void add_tasks(TaskGraph& graph, bool every_grid);
+
+		// Grids computed and not computed since begin_turn
+		int computed_count() const;
+		int skipped_count() const;
+		void log_stats() const;
+
+	private:
+		enum class TurnState { SKIPPED, UP_TO_DATE, COMPUTED };
+
+		struct Grid
+		{
+			string name;
+			vector<GridSource> sources;
+			vector<int> inputs;
+			vector<int> optional_inputs;
+			Evaluation evaluation;
+			function<void()> update;
+
+			int version = 0; // 0 is never computed
+			array<int, (int)GridSource::COUNT> source_versions_seen;
+			vector<int> input_versions_seen; // inputs, then optional inputs
+			TurnState state = TurnState::SKIPPED;
+			mutex lock;
+		};
+
+		vector<unique_ptr<Grid>> grids;
+		array<int, (int)GridSource::COUNT> source_versions = {};
+
+		bool is_stale(const Grid& grid) const;
+		bool is_task(const Grid& grid, bool every_grid) const;
+		void update(Grid& grid);
+	};
+}
@@ -0,0 +1,115 @@
+#include "halite_pyramid.hpp"
+#include "small_vector.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+
+using namespace hlt;
+using namespace std;
+
+void HalitePyramid::resize(int new_width, int new_height)
+{
+	width = new_width;
+	height = new_height;
+
+	for (Level* level : { &fine, &coarse })
+	{
+		level->columns = (width + level->size - 1) / level->size;
+		level->rows = (height + level->size - 1) / level->size;
+		level->max_value.resize(level->columns, level->rows, 1, -DBL_MAX);
+		level->min_distance.resize(level->columns, level->rows, 1, INT_MAX);
+	}
+}
+
+void HalitePyramid::build(const Grid<double>& values, const Grid<int>& distances)
+{
+	resize(values.width, values.height);
+
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x)
+		{
+			int column = x / FINE, row = y / FINE;
+			fine.max_value[row][column] = max(fine.max_value[row][column], values[y][x]);
+			fine.min_distance[row][column] = min(fine.min_distance[row][column], distances[y][x]);
+		}
+
+	const int ratio = COARSE / FINE;
+	for (int row = 0; row < fine.rows; ++row)
+		for (int column = 0; column < fine.columns; ++column)
+		{
+			int coarse_column = column / ratio, coarse_row = row / ratio;
+			coarse.max_value[coarse_row][coarse_column] = max(coarse.max_value[coarse_row][coarse_column], fine.max_value[row][column]);
+			coarse.min_distance[coarse_row][coarse_column] = min(coarse.min_distance[coarse_row][coarse_column], fine.min_distance[row][column]);
+		}
+}
+
+void HalitePyramid::update_fine_block(const Grid<double>& values, int column, int row)
+{
+	double block_max = -DBL_MAX;
+	for (int y = fine.y0(row); y < fine.y1(row, height); ++y)
+		for (int x = fine.x0(column); x < fine.x1(column, width); ++x)
+			block_max = max(block_max, values[y][x]);
+	fine.max_value[row][column] = block_max;
+}
+
+void HalitePyramid::update_coarse_block(int column, int row)
+{
+	const int ratio = COARSE / FINE;
+	double block_max = -DBL_MAX;
+	for (int fine_row = row * ratio; fine_row < min((row + 1) * ratio, fine.rows); ++fine_row)
+		for (int fine_column = column * ratio; fine_column < min((column + 1) * ratio, fine.columns); ++fine_column)
+			block_max = max(block_max, fine.max_value[fine_row][fine_column]);
+	coarse.max_value[row][column] = block_max;
+}
+
+void HalitePyramid::update(const Grid<double>& values, int x, int y)
+{
+	if (empty())
+		return;
+
+	update_fine_block(values, x / FINE, y / FINE);
+	update_coarse_block(x / COARSE, y / COARSE);
+}
+
+void HalitePyramid::update_square(const Grid<double>& values, const WrapTable& wrap, int x, int y, int radius)
+{
+	if (empty())
+		return;
+
+	// Columns and rows of blocks the wrapped square overlaps, at both levels
+	SmallVector<int, 2 * WrapTable::MAX_RADIUS + 1> fine_columns, fine_rows, coarse_columns, coarse_rows;
+	auto insert = [](SmallVector<int, 2 * WrapTable::MAX_RADIUS + 1>& blocks, int block)
+	{
+		if (find(blocks.begin(), blocks.end(), block) == blocks.end())
+			blocks.push_back(block);
+	};
+	for (int d = -radius; d <= radius; ++d)
+	{
+		insert(fine_columns, wrap.wrap_x(x + d) / FINE);
+		insert(fine_rows, wrap.wrap_y(y + d) / FINE);
+		insert(coarse_columns, wrap.wrap_x(x + d) / COARSE);
+		insert(coarse_rows, wrap.wrap_y(y + d) / COARSE);
+	}
+
+	for (int row : fine_rows)
+		for (int column : fine_columns)
+			update_fine_block(values, column, row);
+	for (int row : coarse_rows)
+		for (int column : coarse_columns)
+			update_coarse_block(column, row);
+}
+
+void HalitePyramid::check(const Grid<double>& values, const Grid<int>& distances) const
+{
+	HalitePyramid rebuilt;
+	rebuilt.build(values, distances);
+
+	for (const Level* level : { &fine, &coarse })
+	{
+		const Level& rebuilt_level = (level == &fine) ? rebuilt.fine : rebuilt.coarse;
+		if ((level->max_value != rebuilt_level.max_value) || (level->min_distance != rebuilt_level.min_distance))
+			log::log("Error: HalitePyramid: blocks of " + to_string(level->size) + " cells differ from the grids");
+	}
+}
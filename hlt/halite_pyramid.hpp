@@ -0,0 +1,65 @@
+#pragma once
+
+#include "grid.hpp"
+#include "wrap_table.hpp"
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Maxima of a score grid over blocks of FINE * FINE and COARSE * COARSE cells, with the
+	minima of a distance grid over the same blocks, so that a search can bound a whole block
+	before reading its cells. Blocks tile the map from (0, 0), the last row and column of
+	blocks being smaller when the map is not a multiple of the block size, and every coarse
+	block is made of whole fine blocks.
+
+	Maxima stay exact as values change: a changed cell recomputes its fine block, then the
+	coarse block above it from the fine maxima. Distances are only read by build.
+	*/
+	class HalitePyramid
+	{
+	public:
+		static const int FINE = 4;
+		static const int COARSE = 16;
+		static const int CHECK_PERIOD = 50;
+		static_assert(COARSE % FINE == 0, "Coarse blocks are made of fine blocks");
+
+		struct Level
+		{
+			int size;
+			int columns;
+			int rows;
+			Grid<double> max_value;
+			Grid<int> min_distance;
+
+			// Cells of block (column, row), [x0, x1) * [y0, y1)
+			inline int x0(int column) const { return column * size; }
+			inline int y0(int row) const { return row * size; }
+			inline int x1(int column, int width) const { return min(x0(column) + size, width); }
+			inline int y1(int row, int height) const { return min(y0(row) + size, height); }
+		};
+
+		HalitePyramid() : width(0), height(0) { fine.size = FINE; coarse.size = COARSE; }
+
+		// Every block from the values and the distances, both width * height
+		void build(const Grid<double>& values, const Grid<int>& distances);
+		// Follows a change of the value of cell (x, y), or of any cell of the square of radius around it
+		void update(const Grid<double>& values, int x, int y);
+		void update_square(const Grid<double>& values, const WrapTable& wrap, int x, int y, int radius);
+		inline bool empty() const { return width == 0; }
+
+		// Compares with a build from the grids, logs a difference
+		void check(const Grid<double>& values, const Grid<int>& distances) const;
+
+		int width;
+		int height;
+		Level fine;
+		Level coarse;
+
+	private:
+		void resize(int new_width, int new_height);
+		void update_fine_block(const Grid<double>& values, int column, int row);
+		void update_coarse_block(int column, int row);
+	};
+}
@@ -0,0 +1,99 @@
+#include "input.hpp"
+
+#include <cstdlib>
+
+static std::istream* source = &std::cin;
+static std::string buffer;
+static size_t cursor = 0;
+static hlt::input::CaptureCallback capture = nullptr;
+
+static void append_line()
+{
+	std::streambuf* stream = source->rdbuf();
+	const size_t start = buffer.size();
+	const int eof = std::streambuf::traits_type::eof();
+
+	int c;
+	while (((c = stream->sbumpc()) != eof) && (c != '\n'))
+		buffer.push_back(static_cast<char>(c));
+
+	if ((c == eof) && (buffer.size() == start))
+	{
+		hlt::log::log("Input connection from server closed. Exiting...");
+		exit(0);
+	}
+
+	buffer.push_back('\n');
+}
+
+static inline bool is_blank(char c)
+{
+	return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+void hlt::input::set_source(istream& new_source)
+{
+	source = &new_source;
+	buffer.clear();
+	cursor = 0;
+}
+
+void hlt::input::set_capture(CaptureCallback new_capture)
+{
+	capture = new_capture;
+}
+
+void hlt::input::begin_frame()
+{
+	buffer.clear();
+	cursor = 0;
+}
+
+void hlt::input::end_frame()
+{
+	if (capture && !buffer.empty())
+		capture(buffer);
+}
+
+const std::string& hlt::input::frame()
+{
+	return buffer;
+}
+
+int hlt::input::read_int()
+{
+	for (;;)
+	{
+		while ((cursor < buffer.size()) && is_blank(buffer[cursor]))
+			cursor++;
+
+		if (cursor < buffer.size())
+			break;
+
+		append_line();
+	}
+
+	const char* c = buffer.data() + cursor;
+	bool negative = (*c == '-');
+	if (negative)
+		c++;
+
+	int value = 0;
+	while ((*c >= '0') && (*c <= '9'))
+		value = 10 * value + (*c++ - '0');
+
+	cursor = c - buffer.data();
+	return negative ? -value : value;
+}
+
+std::string hlt::input::read_line()
+{
+	if (cursor >= buffer.size())
+		append_line();
+
+	size_t end = buffer.find('\n', cursor);
+	std::string line = buffer.substr(cursor, end - cursor);
+	cursor = end + 1;
+
+	return line;
+}
@@ -4,24 +4,30 @@
 
 #include <string>
 #include <iostream>
-#include <sstream>
 
-namespace hlt 
+using namespace std;
+
+namespace hlt
 {
-    static std::string get_string() 
+	/*
+	Buffered reader for the engine protocol. Every line of the current frame is appended
+	to one reusable buffer and integers are parsed in place, no stream is built per line.
+	*/
+	namespace input
 	{
-        std::string result;
-        std::getline(std::cin, result);
-        if (!std::cin.good()) 
-		{
-            hlt::log::log("Input connection from server closed. Exiting...");
-            exit(0);
-        }
-        return result;
-    }
+		void set_source(istream& source);
 
-    static std::stringstream get_sstream() 
-	{
-        return std::stringstream(get_string());
-    }
+		// Every block that was read (init, then one per frame) is handed to the capture by end_frame
+		typedef void (*CaptureCallback)(const string& block);
+		void set_capture(CaptureCallback capture);
+
+		// Forget previous frame, buffer capacity is kept
+		void begin_frame();
+		// The block is fully read, hands it to the capture at once
+		void end_frame();
+		const string& frame();
+
+		int read_int();
+		string read_line();
+	}
 }
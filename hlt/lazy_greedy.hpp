@@ -0,0 +1,106 @@
+#pragma once
+
+#include "objective.hpp"
+#include "log.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Greedy assignment of candidates 0..n-1 to their best objective: each round takes the
+	candidate with the highest score, the lowest index on ties as a loop keeping strict
+	improvements would, then the caller lowers the scores its objective overlaps.
+
+	Best objectives are kept in a max-heap and only searched again when the caller marks
+	them stale. As scores never increase during the assignment, a stale entry is an upper
+	bound of its candidate: the top is searched again and pushed back until it is fresh,
+	and a fresh top is the candidate the full loop would pick.
+	*/
+	class LazyGreedy
+	{
+	public:
+		static const int CHECK_PERIOD = 50;
+
+		LazyGreedy() : searches(0) {}
+
+		// Every candidate is searched before the first pick
+		void reset(int candidates)
+		{
+			objectives.assign(candidates, Objective());
+			fresh.assign(candidates, 0);
+			left.assign(candidates, 1);
+			heap.clear();
+			for (int candidate = 0; candidate < candidates; ++candidate)
+				heap.push_back(Entry{ DBL_MAX, candidate });
+			make_heap(heap.begin(), heap.end());
+			searches = 0;
+		}
+
+		inline bool empty() const { return heap.empty(); }
+		inline const Objective& objective(int candidate) const { return objectives[candidate]; }
+
+		// Best candidate left, with search(candidate) giving its best objective, and removes it
+		template<typename Search> int pop(Search search)
+		{
+			while (!fresh[heap.front().candidate])
+			{
+				int candidate = heap.front().candidate;
+				pop_heap(heap.begin(), heap.end());
+				objectives[candidate] = search(candidate);
+				fresh[candidate] = 1;
+				searches++;
+				heap.back() = Entry{ objectives[candidate].score, candidate };
+				push_heap(heap.begin(), heap.end());
+			}
+
+			int best = heap.front().candidate;
+			pop_heap(heap.begin(), heap.end());
+			heap.pop_back();
+			left[best] = 0;
+			return best;
+		}
+
+		// Marks the objectives of the candidates left for which overlaps(objective) holds, after a decrease of their scores
+		template<typename Overlaps> void invalidate(Overlaps overlaps)
+		{
+			for (int candidate = 0; candidate < (int)objectives.size(); ++candidate)
+				if (left[candidate] && fresh[candidate] && overlaps(objectives[candidate]))
+					fresh[candidate] = 0;
+		}
+
+		// Compares the score of the last pick with the best score of a full loop over the candidates left, logs a difference.
+		// Candidates of equal scores may be picked in another order, only the score is compared.
+		template<typename Search> void check(int best, Search search) const
+		{
+			double loop_score = -DBL_MAX;
+			for (int candidate = 0; candidate < (int)objectives.size(); ++candidate)
+				if (left[candidate] || (candidate == best))
+					loop_score = max(loop_score, search(candidate).score);
+
+			if (loop_score != objectives[best].score)
+				log::log("Error: LazyGreedy: picked candidate " + to_string(best) + " with score " + to_string(objectives[best].score) + " instead of " + to_string(loop_score));
+		}
+
+		int searches;
+
+	private:
+		struct Entry
+		{
+			double score;
+			int candidate;
+
+			// Max-heap order: higher scores, then lower candidates, on top
+			inline bool operator<(const Entry& other) const { return (score < other.score) || ((score == other.score) && (candidate > other.candidate)); }
+		};
+
+		vector<Objective> objectives;
+		vector<char> fresh;
+		vector<char> left;
+		vector<Entry> heap;
+	};
+}
@@ -5,12 +5,15 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <mutex>
 #include <stdio.h>
 
 static std::ofstream log_file;
 static std::vector<std::string> log_buffer;
 static bool has_opened = false;
 static bool has_atexit = false;
+static std::mutex log_mutex;
+static thread_local std::vector<std::string>* redirect_buffer = nullptr;
 
 void dump_buffer_at_exit() 
 {
@@ -44,8 +47,21 @@ void hlt::log::open(int bot_id)
     log_buffer.clear();
 }
 
+void hlt::log::redirect(std::vector<std::string>* buffer)
+{
+    redirect_buffer = buffer;
+}
+
 void hlt::log::log(const std::string& message) 
 {
+    // Errors are written at once, exit follows them
+    if (redirect_buffer && (message.compare(0, 5, "Error") != 0))
+    {
+        redirect_buffer->push_back(message);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(log_mutex);
     if (has_opened) 
 	{
 		#if HALITE_LOCAL
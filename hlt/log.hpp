@@ -12,9 +12,28 @@ namespace hlt
 	{
         void open(int bot_id);
         void log(const string& message);
+		// Messages of the calling thread go to buffer instead of the file, nullptr to stop
+		void redirect(vector<string>* buffer);
 
 		void log_vector(vector<int> vec);
 		void log_vectorvector(vector<vector<int>> vec);
 		void log_vectorvector(vector<vector<double>> vec);
+		// Rows of a Grid or of a GridView, as log_vectorvector
+		template <typename G>
+		void log_grid(const G& grid)
+		{
+			for (int i = 0; i < grid.height; ++i)
+			{
+				string padding = (i <= 9) ? "0" : "";
+				string line = "" + padding + to_string(i) + " | ";
+				for (int j = 0; j < grid.width; ++j)
+					line += to_string(grid[i][j]) + " ";
+				line += " | " + padding + to_string(i);
+
+				log(line);
+			}
+
+			log("");
+		}
     }
 }
@@ -5,28 +5,39 @@
 #include "ship.hpp"
 #include "dropoff.hpp"
 
+#include <cstdint>
+
 using namespace std;
 
 namespace hlt 
 {
+	/*
+	Compact cell stored row-major in GameMap::cells, its position is implied by its index.
+	The ship is a slot of GameMap::ship_pool, structures are only known by their owner.
+	*/
     struct MapCell
 	{
-        Position position;
-        Halite halite;
-        shared_ptr<Ship> ship;
-        shared_ptr<Entity> structure;
+		static const uint16_t NO_SHIP = 0xFFFF;
+		static const int8_t NO_OWNER = -1;
+
+        uint16_t halite;
+        uint16_t ship;
+        int8_t ship_owner;
+        int8_t structure_owner;
 
-        MapCell(int x, int y, Halite halite) :
-            position(x, y),
-            halite(halite)
+        MapCell(Halite halite) :
+            halite((uint16_t)halite),
+            ship(NO_SHIP),
+            ship_owner(NO_OWNER),
+            structure_owner(NO_OWNER)
         {}
 
-        bool is_empty() const { return !ship && !structure; }
-        bool is_occupied() const { return static_cast<bool>(ship); }
-		bool is_occupied_by_ally(PlayerId id) const { return static_cast<bool>(ship) && (ship->owner == id); }
-		bool is_occupied_by_enemy(PlayerId id) const { return static_cast<bool>(ship) && (ship->owner != id); }
-        bool has_structure() const { return static_cast<bool>(structure); }
-		bool is_shipyard_or_dropoff(int playerid) const { return static_cast<bool>(structure) && structure->owner == playerid; }
-        void mark_unsafe(shared_ptr<Ship>& ship) { this->ship = ship; }
+        bool is_empty() const { return (ship == NO_SHIP) && (structure_owner == NO_OWNER); }
+        bool is_occupied() const { return ship != NO_SHIP; }
+		bool is_occupied_by_ally(PlayerId id) const { return (ship != NO_SHIP) && (ship_owner == id); }
+		bool is_occupied_by_enemy(PlayerId id) const { return (ship != NO_SHIP) && (ship_owner != id); }
+        bool has_structure() const { return structure_owner != NO_OWNER; }
+		bool is_shipyard_or_dropoff(int playerid) const { return (structure_owner != NO_OWNER) && (structure_owner == playerid); }
+		void flush_ship() { ship = NO_SHIP; ship_owner = NO_OWNER; }
     };
 }
@@ -0,0 +1,71 @@
+#include "map_statistics.hpp"
+#include "game_map.hpp"
+#include "log.hpp"
+
+using namespace hlt;
+using namespace std;
+
+void MapStatistics::reset(const GameMap& map)
+{
+	width = map.width;
+	height = map.height;
+	cells = width * height;
+	regions_width = (width + REGION_SIZE - 1) / REGION_SIZE;
+	regions_height = (height + REGION_SIZE - 1) / REGION_SIZE;
+
+	halite_total = 0;
+	value_counts.assign(MAX_HALITE_VALUE + 1, 0);
+	buckets.assign(BUCKETS, 0);
+	region_sums.assign(regions_width * regions_height, 0);
+
+	for (int index = 0; index < cells; ++index)
+		add(index, map.cells[index].halite, 1);
+}
+
+void MapStatistics::apply(const vector<CellChange>& changes)
+{
+	// A cell may change twice in a frame, previous is always the value it had before that line
+	for (const CellChange& change : changes)
+	{
+		add(change.index, change.previous, -1);
+		add(change.index, change.halite, 1);
+	}
+}
+
+int MapStatistics::percentile(double p) const
+{
+	int rank = min(max((int)(p * cells), 0), cells - 1);
+
+	int bucket = 0;
+	while (rank >= buckets[bucket])
+		rank -= buckets[bucket++];
+
+	int value = bucket * BUCKET_WIDTH;
+	while (rank >= value_counts[value])
+		rank -= value_counts[value++];
+
+	return value;
+}
+
+int MapStatistics::count_below(int value) const
+{
+	value = min(max(value, 0), MAX_HALITE_VALUE + 1);
+
+	int count = 0;
+	int bucket = 0;
+	for (; (bucket + 1) * BUCKET_WIDTH <= value; ++bucket)
+		count += buckets[bucket];
+	for (int v = bucket * BUCKET_WIDTH; v < value; ++v)
+		count += value_counts[v];
+
+	return count;
+}
+
+void MapStatistics::check(const GameMap& map) const
+{
+	MapStatistics rebuilt;
+	rebuilt.reset(map);
+
+	if ((rebuilt.halite_total != halite_total) || (rebuilt.value_counts != value_counts) || (rebuilt.buckets != buckets) || (rebuilt.region_sums != region_sums))
+		log::log("Error: MapStatistics: incremental statistics differ from the map, total " + to_string(halite_total) + " instead of " + to_string(rebuilt.halite_total));
+}
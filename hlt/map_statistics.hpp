@@ -0,0 +1,85 @@
+#pragma once
+
+#include "types.hpp"
+#include "position.hpp"
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+namespace hlt
+{
+	struct GameMap;
+	struct CellChange;
+
+	/*
+	Halite statistics of the map, kept up to date from the cells changed by each frame so
+	that a turn costs O(changes) instead of a scan of the map.
+
+	Every halite value has its own count, grouped in buckets of BUCKET_WIDTH values. The
+	buckets are the histogram and make percentile queries walk buckets first, then the
+	values of a single bucket. Region sums are over REGION_SIZE * REGION_SIZE blocks of
+	cells, the last row and column of blocks being smaller when the map is not a multiple.
+	*/
+	class MapStatistics
+	{
+	public:
+		static const int MAX_HALITE_VALUE = UINT16_MAX; // MapCell::halite is an uint16
+		static const int BUCKET_WIDTH = 16;
+		static const int BUCKETS = (MAX_HALITE_VALUE + 1) / BUCKET_WIDTH;
+		static const int REGION_SIZE = 8;
+		static const int CHECK_PERIOD = 50;
+
+		MapStatistics() : cells(0), halite_total(0), halite_initial(0), width(0), height(0), regions_width(0), regions_height(0) {}
+
+		// Rebuilds everything from the cells of the map
+		void reset(const GameMap& map);
+		// Follows the cells changed by the last GameMap::_update
+		void apply(const vector<CellChange>& changes);
+		inline bool initialized() const { return cells > 0; }
+
+		inline int total() const { return halite_total; }
+		// Total of the first turn
+		inline int initial_total() const { return halite_initial; }
+		inline void set_initial_total() { halite_initial = halite_total; }
+
+		// Halite of the cell at index (int)(p * cells) of the cells sorted by halite, p in [0, 1]
+		int percentile(double p) const;
+		// Cells with halite in [bucket * BUCKET_WIDTH, (bucket + 1) * BUCKET_WIDTH)
+		inline int bucket_count(int bucket) const { return buckets[bucket]; }
+		// Cells with halite < value
+		int count_below(int value) const;
+
+		inline int regions_x() const { return regions_width; }
+		inline int regions_y() const { return regions_height; }
+		inline int region_total(int region_x, int region_y) const { return region_sums[region_y * regions_width + region_x]; }
+		// Total of the region the position is in, position must be on the map
+		inline int region_total(const Position& position) const { return region_total(position.x / REGION_SIZE, position.y / REGION_SIZE); }
+
+		// Compares with a full rebuild from the map, logs a difference
+		void check(const GameMap& map) const;
+
+	private:
+		int cells;
+		int halite_total;
+		int halite_initial;
+		int width;
+		int height;
+		int regions_width;
+		int regions_height;
+
+		vector<int> value_counts; // by halite value
+		vector<int> buckets;
+		vector<int> region_sums;
+
+		inline int region(int index) const { return (index / width / REGION_SIZE) * regions_width + (index % width) / REGION_SIZE; }
+		inline void add(int index, int halite, int count)
+		{
+			value_counts[halite] += count;
+			buckets[halite / BUCKET_WIDTH] += count;
+			region_sums[region(index)] += count * halite;
+			halite_total += count * halite;
+		}
+	};
+}
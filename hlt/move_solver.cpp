@@ -66,18 +66,18 @@ double MoveSolver::score_path(shared_ptr<Ship> ship, const vector<Direction>& pa
 			int score_move = game.scorer.get_grid_score_move(current_position);
 			int current_distance = game.distance(initial_position, current_position);
 
-			if (four_player_game && (score_move == 10) && (current_distance <= 3) && (game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position) > 500.0))
+			if (four_player_game && (score_move == 10) && (current_distance <= 3) && (game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position, game) > 500.0))
 			{
 				cargo -= halite_to_burn;
 				score -= halite_to_burn * pow(discount, moves);
 				moves++;
 			}
-			else if (can_attack && (score_move == 10) && (current_distance <= 3) && (game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position) > 300.0))
+			else if (can_attack && (score_move == 10) && (current_distance <= 3) && (game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position, game) > 300.0))
 			{
-				return game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position) * pow(0.9, turn) / (1.0 + (double)moves);
+				return game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position, game) * pow(0.9, turn) / (1.0 + (double)moves);
 			}
 			// if positive combat expectation of moving to cell, then do so
-			else if ((score_move == 9) && (current_distance <= 3) && (game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position) > 100.0))
+			else if ((score_move == 9) && (current_distance <= 3) && (game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position, game) > 100.0))
 			{
 				cargo -= halite_to_burn;
 				score -= halite_to_burn * pow(discount, moves);
@@ -87,7 +87,7 @@ double MoveSolver::score_path(shared_ptr<Ship> ship, const vector<Direction>& pa
 			else if ((score_move == 9) && (current_distance == 1))
 			{
 				return soft_no - game.scorer.get_score_ship_move_to_position(ship, current_position, game);
-				//return soft_no + game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position);
+				//return soft_no + game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, current_position, game);
 			}
 			// If ally or enemy in other cell, hard no
 			else if (score_move > 0)
@@ -138,7 +138,8 @@ double MoveSolver::score_path(shared_ptr<Ship> ship, const vector<Direction>& pa
 
 pair<Position, double> MoveSolver::find_best_extract_move(shared_ptr<Ship> ship, const Game& game, int reach) const
 {
-	vector<double> scores((int)pow(5, reach), 0.0);
+	ArenaScope scope; // scores of this ship only
+	ArenaVector<double> scores((int)pow(5, reach), 0.0);
 
 	const vector<vector<Direction>>* path_permutations = get_path_permutations(reach);
 	int i = 0;
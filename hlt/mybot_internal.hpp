@@ -1,17 +1,30 @@
 #include "game.hpp"
 #include "constants.hpp"
 #include "log.hpp"
+#include "input.hpp"
+#include "transcript.hpp"
 
 #include <climits>
 #include <cfloat>
+#include <sstream>
 
 using namespace std;
 using namespace hlt;
 
 namespace hlt
 {
-	int mybot_internal(string bot_name, unordered_map<string, int> constants, unsigned int rng_seed)
+	// replay_path: read a captured game instead of stdin, capture_path: record the game being played
+	int mybot_internal(string bot_name, unordered_map<string, int> constants, unsigned int rng_seed, const string& capture_path = "", const string& replay_path = "")
 	{
+		istringstream replay;
+		if (!replay_path.empty())
+		{
+			replay.str(transcript::load_replay(replay_path, rng_seed));
+			input::set_source(replay);
+		}
+		if (!capture_path.empty())
+			transcript::start_capture(capture_path, rng_seed);
+
 		Game game(constants);
 		/* Warmup */
 		/* End Warmup */
@@ -181,10 +181,10 @@ Fill positions of enemies this turn
 void NavigationManager::fill_positions_enemies(const Game& game)
 {
 	positions_enemies.clear();
-	for (vector<MapCell>& row : game.game_map->cells)
-		for (MapCell& cell : row)
-			if (cell.is_occupied_by_enemy(game.me->id))
-				positions_enemies[cell.ship] = cell.ship->position;
+	for (const auto& player : game.players)
+		if (player->id != game.me->id)
+			for (auto& ship_iterator : player->ships)
+				positions_enemies[ship_iterator.second] = ship_iterator.second->position;
 }
 
 /*
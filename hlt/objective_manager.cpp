@@ -1,5 +1,6 @@
 #include "objective_manager.hpp"
 #include "game.hpp"
+#include "lazy_greedy.hpp"
 
 using namespace hlt;
 using namespace std;
@@ -34,40 +35,40 @@ int ObjectiveManager::max_allowed_dropoffs(const Game& game) const
 
 	if (game.is_four_player_game())
 	{
-		if (game.scorer.halite_initial <= 120000)
+		if (game.map_statistics.initial_total() <= 120000)
 			base_dropoffs = 0;
-		else if (game.scorer.halite_initial <= 250000)
+		else if (game.map_statistics.initial_total() <= 250000)
 			base_dropoffs = 1;
-		else if (game.scorer.halite_initial <= 400000)
+		else if (game.map_statistics.initial_total() <= 400000)
 			base_dropoffs = 2;
-		else if (game.scorer.halite_initial <= 550000)
+		else if (game.map_statistics.initial_total() <= 550000)
 			base_dropoffs = 3;
-		else if (game.scorer.halite_initial <= 700000)
+		else if (game.map_statistics.initial_total() <= 700000)
 			base_dropoffs = 4;
-		else if (game.scorer.halite_initial <= 850000)
+		else if (game.map_statistics.initial_total() <= 850000)
 			base_dropoffs = 5;
-		else if (game.scorer.halite_initial <= 1000000)
+		else if (game.map_statistics.initial_total() <= 1000000)
 			base_dropoffs = 6;
 		else
 			base_dropoffs = 7;
 	}
 	else
 	{
-		if (game.scorer.halite_initial <= 100000)
+		if (game.map_statistics.initial_total() <= 100000)
 			base_dropoffs = 0;
-		else if (game.scorer.halite_initial <= 200000)
+		else if (game.map_statistics.initial_total() <= 200000)
 			base_dropoffs = 1;
-		else if (game.scorer.halite_initial <= 300000)
+		else if (game.map_statistics.initial_total() <= 300000)
 			base_dropoffs = 2;
-		else if (game.scorer.halite_initial <= 400000)
+		else if (game.map_statistics.initial_total() <= 400000)
 			base_dropoffs = 3;
-		else if (game.scorer.halite_initial <= 500000)
+		else if (game.map_statistics.initial_total() <= 500000)
 			base_dropoffs = 4;
-		else if (game.scorer.halite_initial <= 600000)
+		else if (game.map_statistics.initial_total() <= 600000)
 			base_dropoffs = 5;
-		else if (game.scorer.halite_initial <= 700000)
+		else if (game.map_statistics.initial_total() <= 700000)
 			base_dropoffs = 6;
-		else if (game.scorer.halite_initial <= 800000)
+		else if (game.map_statistics.initial_total() <= 800000)
 			base_dropoffs = 7;
 		else
 			base_dropoffs = 8;
@@ -95,9 +96,10 @@ vector<Objective> ObjectiveManager::create_dropoff_objectives(const Game& game)
 
 	pair<MapCell*, double> action = game.scorer.find_best_dropoff_cell(game.me->shipyard, dropoffs, game);
 
-	log::log("Dropoff objective: " + action.first->position.to_string_position() + " with score " + to_string(action.second));
+	Position target = game.game_map->position(action.first);
+	log::log("Dropoff objective: " + target.to_string_position() + " with score " + to_string(action.second) + ", region halite " + to_string(game.map_statistics.region_total(target)));
 
-	return vector<Objective>{Objective(0, Objective_Type::MAKE_DROPOFF, action.first->position)};
+	return vector<Objective>{Objective(0, Objective_Type::MAKE_DROPOFF, target)};
 }
 
 bool ObjectiveManager::should_spawn_dropoff(const Game& game, vector<Objective> objectives_dropoffs)
@@ -181,6 +183,11 @@ void ObjectiveManager::assign_objectives(Game& game)
 
 		// refresh shipyards to account for potentially newly placed
 		game.distance_manager.fill_closest_shipyard_or_dropoff(game);
+		game.scorer.grids.touch(GridSource::BASE_DISTANCES);
+#if HALITE_DEBUG
+		if ((objective_id != -1) || (game.turn_number % DistanceManager::CHECK_PERIOD == 0))
+			game.distance_manager.check(game);
+#endif
 	}
 
 	/*
@@ -199,37 +206,40 @@ void ObjectiveManager::assign_objectives(Game& game)
 					// capture ships to blockade
 					((ship->halite < 50) && (2 * game.distance(ship->position, game.get_closest_enemy_shipyard_or_dropoff(ship)) >= game.turns_remaining())) ||
 					// also do when no halite left
-					((ship->halite < 50) && (game.turns_remaining() <= 60) && (game.scorer.halite_total < 2000)) ||
+					((ship->halite < 50) && (game.turns_remaining() <= 60) && (game.map_statistics.total() < 2000)) ||
 					// convert ships to blockade from suicide if low halite
 					(ship->is_objective(Objective_Type::SUICIDE_ON_BASE) && (ship->halite < 40))
 				)
 			)
 				ships_to_block[ship] = 0.0;
 
-		while (ships_to_block.size())
-		{
-			shared_ptr<Ship> best_ship;
-			Objective best_objective = Objective();
-			double best_score = -DBL_MAX;
+		// Ships in the order of the map, the first one wins on equal scores
+		vector<shared_ptr<Ship>> ships;
+		for (const auto& ship : ships_to_block)
+			ships.push_back(ship.first);
 
-			for (const auto& ship : ships_to_block)
-			{
-				Objective objective = game.blocker.find_best_objective_cell(ship.first, game);
+		LazyGreedy greedy;
+		greedy.reset((int)ships.size());
+		auto search = [&ships, &game](int candidate) { return game.blocker.find_best_objective_cell(ships[candidate], game); };
 
-				if (objective.score > best_score)
-				{
-					best_ship = ship.first;
-					best_score = objective.score;
-					best_objective = objective;
-				}
-			}
+		while (!greedy.empty())
+		{
+			int best = greedy.pop(search);
+#if HALITE_DEBUG
+			if (game.turn_number % LazyGreedy::CHECK_PERIOD == 0)
+				greedy.check(best, search);
+#endif
+			shared_ptr<Ship> best_ship = ships[best];
+			Objective best_objective = greedy.objective(best);
+			double best_score = best_objective.score;
 
 			log::log(best_ship->to_string_ship() + " blocking area " + best_objective.target_position.to_string_position() + " with score " + to_string(best_score));
 
+			// Only the score of that position decreases
 			game.blocker.decrease_score_in_position(best_objective.target_position, game);
+			greedy.invalidate([&best_objective](const Objective& objective) { return objective.target_position == best_objective.target_position; });
 			best_ship->assign_objective(best_objective);
 			best_ship->set_assigned();
-			ships_to_block.erase(best_ship);
 		}
 	}
 
@@ -291,47 +301,58 @@ void ObjectiveManager::assign_objectives(Game& game)
 			if (!ship->assigned)
 				ships_without_objectives[ship] = 0.0;
 
-		while (ships_without_objectives.size())
-		{
-			shared_ptr<Ship> best_ship;
-			Objective best_objective = Objective();
-			double best_score = -DBL_MAX;
+		// Ships in the order of the map, the first one wins on equal scores
+		vector<shared_ptr<Ship>> ships;
+		for (const auto& ship : ships_without_objectives)
+			ships.push_back(ship.first);
 
-			for (const auto& ship : ships_without_objectives)
-			{
-				Objective objective = game.scorer.find_best_objective_cell(ship.first, game);
+		LazyGreedy greedy;
+		greedy.reset((int)ships.size());
+		auto search = [&ships, &game](int candidate) { return game.scorer.find_best_objective_cell(ships[candidate], game); };
+		const WrapTable& wrap = game.game_map->wrap;
 
-				if (objective.score > best_score)
-				{
-					best_ship = ship.first;
-					best_score = objective.score;
-					best_objective = objective;
-				}
-			}
+		while (!greedy.empty())
+		{
+			int best = greedy.pop(search);
+#if HALITE_DEBUG
+			if (game.turn_number % LazyGreedy::CHECK_PERIOD == 0)
+				greedy.check(best, search);
+#endif
+			shared_ptr<Ship> best_ship = ships[best];
+			Objective best_objective = greedy.objective(best);
+			double best_score = best_objective.score;
+			const Position target = best_objective.target_position;
 
 			if (best_objective.type == Objective_Type::ATTACK)
 			{
-				log::log(best_ship->to_string_ship() + " attacking enemy on " + best_objective.target_position.to_string_position() + " with score " + to_string(best_score));
+				log::log(best_ship->to_string_ship() + " attacking enemy on " + target.to_string_position() + " with score " + to_string(best_score));
 
-				game.ship_on_position(best_objective.target_position)->set_targeted();
+				// The targeted enemy is no longer attacked, which only lowers the score of its cell
+				game.ship_on_position(target)->set_targeted();
+				greedy.invalidate([&target](const Objective& objective) { return objective.target_position == target; });
 				best_ship->assign_objective(best_objective);
 			}
 			else if (best_objective.type == Objective_Type::EXTRACT_ZONE)
 			{
-				log::log(best_ship->to_string_ship() + " assigned to area " + best_objective.target_position.to_string_position() + " with score " + to_string(best_score));
+				log::log(best_ship->to_string_ship() + " assigned to area " + target.to_string_position() + " with score " + to_string(best_score));
 
-				game.scorer.decreases_score_in_target_cell(best_ship, best_objective.target_position, 0.0, game);
-				game.scorer.decreases_score_in_target_area(best_ship, best_objective.target_position, game);
-				game.assign_objective(best_ship, Objective_Type::EXTRACT_ZONE, best_objective.target_position, best_score);
+				game.scorer.decreases_score_in_target_cell(best_ship, target, 0.0, game);
+				game.scorer.decreases_score_in_target_area(best_ship, target, game);
+				greedy.invalidate([&wrap, &target](const Objective& objective)
+				{
+					return (wrap.distances_x_from(target.x)[objective.target_position.x] <= Scorer::TARGET_AREA_RADIUS) &&
+						(wrap.distances_y_from(target.y)[objective.target_position.y] <= Scorer::TARGET_AREA_RADIUS);
+				});
+				game.assign_objective(best_ship, Objective_Type::EXTRACT_ZONE, target, best_score);
 			}
 			else
 			{
 				log::log("Unknown objective in greedy method");
 				exit(1);
 			}
-
-			ships_without_objectives.erase(best_ship);
 		}
+
+		log::log("Greedy allocation: " + to_string(greedy.searches) + " searches for " + to_string(ships.size()) + " ships");
 	}
 }
 
@@ -7,7 +7,11 @@
 using namespace hlt;
 using namespace std;
 
-void PathFinder::log_path(vector<MapCell*>& optimal_path, const Game& game) const
+// Looked up for every expanded cell, built once so that the lookup does not allocate
+static const string CONSTANT_HEURISTIC = "A* Heuristic";
+static const string CONSTANT_RADIUS_SHIPS_SEEN = "A* Radius Ships Seen";
+
+void PathFinder::log_path(const CellPath& optimal_path, const Game& game) const
 {
 	log::log("Optimal path:");
 	for (int y = 0; y < game.game_map->height; ++y)
@@ -16,7 +20,7 @@ void PathFinder::log_path(vector<MapCell*>& optimal_path, const Game& game) cons
 		string line = "" + padding + to_string(y) + " | ";
 
 		for (int x = 0; x < game.game_map->width; ++x)
-			if (find(optimal_path.begin(), optimal_path.end(), &game.game_map->cells[y][x]) != optimal_path.end())
+			if (find(optimal_path.begin(), optimal_path.end(), game.game_map->cell(x, y)) != optimal_path.end())
 				line += "X ";
 			else
 				line += "O ";
@@ -25,7 +29,7 @@ void PathFinder::log_path(vector<MapCell*>& optimal_path, const Game& game) cons
 	}
 	log::log("");
 }
-void PathFinder::log_costs(unordered_map<MapCell*, int> cost_so_far, const Game& game) const
+void PathFinder::log_costs(const CellCosts& cost_so_far, const Game& game) const
 {
 	log::log("Optimal path:");
 	for (int y = 0; y < game.game_map->height; ++y)
@@ -34,8 +38,8 @@ void PathFinder::log_costs(unordered_map<MapCell*, int> cost_so_far, const Game&
 		string line = "" + padding + to_string(y) + " | ";
 
 		for (int x = 0; x < game.game_map->width; ++x)
-			if (cost_so_far.count(&game.game_map->cells[y][x]))
-				line += to_string(cost_so_far[&game.game_map->cells[y][x]]) + " ";
+			if (cost_so_far.count(game.game_map->cell(x, y)))
+				line += to_string(cost_so_far.at(game.game_map->cell(x, y))) + " ";
 			else
 				line += "0 ";
 
@@ -64,6 +68,8 @@ Position PathFinder::compute_path(shared_ptr<Ship> ship, const Position& positio
 
 Position PathFinder::compute_direct_path_rtb(const Position& source_position, const Position& target_position, Game& game)
 {
+	ArenaScope scope; // search state of this path only
+
 	if ((source_position == target_position) || (game.distance(source_position, target_position) == 1))
 		return target_position;
 
@@ -73,12 +79,12 @@ Position PathFinder::compute_direct_path_rtb(const Position& source_position, co
 	bool add_burned = !game.switch_to_half_full_for_rtb(game.ship_on_position(source_position));
 
 	//clock_t start = clock();
-	vector<MapCell*> optimal_path = dijkstra_rtb(source_cell, target_cell, game, add_burned);
+	CellPath optimal_path = dijkstra_rtb(source_cell, target_cell, game, add_burned);
 	//log::log("Dijkstra for " + source_position.to_string_position() + " to " + target_position.to_string_position() + " took: " + to_string((clock() - start) / (double)CLOCKS_PER_SEC));
 
 	if (optimal_path.size() > 1)
 	{
-		return optimal_path.at(1)->position;
+		return game.game_map->position(optimal_path.at(1));
 	}
 	else
 		return source_position;
@@ -86,6 +92,8 @@ Position PathFinder::compute_direct_path_rtb(const Position& source_position, co
 
 Position PathFinder::compute_direct_path_attack(const Position& source_position, const Position& target_position, Game& game)
 {
+	ArenaScope scope; // search state of this path only
+
 	if ((source_position == target_position) || (game.distance(source_position, target_position) == 1))
 		return target_position;
 
@@ -93,12 +101,12 @@ Position PathFinder::compute_direct_path_attack(const Position& source_position,
 	MapCell* target_cell = game.game_map->at(target_position);
 
 	//clock_t start = clock();
-	vector<MapCell*> optimal_path = dijkstra_attack(source_cell, target_cell, game);
+	CellPath optimal_path = dijkstra_attack(source_cell, target_cell, game);
 	//log::log("Dijkstra for " + source_position.to_string_position() + " to " + target_position.to_string_position() + " took: " + to_string((clock() - start) / (double)CLOCKS_PER_SEC));
 
 	if (optimal_path.size() > 1)
 	{
-		return optimal_path.at(1)->position;
+		return game.game_map->position(optimal_path.at(1));
 	}
 	else
 		return source_position;
@@ -106,6 +114,8 @@ Position PathFinder::compute_direct_path_attack(const Position& source_position,
 
 Position PathFinder::compute_direct_path_no_base(const Position& source_position, const Position& target_position, Game& game)
 {
+	ArenaScope scope; // search state of this path only
+
 	Position enemy_base = game.get_closest_enemy_shipyard_or_dropoff(target_position);
 
 	if ((source_position == target_position) || (game.distance(source_position, target_position) == 1))
@@ -116,17 +126,19 @@ Position PathFinder::compute_direct_path_no_base(const Position& source_position
 	MapCell* enemy_base_cell = game.game_map->at(enemy_base);
 
 	//clock_t start = clock();
-	vector<MapCell*> optimal_path = dijkstra_block(source_cell, target_cell, enemy_base_cell, game);
+	CellPath optimal_path = dijkstra_block(source_cell, target_cell, enemy_base_cell, game);
 	//log::log("Dijkstra for " + source_position.to_string_position() + " to " + target_position.to_string_position() + " took: " + to_string((clock() - start) / (double)CLOCKS_PER_SEC));
 
 	if (optimal_path.size() > 1)
-		return optimal_path.at(1)->position;
+		return game.game_map->position(optimal_path.at(1));
 	else
-		return source_cell->position;
+		return game.game_map->position(source_cell);
 }
 
 Position PathFinder::compute_direct_path_suicide(const Position& source_position, const Position& target_position, Game& game)
 {
+	ArenaScope scope; // search state of this path only
+
 	if ((source_position == target_position) || (game.distance(source_position, target_position) == 1))
 		return target_position;
 
@@ -134,13 +146,13 @@ Position PathFinder::compute_direct_path_suicide(const Position& source_position
 	MapCell* target_cell = game.game_map->at(target_position);
 
 	//clock_t start = clock();
-	vector<MapCell*> optimal_path = dijkstra_suicide(source_cell, target_cell, target_cell, game);
+	CellPath optimal_path = dijkstra_suicide(source_cell, target_cell, target_cell, game);
 	//log::log("Dijkstra for " + source_position.to_string_position() + " to " + target_position.to_string_position() + " took: " + to_string((clock() - start) / (double)CLOCKS_PER_SEC));
 
 	if (optimal_path.size() > 1)
-		return optimal_path.at(1)->position;
+		return game.game_map->position(optimal_path.at(1));
 	else
-		return source_cell->position;
+		return game.game_map->position(source_cell);
 }
 
 Position PathFinder::compute_direct_path(const Position& source_position, const Position& target_position, Game& game)
@@ -151,6 +163,8 @@ Position PathFinder::compute_direct_path(const Position& source_position, const
 
 Position PathFinder::compute_shortest_path(const Position& source_position, const Position& target_position, Game& game)
 {
+	ArenaScope scope; // search state of this path only
+
 	if ((source_position == target_position) || (game.distance(source_position, target_position) == 1))
 		return target_position;
 
@@ -158,72 +172,54 @@ Position PathFinder::compute_shortest_path(const Position& source_position, cons
 	MapCell* target_cell = game.game_map->at(target_position);
 
 	//clock_t start = clock();
-	vector<MapCell*> optimal_path = dijkstra_path(source_cell, target_cell, game);
+	CellPath optimal_path = dijkstra_path(source_cell, target_cell, game);
 	//log::log("Dijkstra for " + source_position.to_string_position() + " to " + target_position.to_string_position() + " took: " + to_string((clock() - start) / (double)CLOCKS_PER_SEC));
 
 	if (optimal_path.size() > 1)
-		return optimal_path.at(1)->position;
+		return game.game_map->position(optimal_path.at(1));
 	else
-		return source_cell->position;
+		return game.game_map->position(source_cell);
 }
 
-vector<MapCell*> PathFinder::adjacent_cells_filtered(MapCell* source_cell, MapCell* target_cell, MapCell* cell, const Game& game)
+AdjacentCells PathFinder::adjacent_cells_filtered(MapCell* source_cell, MapCell* target_cell, MapCell* cell, const Game& game)
 {
 	// We add cells either if they are far (we expect things to move away from them),
 	// or if they are marked as allies, or if it's target cell
 	
-	vector<MapCell*> adjacent_cells;
-
-	Position north_position = game.game_map->directional_offset(cell->position, Direction::NORTH);
-	int north_distance = game.game_map->calculate_distance(source_cell->position, north_position);
-	if ((north_distance > 4) || (game.scorer.get_grid_score_move(north_position) < 9) || (north_position == target_cell->position))
-		adjacent_cells.push_back(game.game_map->at(north_position));
+	AdjacentCells adjacent_cells;
+	Position source_position = game.game_map->position(source_cell);
 
-	Position south_position = game.game_map->directional_offset(cell->position, Direction::SOUTH);
-	int south_distance = game.game_map->calculate_distance(source_cell->position, south_position);
-	if ((south_distance > 4) || (game.scorer.get_grid_score_move(south_position) < 9) || (south_position == target_cell->position))
-		adjacent_cells.push_back(game.game_map->at(south_position));
-
-	Position east_position = game.game_map->directional_offset(cell->position, Direction::EAST);
-	int east_distance = game.game_map->calculate_distance(source_cell->position, east_position);
-	if ((east_distance > 4) || (game.scorer.get_grid_score_move(east_position) < 9) || (east_position == target_cell->position))
-		adjacent_cells.push_back(game.game_map->at(east_position));
+	for (int index : game.game_map->wrap.neighbors_of(game.game_map->index(cell)))
+	{
+		MapCell* adjacent_cell = game.game_map->cell(index);
+		Position adjacent_position = game.game_map->position(adjacent_cell);
+		int distance = game.game_map->calculate_distance(source_position, adjacent_position);
 
-	Position west_position = game.game_map->directional_offset(cell->position, Direction::WEST);
-	int west_distance = game.game_map->calculate_distance(source_cell->position, west_position);
-	if ((west_distance > 4) || (game.scorer.get_grid_score_move(west_position) < 9) || (west_position == target_cell->position))
-		adjacent_cells.push_back(game.game_map->at(west_position));
+		if ((distance > 4) || (game.scorer.get_grid_score_move(adjacent_position) < 9) || (adjacent_cell == target_cell))
+			adjacent_cells.push_back(adjacent_cell);
+	}
 
 	return adjacent_cells;
 }
 
-vector<MapCell*> PathFinder::adjacent_cells_all(MapCell* cell, const Game& game)
+AdjacentCells PathFinder::adjacent_cells_all(MapCell* cell, const Game& game)
 {
-	vector<MapCell*> adjacent_cells;
-
-	Position north_position = game.game_map->directional_offset(cell->position, Direction::NORTH);
-	adjacent_cells.push_back(game.game_map->at(north_position));
-
-	Position south_position = game.game_map->directional_offset(cell->position, Direction::SOUTH);
-	adjacent_cells.push_back(game.game_map->at(south_position));
-
-	Position east_position = game.game_map->directional_offset(cell->position, Direction::EAST);
-	adjacent_cells.push_back(game.game_map->at(east_position));
+	AdjacentCells adjacent_cells;
 
-	Position west_position = game.game_map->directional_offset(cell->position, Direction::WEST);
-	adjacent_cells.push_back(game.game_map->at(west_position));
+	for (int index : game.game_map->wrap.neighbors_of(game.game_map->index(cell)))
+		adjacent_cells.push_back(game.game_map->cell(index));
 
 	return adjacent_cells;
 }
 
-vector<MapCell*> PathFinder::reconstruct_path(MapCell* source_cell, MapCell* target_cell, unordered_map<MapCell*, MapCell*> came_from)
+CellPath PathFinder::reconstruct_path(MapCell* source_cell, MapCell* target_cell, const CellParents& came_from)
 {
-	vector<MapCell*> path;
+	CellPath path;
 	MapCell* current = target_cell;
 	while (current != source_cell) 
 	{
 		path.push_back(current);
-		current = came_from[current];
+		current = came_from.at(current);
 	}
 	path.push_back(source_cell);
 	reverse(path.begin(), path.end());
@@ -235,8 +231,8 @@ int PathFinder::compute_next_step_score(MapCell* source_cell, MapCell* current_c
 	int move_score = (int)floor(0.1 * current_cell->halite);
 
 	// Only apply bad score for enemies/allies if they are very close
-	if (game.distance(source_cell->position, next_cell->position) <= game.get_constant("A* Radius Ships Seen"))
-		move_score += (game.scorer.get_grid_score_move(next_cell->position) > 0) * 999999; //cannot put INT_MAX as it's going to be summed up after
+	if (game.distance(game.game_map->position(source_cell), game.game_map->position(next_cell)) <= game.get_constant(CONSTANT_RADIUS_SHIPS_SEEN))
+		move_score += (game.scorer.get_grid_score_move(game.game_map->position(next_cell)) > 0) * 999999; //cannot put INT_MAX as it's going to be summed up after
 
 	return move_score;
 }
@@ -248,17 +244,17 @@ int PathFinder::compute_next_step_score_rtb(MapCell* source_cell, MapCell* curre
 	if (add_burned)
 		move_score += (int)floor(0.1 * current_cell->halite);
 
-	int score = game.scorer.get_grid_score_move(next_cell->position);
+	int score = game.scorer.get_grid_score_move(game.game_map->position(next_cell));
 
 	// Only apply bad score for enemies/allies if they are very close
-	int distance = game.distance(source_cell->position, next_cell->position);
+	int distance = game.distance(game.game_map->position(source_cell), game.game_map->position(next_cell));
 	if (distance <= 4)
 		move_score += (int)((score > 2) * 100.0 * (4.0 - (double)distance) / 4.0);
 
 	if (distance <= 3)
 	{
-		shared_ptr<Ship> ship = game.ship_on_position(source_cell->position);
-		double danger_cell = game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, next_cell->position);
+		shared_ptr<Ship> ship = game.ship_on_position(game.game_map->position(source_cell));
+		double danger_cell = game.scorer.get_score_ship_can_move_to_dangerous_cell(ship, game.game_map->position(next_cell), game);
 		move_score += (int)((score == 9) * 2.0 * max(-danger_cell, 0.0) * (3.0 - (double)distance) / 3.0);
 	}
 
@@ -270,26 +266,26 @@ int PathFinder::compute_next_step_score_rtb(MapCell* source_cell, MapCell* curre
 
 inline int PathFinder::heuristic(MapCell* cell, MapCell* target_cell, const Game& game) const
 {
-	return game.get_constant("A* Heuristic") * game.game_map->calculate_distance(cell->position, target_cell->position);
+	return game.get_constant(CONSTANT_HEURISTIC) * game.game_map->calculate_distance(game.game_map->position(cell), game.game_map->position(target_cell));
 }
 
-vector<MapCell*> PathFinder::dijkstra_rtb(MapCell* source_cell, MapCell* target_cell, const Game& game, bool add_burned) const
+CellPath PathFinder::dijkstra_rtb(MapCell* source_cell, MapCell* target_cell, const Game& game, bool add_burned) const
 {
-	unordered_map<MapCell*, MapCell*> came_from;
+	CellParents came_from;
 	came_from[source_cell] = source_cell;
 
-	PriorityQueue<MapCell*, int> frontier;
+	CellFrontier frontier;
 	frontier.put(source_cell, 0);
 
-	unordered_map<MapCell*, int> cost_so_far;
+	CellCosts cost_so_far;
 	cost_so_far[source_cell] = 0;
 
 	while (!frontier.empty())
 	{
 		MapCell* current_cell = frontier.get();
-		vector<MapCell*> adjacent_cells = adjacent_cells_all(current_cell, game);
+		AdjacentCells adjacent_cells = adjacent_cells_all(current_cell, game);
 
-		if (current_cell->position == target_cell->position)
+		if (current_cell == target_cell)
 			return reconstruct_path(source_cell, target_cell, came_from);
 
 		for (MapCell* next_cell : adjacent_cells)
@@ -300,7 +296,7 @@ vector<MapCell*> PathFinder::dijkstra_rtb(MapCell* source_cell, MapCell* target_
 			{
 				cost_so_far[next_cell] = new_cost;
 				came_from[next_cell] = current_cell;
-				frontier.put(next_cell, new_cost + 10 * game.distance(next_cell->position, target_cell->position));
+				frontier.put(next_cell, new_cost + 10 * game.distance(game.game_map->position(next_cell), game.game_map->position(target_cell)));
 			}
 		}
 	}
@@ -308,22 +304,22 @@ vector<MapCell*> PathFinder::dijkstra_rtb(MapCell* source_cell, MapCell* target_
 	return reconstruct_path(source_cell, target_cell, came_from);
 }
 
-vector<MapCell*> PathFinder::dijkstra_path(MapCell* source_cell, MapCell* target_cell, const Game& game) const
+CellPath PathFinder::dijkstra_path(MapCell* source_cell, MapCell* target_cell, const Game& game) const
 {
-	unordered_map<MapCell*, MapCell*> came_from;
+	CellParents came_from;
 	came_from[source_cell] = source_cell;
 
-	PriorityQueue<MapCell*, int> frontier;
+	CellFrontier frontier;
 	frontier.put(source_cell, 0);
 
-	unordered_map<MapCell*, int> cost_so_far;
+	CellCosts cost_so_far;
 	cost_so_far[source_cell] = 0;
 
 	while (!frontier.empty())
 	{
 		MapCell* current_cell = frontier.get();
 
-		if (current_cell->position == target_cell->position)
+		if (current_cell == target_cell)
 			return reconstruct_path(source_cell, target_cell, came_from);
 
 		for (MapCell* next_cell : adjacent_cells_filtered(source_cell, target_cell, current_cell, game))
@@ -339,7 +335,7 @@ vector<MapCell*> PathFinder::dijkstra_path(MapCell* source_cell, MapCell* target
 		}
 	}
 
-	return vector<MapCell*>(1, source_cell);
+	return CellPath(1, source_cell);
 }
 
 int PathFinder::compute_next_step_score_block(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, MapCell* enemy_base, const Game& game) const
@@ -349,37 +345,37 @@ int PathFinder::compute_next_step_score_block(MapCell* source_cell, MapCell* cur
 	if (next_cell->has_structure())
 		move_score = 4;
 
-	if (game.game_map->calculate_distance_inf(next_cell->position, enemy_base->position) == 1)
+	if (game.game_map->calculate_distance_inf(game.game_map->position(next_cell), game.game_map->position(enemy_base)) == 1)
 		move_score = 0;
 
-	if ((game.scorer.get_grid_score_move(next_cell->position) > 0) && (game.scorer.get_grid_score_move(next_cell->position) < 9))
+	if ((game.scorer.get_grid_score_move(game.game_map->position(next_cell)) > 0) && (game.scorer.get_grid_score_move(game.game_map->position(next_cell)) < 9))
 		move_score = 10;
 
-	if (game.scorer.get_grid_score_move(next_cell->position) == 10)
+	if (game.scorer.get_grid_score_move(game.game_map->position(next_cell)) == 10)
 		move_score = 999;
 
 	return move_score;
 }
 
-vector<MapCell*> PathFinder::dijkstra_block(MapCell* source_cell, MapCell* target_cell, MapCell* enemy_base, const Game& game) const
+CellPath PathFinder::dijkstra_block(MapCell* source_cell, MapCell* target_cell, MapCell* enemy_base, const Game& game) const
 {
-	unordered_map<MapCell*, MapCell*> came_from;
+	CellParents came_from;
 	came_from[source_cell] = source_cell;
 
-	PriorityQueue<MapCell*, int> frontier;
+	CellFrontier frontier;
 	frontier.put(source_cell, 0);
 
-	unordered_map<MapCell*, int> cost_so_far;
+	CellCosts cost_so_far;
 	cost_so_far[source_cell] = 0;
 
 	while (!frontier.empty())
 	{
 		MapCell* current_cell = frontier.get();
 
-		if (current_cell->position == target_cell->position)
+		if (current_cell == target_cell)
 			return reconstruct_path(source_cell, target_cell, came_from);
 
-		//log::log("Current cell:" + current_cell->position.to_string_position());
+		//log::log("Current cell:" + game.game_map->position(current_cell).to_string_position());
 
 		for (MapCell* next_cell : adjacent_cells_all(current_cell, game))
 		{
@@ -394,42 +390,42 @@ vector<MapCell*> PathFinder::dijkstra_block(MapCell* source_cell, MapCell* targe
 		}
 	}
 
-	return vector<MapCell*>(1, source_cell);
+	return CellPath(1, source_cell);
 }
 
 int PathFinder::compute_next_step_score_suicide(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, MapCell* base, const Game& game) const
 {
 	int move_score = 1;
 
-	if (game.game_map->calculate_distance(source_cell->position, next_cell->position) <= game.get_constant("A* Radius Ships Seen"))
-		move_score += (game.scorer.get_grid_score_move(next_cell->position) > 0) * 999999;
+	if (game.game_map->calculate_distance(game.game_map->position(source_cell), game.game_map->position(next_cell)) <= game.get_constant(CONSTANT_RADIUS_SHIPS_SEEN))
+		move_score += (game.scorer.get_grid_score_move(game.game_map->position(next_cell)) > 0) * 999999;
 
 	if (
-		(game.game_map->calculate_distance(source_cell->position, base->position) <= 4) ||
+		(game.game_map->calculate_distance(game.game_map->position(source_cell), game.game_map->position(base)) <= 4) ||
 		(game.turns_remaining() <= 8)
 	)
-		if (game.scorer.get_grid_score_move(next_cell->position) >= 9)
+		if (game.scorer.get_grid_score_move(game.game_map->position(next_cell)) >= 9)
 			move_score = 1;
 
 	return move_score;
 }
 
-vector<MapCell*> PathFinder::dijkstra_suicide(MapCell* source_cell, MapCell* target_cell, MapCell* base, const Game& game) const
+CellPath PathFinder::dijkstra_suicide(MapCell* source_cell, MapCell* target_cell, MapCell* base, const Game& game) const
 {
-	unordered_map<MapCell*, MapCell*> came_from;
+	CellParents came_from;
 	came_from[source_cell] = source_cell;
 
-	PriorityQueue<MapCell*, int> frontier;
+	CellFrontier frontier;
 	frontier.put(source_cell, 0);
 
-	unordered_map<MapCell*, int> cost_so_far;
+	CellCosts cost_so_far;
 	cost_so_far[source_cell] = 0;
 
 	while (!frontier.empty())
 	{
 		MapCell* current_cell = frontier.get();
 
-		if (current_cell->position == target_cell->position)
+		if (current_cell == target_cell)
 			return reconstruct_path(source_cell, target_cell, came_from);
 
 		for (MapCell* next_cell : adjacent_cells_all(current_cell, game))
@@ -445,13 +441,13 @@ vector<MapCell*> PathFinder::dijkstra_suicide(MapCell* source_cell, MapCell* tar
 		}
 	}
 
-	return vector<MapCell*>(1, source_cell);
+	return CellPath(1, source_cell);
 }
 
 int PathFinder::compute_next_step_score_attack(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, const Game& game) const
 {
 	int move_score = 10;
-	int score = game.scorer.get_grid_score_move(next_cell->position);
+	int score = game.scorer.get_grid_score_move(game.game_map->position(next_cell));
 
 	// do not go straight on enemy cell
 	move_score += ((score != 0) && (score != 9)) * 9999999;
@@ -459,23 +455,23 @@ int PathFinder::compute_next_step_score_attack(MapCell* source_cell, MapCell* cu
 	return move_score;
 }
 
-vector<MapCell*> PathFinder::dijkstra_attack(MapCell* source_cell, MapCell* target_cell, const Game& game) const
+CellPath PathFinder::dijkstra_attack(MapCell* source_cell, MapCell* target_cell, const Game& game) const
 {
-	unordered_map<MapCell*, MapCell*> came_from;
+	CellParents came_from;
 	came_from[source_cell] = source_cell;
 
-	PriorityQueue<MapCell*, int> frontier;
+	CellFrontier frontier;
 	frontier.put(source_cell, 0);
 
-	unordered_map<MapCell*, int> cost_so_far;
+	CellCosts cost_so_far;
 	cost_so_far[source_cell] = 0;
 
 	while (!frontier.empty())
 	{
 		MapCell* current_cell = frontier.get();
-		vector<MapCell*> adjacent_cells = adjacent_cells_all(current_cell, game);
+		AdjacentCells adjacent_cells = adjacent_cells_all(current_cell, game);
 
-		if (current_cell->position == target_cell->position)
+		if (current_cell == target_cell)
 			return reconstruct_path(source_cell, target_cell, came_from);
 
 		for (MapCell* next_cell : adjacent_cells)
@@ -486,7 +482,7 @@ vector<MapCell*> PathFinder::dijkstra_attack(MapCell* source_cell, MapCell* targ
 			{
 				cost_so_far[next_cell] = new_cost;
 				came_from[next_cell] = current_cell;
-				frontier.put(next_cell, new_cost + 10 * game.distance(next_cell->position, target_cell->position));
+				frontier.put(next_cell, new_cost + 10 * game.distance(game.game_map->position(next_cell), game.game_map->position(target_cell)));
 			}
 		}
 	}
@@ -7,6 +7,8 @@
 #include "command.hpp"
 #include "map_cell.hpp"
 #include "priority_queue.hpp"
+#include "arena.hpp"
+#include "small_vector.hpp"
 
 #include <vector>
 #include <algorithm>
@@ -18,6 +20,14 @@ using namespace std;
 namespace hlt
 {
 	struct Game;
+
+	// Search state lives in the turn arena, a search allocates nothing on the heap
+	typedef ArenaVector<MapCell*> CellPath;
+	typedef ArenaUnorderedMap<MapCell*, MapCell*> CellParents;
+	typedef ArenaUnorderedMap<MapCell*, int> CellCosts;
+	typedef PriorityQueue<MapCell*, int, ArenaAllocator<pair<int, MapCell*>>> CellFrontier;
+	typedef SmallVector<MapCell*, 4> AdjacentCells;
+
 	class PathFinder
 	{
 		private:
@@ -35,31 +45,31 @@ namespace hlt
 		Position compute_direct_path_attack(const Position& source_position, const Position& target_position, Game& game);
 
 		// Dijkstra suicide
-		vector<MapCell*> dijkstra_suicide(MapCell* source_cell, MapCell* target_cell, MapCell* enemy_base, const Game& game) const;
+		CellPath dijkstra_suicide(MapCell* source_cell, MapCell* target_cell, MapCell* enemy_base, const Game& game) const;
 		int compute_next_step_score_suicide(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, MapCell* enemy_base, const Game& game) const;
 
 		// Dijkstra block
-		vector<MapCell*> dijkstra_block(MapCell* source_cell, MapCell* target_cell, MapCell* enemy_base, const Game& game) const;
+		CellPath dijkstra_block(MapCell* source_cell, MapCell* target_cell, MapCell* enemy_base, const Game& game) const;
 		int compute_next_step_score_block(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, MapCell* enemy_base, const Game& game) const;
 
 		// Dijkstra RTB
-		vector<MapCell*> dijkstra_rtb(MapCell* source_cell, MapCell* target_cell, const Game& game, bool add_burned) const;
+		CellPath dijkstra_rtb(MapCell* source_cell, MapCell* target_cell, const Game& game, bool add_burned) const;
 		int compute_next_step_score_rtb(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, const Game& game, bool add_burned) const;
 
 		// Dijkstra Attack
-		vector<MapCell*> dijkstra_attack(MapCell* source_cell, MapCell* target_cell, const Game& game) const;
+		CellPath dijkstra_attack(MapCell* source_cell, MapCell* target_cell, const Game& game) const;
 		int compute_next_step_score_attack(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, const Game& game) const;
 
 		// Dijkstra
 		Position compute_shortest_path(const Position& source_position, const Position& target_position, Game& game);
-		static vector<MapCell*> reconstruct_path(MapCell* source_cell, MapCell* target_cell, unordered_map<MapCell*, MapCell*> came_from);
-		static vector<MapCell*> adjacent_cells_filtered(MapCell* source_cell, MapCell* target_cell, MapCell* cell, const Game& game);
-		static vector<MapCell*> adjacent_cells_all(MapCell* cell, const Game& game);
+		static CellPath reconstruct_path(MapCell* source_cell, MapCell* target_cell, const CellParents& came_from);
+		static AdjacentCells adjacent_cells_filtered(MapCell* source_cell, MapCell* target_cell, MapCell* cell, const Game& game);
+		static AdjacentCells adjacent_cells_all(MapCell* cell, const Game& game);
 		inline int heuristic(MapCell* cell, MapCell* target_cell, const Game& game) const;
 		int compute_next_step_score(MapCell* source_cell, MapCell* current_cell, MapCell* next_cell, const Game& game) const;
-		vector<MapCell*> dijkstra_path(MapCell* source_cell, MapCell* target_cell, const Game& game) const;
+		CellPath dijkstra_path(MapCell* source_cell, MapCell* target_cell, const Game& game) const;
 
-		void log_path(vector<MapCell*>& optimal_path, const Game& game) const;
-		void log_costs(unordered_map<MapCell*, int> cost_so_far, const Game& game) const;
+		void log_path(const CellPath& optimal_path, const Game& game) const;
+		void log_costs(const CellCosts& cost_so_far, const Game& game) const;
 	};
 }
\ No newline at end of file
@@ -2,51 +2,104 @@
 #include "input.hpp"
 #include "priority_queue.hpp"
 
+#include <algorithm>
+
 using namespace hlt;
 using namespace std;
 
-void Player::_update(int num_ships, int num_dropoffs, Halite halite) 
+void Player::_update(int num_ships, int num_dropoffs, Halite halite, int turn_number, ShipPool& ship_pool) 
 {
     this->halite = halite;
 
-	// Regenerate ships, but keep objectives
-	unordered_map<EntityId, shared_ptr<Ship>> old_ships = ships;
-
-    ships.clear();
+	// Ships alive last turn are updated in place and keep their slot and objective,
+	// new ships get a slot in the pool and are appended to my_ships
     for (int i = 0; i < num_ships; ++i) 
 	{
-		shared_ptr<Ship> new_ship = Ship::_generate(id);
+        EntityId ship_id = input::read_int();
+        int x = input::read_int();
+        int y = input::read_int();
+        Halite ship_halite = input::read_int();
+
+        auto ship_iterator = ships.find(ship_id);
+        if (ship_iterator == ships.end())
+        {
+            ship_iterator = ships.emplace(ship_id, ship_pool.acquire(id, ship_id, x, y, ship_halite)).first;
+            my_ships.push_back(ship_iterator->second);
+        }
+        else
+        {
+            Ship& ship = *ship_iterator->second;
+            Position previous_position = ship.position;
+            Halite previous_halite = ship.halite;
+            ship._update(x, y, ship_halite);
 
-		if (old_ships.find(new_ship->id) != old_ships.end())
-		{
-			shared_ptr<Ship> old_ship = old_ships[new_ship->id];
-			new_ship->assign_objective(old_ship);
-		}
+            if (ship.position != previous_position)
+                ship_pool.moved(ship_iterator->second, previous_position);
+            if (ship.halite != previous_halite)
+                ship_pool.cargo_changed();
+        }
 
-        ships[new_ship->id] = new_ship;
+        ship_iterator->second->last_seen_turn = turn_number;
     }
-	old_ships.clear();
 
-	// Regenerate dropoffs
-    dropoffs.clear();
+	// Ships missing from the frame were destroyed or turned into dropoffs
+    if (ships.size() != (size_t)num_ships)
+    {
+        for (auto ship_iterator = ships.begin(); ship_iterator != ships.end();)
+        {
+            if (ship_iterator->second->last_seen_turn != turn_number)
+            {
+                ship_pool.release(ship_iterator->second);
+                ship_iterator = ships.erase(ship_iterator);
+            }
+            else
+                ++ship_iterator;
+        }
+
+        my_ships.erase(
+            remove_if(my_ships.begin(), my_ships.end(), [turn_number](const shared_ptr<Ship>& ship) { return ship->last_seen_turn != turn_number; }),
+            my_ships.end()
+        );
+    }
+
+	// Dropoffs are never destroyed, but fake ones placed during last turn must go
+    dropoffs_changed = false;
     for (int i = 0; i < num_dropoffs; ++i) 
 	{
-        shared_ptr<Dropoff> dropoff = Dropoff::_generate(id);
-        dropoffs[dropoff->id] = dropoff;
+        EntityId dropoff_id = input::read_int();
+        int x = input::read_int();
+        int y = input::read_int();
+
+        auto dropoff_iterator = dropoffs.find(dropoff_id);
+        if (dropoff_iterator == dropoffs.end())
+        {
+            dropoff_iterator = dropoffs.emplace(dropoff_id, make_shared<Dropoff>(id, dropoff_id, x, y)).first;
+            dropoffs_changed = true;
+        }
+
+        dropoff_iterator->second->last_seen_turn = turn_number;
     }
 
-	// Vector of my ships
-	my_ships.clear();
-	for (const auto& ship : ships)
-		my_ships.push_back(ship.second);
+    if (dropoffs.size() != (size_t)num_dropoffs)
+    {
+        for (auto dropoff_iterator = dropoffs.begin(); dropoff_iterator != dropoffs.end();)
+        {
+            if (dropoff_iterator->second->last_seen_turn != turn_number)
+            {
+                dropoff_iterator = dropoffs.erase(dropoff_iterator);
+                dropoffs_changed = true;
+            }
+            else
+                ++dropoff_iterator;
+        }
+    }
 }
 
 shared_ptr<Player> Player::_generate() 
 {
-    PlayerId player_id;
-    int shipyard_x;
-    int shipyard_y;
-    get_sstream() >> player_id >> shipyard_x >> shipyard_y;
+    PlayerId player_id = input::read_int();
+    int shipyard_x = input::read_int();
+    int shipyard_y = input::read_int();
 
     return make_shared<Player>(player_id, shipyard_x, shipyard_y);
 }
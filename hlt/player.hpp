@@ -4,6 +4,7 @@
 #include "shipyard.hpp"
 #include "ship.hpp"
 #include "dropoff.hpp"
+#include "ship_pool.hpp"
 #include "input.hpp"
 
 #include <memory>
@@ -22,15 +23,17 @@ namespace hlt
         unordered_map<EntityId, shared_ptr<Ship>> ships;
         unordered_map<EntityId, shared_ptr<Dropoff>> dropoffs;
 		vector<shared_ptr<Ship>> my_ships;
+		bool dropoffs_changed; // dropoffs added or removed by the last frame
 
         Player(PlayerId player_id, int shipyard_x, int shipyard_y) :
             id(player_id),
             shipyard(make_shared<Shipyard>(player_id, shipyard_x, shipyard_y)),
-            halite(0)
+            halite(0),
+            dropoffs_changed(false)
         {}
 
 		// Functions for new turn logic
-		void _update(int num_ships, int num_dropoffs, Halite halite);
+		void _update(int num_ships, int num_dropoffs, Halite halite, int turn_number, ShipPool& ship_pool);
 		static shared_ptr<Player> _generate();
     };
 }
@@ -7,10 +7,10 @@ using namespace std;
 
 namespace hlt 
 {
-	template<typename T, typename priority_t> struct PriorityQueue
+	template<typename T, typename priority_t, typename Allocator = allocator<pair<priority_t, T>>> struct PriorityQueue
 	{
 		typedef pair<priority_t, T> PQElement;
-		priority_queue<PQElement, vector<PQElement>, greater<PQElement>> elements;
+		priority_queue<PQElement, vector<PQElement, Allocator>, greater<PQElement>> elements;
 
 		inline bool empty() const 
 		{
@@ -4,62 +4,177 @@
 using namespace hlt;
 using namespace std;
 
+constexpr double Scorer::NO_DANGER;
+
+// Grids kept across turns follow the cell changes of the frames after the turn they were updated on
+static bool follows_turn(int turn, const Game& game)
+{
+	return (game.turn_number == turn) || (game.turn_number == turn + 1);
+}
+
+void hlt::Scorer::register_grids(const Game& game)
+{
+	typedef GridRegistry::Evaluation Evaluation;
+
+	// grid_score_move is changed by the moves of the turn, the extract smooth grid by the objectives
+	grids.add(GRID_MOVE, "grid_score_move", { GridSource::HALITE, GridSource::SHIPS, GridSource::CARGO, GridSource::STRUCTURES, GridSource::TURN }, {}, {},
+		Evaluation::EAGER, [this, &game]() { update_grid_score_move(game); });
+	// Reads the distance fields, a frame task outside the registry: only required after the frame tasks, never from a grid task
+	grids.add(GRID_ENEMIES, "grid_score_enemies", { GridSource::SHIPS }, {}, {},
+		Evaluation::ON_REQUEST, [this, &game]() { update_grid_score_enemies(game); });
+	grids.add(GRID_INSPIRATION, "grid_score_inspiration", { GridSource::SHIPS }, {}, {},
+		Evaluation::EAGER, [this, &game]() { update_grid_score_inspiration(game); });
+	grids.add(GRID_NEIGHBOR_CELL, "grid_score_neighbor_cell", { GridSource::HALITE, GridSource::STRUCTURES }, {}, {},
+		Evaluation::LAZY, [this, &game]() { update_grid_score_neighbor_cell(game); });
+	grids.add(GRID_EXTRACT, "grid_score_extract", { GridSource::HALITE, GridSource::STRUCTURES, GridSource::TURN }, { GRID_INSPIRATION }, { GRID_NEIGHBOR_CELL },
+		Evaluation::EAGER, [this, &game]() { update_grid_score_extract(game); });
+	grids.add(GRID_DROPOFF, "grid_score_dropoff", { GridSource::HALITE, GridSource::STRUCTURES }, { GRID_INSPIRATION }, {},
+		Evaluation::LAZY, [this, &game]() { update_grid_score_dropoff(game); });
+	grids.add(GRID_TARGETS, "grid_score_targets", { GridSource::SHIPS, GridSource::CARGO }, {}, {},
+		Evaluation::EAGER, [this, &game]() { update_grid_score_targets(game); });
+	grids.add(GRID_COMBAT_CACHE, "combat_cache", { GridSource::HALITE, GridSource::SHIPS, GridSource::CARGO, GridSource::STRUCTURES }, { GRID_INSPIRATION, GRID_TARGETS }, {},
+		Evaluation::EAGER, [this, &game]() { update_combat_cache(game); });
+	grids.add(GRID_CAN_STAY_STILL, "grid_score_can_stay_still", { GridSource::HALITE, GridSource::SHIPS, GridSource::CARGO, GridSource::STRUCTURES }, { GRID_MOVE, GRID_TARGETS, GRID_COMBAT_CACHE }, {},
+		Evaluation::EAGER, [this, &game]() { update_grid_score_can_stay_still(game); });
+	grids.add(GRID_DANGEROUS_CELL, "grid_ship_can_move_to_dangerous_cell", { GridSource::HALITE, GridSource::SHIPS, GridSource::CARGO, GridSource::TURN }, { GRID_MOVE, GRID_INSPIRATION, GRID_TARGETS, GRID_COMBAT_CACHE }, {},
+		Evaluation::EAGER, [this, &game]() { update_grid_ship_can_move_to_dangerous_cell(game); });
+	// Reads the distances of the distance manager task, so only built when the objective search requires it
+	grids.add(GRID_HALITE_PYRAMID, "halite_pyramid", { GridSource::STRUCTURES, GridSource::BASE_DISTANCES }, { GRID_EXTRACT }, {},
+		Evaluation::ON_REQUEST, [this, &game]() { halite_pyramid.build(grid_score_extract_smooth, game.distance_manager.distance_cell_shipyard_or_dropoff); });
+}
+void hlt::Scorer::begin_turn(const Game& game)
+{
+	if (grids.empty())
+		register_grids(game);
+	grids.begin_turn();
+
+	const ShipEvents& events = game.game_map->ship_pool.events;
+	if (!game.game_map->changes.empty())
+		grids.touch(GridSource::HALITE);
+	if (!events.spawned.empty() || !events.destroyed.empty() || !events.moved.empty())
+		grids.touch(GridSource::SHIPS);
+	if (events.cargo_changes > 0)
+		grids.touch(GridSource::CARGO);
+	for (auto& player : game.players)
+		if (player->dropoffs_changed)
+			grids.touch(GridSource::STRUCTURES);
+}
+
 void hlt::Scorer::update_grid_score_inspiration(const Game& game)
 {
 	Stopwatch s("Updating grid_score_inspiration");
 
-	int width = game.game_map->width;
-	int height = game.game_map->height;
+	// Count grids are kept across turns and follow the ship changes of the turn
+	if (game.turn_number == inspiration_turn)
+		return;
 
-	for (int i = 0; i < height; ++i)
-	for (int j = 0; j < width; ++j)
+	if ((inspiration_turn < 0) || (game.turn_number != inspiration_turn + 1))
+		rebuild_grid_score_inspiration(game);
+	else
 	{
-		grid_score_inspiration[i][j] = 0;
-		grid_score_inspiration_enemies[i][j] = 0;
-		grid_score_enemies_distance_2[i][j] = 0;
-		grid_score_enemies_distance_5[i][j] = 0;
-		grid_score_inspiration_enemies_6[i][j] = 0;
+		const ShipEvents& events = game.game_map->ship_pool.events;
+
+		for (const shared_ptr<Ship>& ship : events.destroyed)
+			stamp_ship_inspiration(game, ship->owner, ship->position, -1);
+		for (const shared_ptr<Ship>& ship : events.spawned)
+			stamp_ship_inspiration(game, ship->owner, ship->position, 1);
+		for (const ShipMove& move : events.moved)
+			move_ship_inspiration(game, move.ship->owner, move.from, move.ship->position);
+
+#if HALITE_DEBUG
+		if (game.turn_number % INSPIRATION_CHECK_PERIOD == 0)
+			check_grid_score_inspiration(game);
+#endif
 	}
 
+	inspiration_turn = game.turn_number;
+
+	//log::log_grid(grid_score_inspiration);
+	//log::log_grid(grid_score_inspiration_enemies);
+	//log::log_grid(grid_score_enemies_distance_2);
+	//log::log_grid(grid_score_enemies_distance_5);
+	//log::log_grid(grid_score_inspiration_enemies_6);
+}
+SmallVector<pair<GridView<int>*, int>, 3> hlt::Scorer::inspiration_stamps(const Game& game, PlayerId owner)
+{
+	if (owner == game.my_id)
+		return { make_pair(&grid_score_inspiration_enemies, 4), make_pair(&grid_score_inspiration_enemies_6, 6) };
+	else
+		return { make_pair(&grid_score_inspiration, 4), make_pair(&grid_score_enemies_distance_2, 2), make_pair(&grid_score_enemies_distance_5, 5) };
+}
+void hlt::Scorer::stamp_ship_inspiration(const Game& game, PlayerId owner, const Position& position, int count)
+{
+	for (auto& stamp : inspiration_stamps(game, owner))
+		for (const WrappedCell& cell : game.game_map->wrap.diamond(position.x, position.y, stamp.second))
+			(*stamp.first)[cell.y][cell.x] += count;
+}
+void hlt::Scorer::move_ship_inspiration(const Game& game, PlayerId owner, const Position& from, const Position& to)
+{
+	// Ships move one step at most, anything else is removed and added back
+	if (game.distance(from, to) != 1)
+	{
+		stamp_ship_inspiration(game, owner, from, -1);
+		stamp_ship_inspiration(game, owner, to, 1);
+		return;
+	}
+
+	const WrapTable& wrap = game.game_map->wrap;
+	Direction direction = game.game_map->get_move(from, to);
+
+	for (auto& stamp : inspiration_stamps(game, owner))
+	{
+		for (const WrappedCell& cell : wrap.diamond_entering(to.x, to.y, stamp.second, direction))
+			(*stamp.first)[cell.y][cell.x] += 1;
+		for (const WrappedCell& cell : wrap.diamond_leaving(to.x, to.y, stamp.second, direction))
+			(*stamp.first)[cell.y][cell.x] -= 1;
+	}
+}
+void hlt::Scorer::check_grid_score_inspiration(const Game& game)
+{
+	Grid<int> incremental = inspiration_planes;
+	rebuild_grid_score_inspiration(game);
+
+	// The rebuild is kept
+	if (incremental != inspiration_planes)
+		log::log("Error: Scorer: incremental inspiration grids differ from a full rebuild on turn " + to_string(game.turn_number));
+}
+void hlt::Scorer::rebuild_grid_score_inspiration(const Game& game)
+{
+	inspiration_planes.fill(0);
+
+	// Every ship stamps the cells of its diamond: radius 6 for my ships, radius 5 for enemies
+	const WrapTable& wrap = game.game_map->wrap;
+
 	for (const auto& player : game.players)
-	for (auto& ship_iterator : player->ships)
 	{
-		for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
-		{
-			if (game.distance(ship_iterator.second->position, Position(j, i)) <= 4)
-			{
-				if (player->id == game.my_id)
-					grid_score_inspiration_enemies[i][j] += 1;
-				else
-					grid_score_inspiration[i][j] += 1;
-			}
+		bool is_me = (player->id == game.my_id);
 
-			if (game.distance(ship_iterator.second->position, Position(j, i)) <= 2)
-			{
-				if (player->id != game.my_id)
-					grid_score_enemies_distance_2[i][j] += 1;
-			}
+		for (auto& ship_iterator : player->ships)
+		{
+			const Position& ship_position = ship_iterator.second->position;
 
-			if (game.distance(ship_iterator.second->position, Position(j, i)) <= 5)
+			if (is_me)
 			{
-				if (player->id != game.my_id)
-					grid_score_enemies_distance_5[i][j] += 1;
+				for (const WrappedCell& cell : wrap.diamond(ship_position.x, ship_position.y, 6))
+				{
+					if (cell.distance <= 4)
+						grid_score_inspiration_enemies[cell.y][cell.x] += 1;
+					grid_score_inspiration_enemies_6[cell.y][cell.x] += 1;
+				}
 			}
-
-			if (game.distance(ship_iterator.second->position, Position(j, i)) <= 6)
+			else
 			{
-				if (player->id == game.my_id)
-					grid_score_inspiration_enemies_6[i][j] += 1;
+				for (const WrappedCell& cell : wrap.diamond(ship_position.x, ship_position.y, 5))
+				{
+					if (cell.distance <= 4)
+						grid_score_inspiration[cell.y][cell.x] += 1;
+					if (cell.distance <= 2)
+						grid_score_enemies_distance_2[cell.y][cell.x] += 1;
+					grid_score_enemies_distance_5[cell.y][cell.x] += 1;
+				}
 			}
 		}
 	}
-
-	//log::log_vectorvector(grid_score_inspiration);
-	//log::log_vectorvector(grid_score_inspiration_enemies);
-	//log::log_vectorvector(grid_score_enemies_distance_2);
-	//log::log_vectorvector(grid_score_enemies_distance_5);
-	//log::log_vectorvector(grid_score_inspiration_enemies_6);
 }
 void hlt::Scorer::update_grid_score_move(const Game& game)
 {
@@ -74,16 +189,12 @@ void hlt::Scorer::update_grid_score_move(const Game& game)
 			grid_score_move[i][j] = 0;
 
 			// If enemy with non lots of halite is in contiguous cell, 9
-			if (
-				game.enemy_in_cell(game.game_map->directional_offset(Position(j, i), Direction::NORTH)) ||
-				game.enemy_in_cell(game.game_map->directional_offset(Position(j, i), Direction::SOUTH)) ||
-				game.enemy_in_cell(game.game_map->directional_offset(Position(j, i), Direction::EAST)) ||
-				game.enemy_in_cell(game.game_map->directional_offset(Position(j, i), Direction::WEST))
-			)
-				grid_score_move[i][j] = 9;
+			for (int neighbor : game.game_map->wrap.neighbors_of(i * width + j))
+				if (game.enemy_in_cell(*game.game_map->cell(neighbor)))
+					grid_score_move[i][j] = 9;
 
 			// if enemy on cell, 10
-			if (game.game_map->cells[i][j].is_occupied_by_enemy(game.my_id))
+			if (game.game_map->cell(j, i)->is_occupied_by_enemy(game.my_id))
 				grid_score_move[i][j] = 10;
 
 			// Shipyard should be accessible all the time.
@@ -91,45 +202,80 @@ void hlt::Scorer::update_grid_score_move(const Game& game)
 				grid_score_move[i][j] = 0;
 
 			// Allies that won't be able to move anyway
-			if (game.game_map->cells[i][j].is_occupied_by_ally(game.my_id) && !game.ship_can_move(game.game_map->cells[i][j].ship))
+			if (game.game_map->cell(j, i)->is_occupied_by_ally(game.my_id) && !game.ship_can_move(game.game_map->ship_in_cell(game.game_map->cell(j, i))))
 				grid_score_move[i][j] = 3;
 		}
 
 	/*log::log("grid_score_move");
-	log::log_vectorvector(grid_score_move);*/
+	log::log_grid(grid_score_move);*/
 }
-void hlt::Scorer::update_grid_score_neighbor_cell(const Game& game)
+void hlt::Scorer::update_grid_score_neighbor_cell(const Game& game, bool rebuild)
 {
 	Stopwatch s("Updating grid_score_neighbor_cell");
 
+	const WrapTable& wrap = game.game_map->wrap;
 	int width = game.game_map->width;
 	int height = game.game_map->height;
 
 	int radius = 2;
 
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
-		{
-			grid_score_neighbor_cell[i][j] = 0.0;
+	// Only rich cells count, and only cells set by the frame may have changed since the last turn
+	bool incremental = !rebuild && neighbor_sums.is_built() && follows_turn(neighbor_turn, game);
+	neighbor_turn = game.turn_number;
+	auto rich_halite = [&game](int index) { int halite = game.game_map->cell(index)->halite; return (halite > 500) ? halite : 0; };
 
-			for (int k = 0; k <= radius * 2; ++k)
-				for (int l = 0; l <= radius * 2; ++l)
-				{
-					int new_k = (((i - radius + k) % width) + width) % width;
-					int new_l = (((j - radius + l) % height) + height) % height;
+	neighbor_sums.begin(wrap, radius);
+	if (incremental)
+		for (const CellChange& change : game.game_map->changes)
+			neighbor_sums.set(change.index, rich_halite(change.index));
+	else
+		for (int index = 0; index < width * height; ++index)
+			neighbor_sums.set(index, rich_halite(index));
+	neighbor_sums.update(wrap, !incremental);
+	insert_structure_cells(game, neighbor_sums.dirty);
 
-					double halite = (double)game.mapcell(new_k, new_l)->halite;
-					int distance = game.distance(Position(i, j), Position(new_k, new_l));
+	const DiamondConvolution& sums = neighbor_sums.sums();
+	for (int index : neighbor_sums.dirty)
+	{
+		double& score = grid_score_neighbor_cell[index / width][index % width];
+		score = 0.0;
 
-					if ((distance <= radius) && (halite > 500))
-						grid_score_neighbor_cell[i][j] += halite * 0.1 / (1.0 + distance);
-				}
+		for (int distance = 0; distance <= radius; ++distance)
+			score += (double)sums.ring_sum(distance, index) * 0.1 / (1.0 + distance);
 
-			if (game.is_any_shipyard_or_dropoff(Position(j, i)))
-				grid_score_neighbor_cell[i][j] = 0.0;
-		}
+		if (game.game_map->cell(index)->has_structure())
+			score = 0.0;
+	}
+
+#if HALITE_DEBUG
+	if (!rebuild && (game.turn_number % SMOOTHING_CHECK_PERIOD == 0))
+		check_smoothing_grids(game, &Scorer::update_grid_score_neighbor_cell, { &grid_score_neighbor_cell }, "grid_score_neighbor_cell");
+#endif
 
-	//log::log_vectorvector(grid_score_neighbor_cell);
+	//log::log_grid(grid_score_neighbor_cell);
+}
+void hlt::Scorer::insert_structure_cells(const Game& game, CellSet& cells) const
+{
+	for (auto& player : game.players)
+	{
+		cells.insert(game.game_map->index(player->shipyard->position));
+		for (auto& dropoff_iterator : player->dropoffs)
+			cells.insert(game.game_map->index(dropoff_iterator.second->position));
+	}
+}
+void hlt::Scorer::check_smoothing_grids(const Game& game, void (Scorer::*update)(const Game&, bool), initializer_list<Grid<double>*> grids, const string& name)
+{
+	vector<Grid<double>> incremental;
+	for (Grid<double>* grid : grids)
+		incremental.push_back(*grid);
+
+	(this->*update)(game, true);
+
+	// The rebuild is kept; sums are weighted in the same order either way, the tolerance only covers rounding
+	int i = 0;
+	for (Grid<double>* grid : grids)
+		if (!grid->nearly_equal(incremental[i++], DiamondConvolution::WEIGHTED_SUM_TOLERANCE))
+			log::log("Error: Scorer: incremental " + name + " differs from a full rebuild");
 }
 void hlt::Scorer::update_grid_score_enemies(const Game& game)
 {
@@ -137,26 +283,19 @@ void hlt::Scorer::update_grid_score_enemies(const Game& game)
 
 	int width = game.game_map->width;
 	int height = game.game_map->height;
-	grid_score_enemies = vector<vector<double>>(height, vector<double>(width, 0.0));
-
-	for (const auto& player : game.players)
-	{
-		if (player->id == game.my_id)
-			continue;
+	grid_score_enemies.resize(width, height, 1, 0.0);
 
-		for (auto& ship_iterator : player->ships)
+	// The nearest enemy ship scores the most
+	for (int i = 0; i < height; ++i)
+		for (int j = 0; j < width; ++j)
 		{
-			for (int i = 0; i < height; ++i)
-				for (int j = 0; j < width; ++j)
-				{
-					int distance = game.distance(ship_iterator.second->position, Position(j, i));
-					grid_score_enemies[i][j] = max(grid_score_enemies[i][j], (4.0 - (double)distance) / 4.0);
-				}
+			int distance = game.distance_fields.distance_enemy_ship(game.my_id, Position(j, i));
+			if (distance != DistanceFields::UNREACHED)
+				grid_score_enemies[i][j] = max(0.0, (4.0 - (double)distance) / 4.0);
 		}
-	}
 
 	//log::log("grid_score_enemies");
-	//log::log_vectorvector(grid_score_enemies);
+	//log::log_grid(grid_score_enemies);
 }
 void hlt::Scorer::add_self_ships_to_grid_score(shared_ptr<Ship> ship, const Position& position)
 {
@@ -181,166 +320,278 @@ void hlt::Scorer::add_self_ships_to_grid_score(shared_ptr<Ship> ship, const Posi
 	}
 }
 
-void hlt::Scorer::update_grid_score_dropoff(const Game& game)
+void hlt::Scorer::update_grid_score_dropoff(const Game& game, bool rebuild)
 {
 	Stopwatch s("Updating grid_score_dropoff");
 
+	const WrapTable& wrap = game.game_map->wrap;
 	int width = game.game_map->width;
 	int height = game.game_map->height;
 	int radius = 7;
 
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
+	bool incremental = !rebuild && dropoff_sums.is_built() && follows_turn(dropoff_turn, game);
+	dropoff_turn = game.turn_number;
+
+	dropoff_sums.begin(wrap, radius);
+	if (incremental)
+		for (const CellChange& change : game.game_map->changes)
+			dropoff_sums.set(change.index, game.game_map->cell(change.index)->halite);
+	else
+		for (int index = 0; index < width * height; ++index)
+			dropoff_sums.set(index, game.game_map->cell(index)->halite);
+	dropoff_sums.update(wrap, !incremental);
+
+	// Cells whose other inputs changed: own ships within 6, structures and what is within 2 of enemy structures
+	CellSet& dirty = dropoff_sums.dirty;
+	dropoff_inspiration.resize(width * height, -1);
+	for (int index = 0; index < width * height; ++index)
+	{
+		int16_t ships = (int16_t)min(max(grid_score_inspiration_enemies_6[index / width][index % width] - 3, 0), 5);
+		if (ships != dropoff_inspiration[index])
 		{
-			// Initialize to 0
-			grid_score_dropoff[i][j] = 0.0;
+			dropoff_inspiration[index] = ships;
+			dirty.insert(index);
+		}
+	}
 
-			// Halite around adds to score
-			for (int k = 0; k <= radius * 2; ++k)
-				for (int l = 0; l <= radius * 2; ++l)
-				{
-					int new_k = (((i - radius + k) % width) + width) % width;
-					int new_l = (((j - radius + l) % height) + height) % height;
-					double halite = (double)game.mapcell(new_k, new_l)->halite;
-
-					int distance = game.distance(Position(i, j), Position(new_k, new_l));
-					if (distance <= radius)
-					{
-						grid_score_dropoff[i][j] += halite;
-					}
-				}
+	insert_structure_cells(game, dirty);
+	for (int index : dropoff_blocked_cells)
+	{
+		dropoff_blocked[index] = 0;
+		dirty.insert(index);
+	}
+	dropoff_blocked.resize(width * height, 0);
+	dropoff_blocked_cells.clear();
+
+	vector<Position> enemy_structures = game.enemy_shipyard_or_dropoff_positions();
+	if (enemy_structures.empty())
+		enemy_structures.push_back(game.my_shipyard_position()); // as get_closest_enemy_shipyard_or_dropoff
+	for (const Position& structure : enemy_structures)
+		for (const WrappedCell& cell : wrap.diamond(structure.x, structure.y, 2))
+			if (!dropoff_blocked[cell.index])
+			{
+				dropoff_blocked[cell.index] = 1;
+				dropoff_blocked_cells.push_back(cell.index);
+				dirty.insert(cell.index);
+			}
 
-			// add more weight in center for 4p games, uniformly in the area.
-			if (game.is_four_player_game() && (
-				game.close_to_crowded_area(Position(j, i), width / 4) ||
-				game.close_to_axis(Position(j, i), 2)
-				))
-				grid_score_dropoff[i][j] *= 1.3;
+	// Post-processing of the dirty cells, gathered in a row so that the kernels run on them only
+	int n = dirty.size();
+	for (FloatPlane* plane : { &dropoff_plane, &dropoff_factor_plane })
+		plane->resize(n, 1);
+	for (ShortPlane* plane : { &dropoff_mask_plane, &dropoff_inspiration_plane })
+		plane->resize(n, 1);
+
+	// Halite around adds to score
+	const vector<int>& halite_around = dropoff_sums.sums().diamond_sums(radius);
+	int k = 0;
+	for (int index : dirty)
+	{
+		dropoff_plane[k] = (float)halite_around[index];
+		dropoff_inspiration_plane[k++] = dropoff_inspiration[index];
+	}
 
-			grid_score_dropoff[i][j] *= (1.0 + 0.075 * min(max(grid_score_inspiration_enemies_6[i][j] - 3, 0), 5));
+	// add more weight in center for 4p games, uniformly in the area.
+	if (game.is_four_player_game())
+	{
+		k = 0;
+		for (int index : dirty)
+		{
+			Position position = Position(index % width, index / width);
+			dropoff_mask_plane[k++] = game.close_to_crowded_area(position, width / 4) || game.close_to_axis(position, 2);
+		}
+		kernels::masked_scale(dropoff_plane, dropoff_mask_plane, 1.3f);
+	}
 
-			if (game.distance(game.get_closest_enemy_shipyard_or_dropoff(Position(j, i)), Position(j, i)) <= 2)
-				grid_score_dropoff[i][j] = 0.0;
+	// 7.5% more for each own ship within 6 over 3, up to 5
+	kernels::convert(dropoff_factor_plane, dropoff_inspiration_plane);
+	kernels::scale(dropoff_factor_plane, 0.075f);
+	kernels::add(dropoff_factor_plane, 1.0f);
+	kernels::multiply(dropoff_plane, dropoff_factor_plane);
 
-			if (game.mapcell(Position(j, i))->has_structure())
-				grid_score_dropoff[i][j] = 0.0;
-		}
+	// Nothing on structures and within 2 of the closest enemy structure
+	k = 0;
+	for (int index : dirty)
+		dropoff_mask_plane[k++] = game.game_map->cell(index)->has_structure() || dropoff_blocked[index];
+	kernels::masked_assign(dropoff_plane, dropoff_mask_plane, 0.0f);
+
+	k = 0;
+	for (int index : dirty)
+		grid_score_dropoff[index / width][index % width] = (double)dropoff_plane[k++];
+
+#if HALITE_DEBUG
+	if (!rebuild && (game.turn_number % SMOOTHING_CHECK_PERIOD == 0))
+		check_smoothing_grids(game, &Scorer::update_grid_score_dropoff, { &grid_score_dropoff }, "grid_score_dropoff");
+#endif
 
-	//log::log_vectorvector(grid_score_dropoff);
+	//log::log_grid(grid_score_dropoff);
 }
-void hlt::Scorer::update_grid_score_extract(const Game& game)
+void hlt::Scorer::update_grid_score_extract(const Game& game, bool rebuild)
 {
 	Stopwatch s("Updating grid_score_extract");
 
+	const WrapTable& wrap = game.game_map->wrap;
 	int width = game.game_map->width;
 	int height = game.game_map->height;
 	int radius = game.get_constant("Score: Smoothing radius");
-	double halite_multiplier = 3.0;
+	int halite_multiplier = 3;
+	bool late = (game.turns_remaining_percent() <= 0.33);
 
+	bool incremental = !rebuild && extract_sums.is_built() && follows_turn(extract_turn, game) && (late == extract_late);
+	extract_turn = game.turn_number;
+	extract_late = late;
+
+	// Add bonus for inspiration; it follows the ships, which the frame's cell changes do not list, so every cell is set
+	extract_sums.begin(wrap, radius);
 	for (int i = 0; i < height; ++i)
 		for (int j = 0; j < width; ++j)
 		{
-			// Initialize to 0
-			grid_score_extract_smooth[i][j] = 0.0;
-			grid_score_extract_nearby[i][j] = 0.0;
-			grid_score_extract[i][j] = 0.0;
-
-			// Halite around adds to score
-			for (int k = 0; k <= radius * 2; ++k)
-				for (int l = 0; l <= radius * 2; ++l)
-				{
-					int new_k = (((i - radius + k) % width) + width) % width;
-					int new_l = (((j - radius + l) % height) + height) % height;
-					double halite = (double)game.mapcell(new_k, new_l)->halite;
+			int halite = game.game_map->cell(j, i)->halite;
+			extract_sums.set(i * width + j, (grid_score_inspiration[i][j] >= 2) ? halite * halite_multiplier : halite);
+		}
+	extract_sums.update(wrap, !incremental);
+
+	// Cells whose other inputs changed: enemies within 2, structures, and the neighbor cell score late in the game
+	CellSet& dirty = extract_sums.dirty;
+	extract_exponents.resize(width * height, -1);
+	for (int index = 0; index < width * height; ++index)
+	{
+		int16_t exponent = (int16_t)min(max(grid_score_enemies_distance_2[index / width][index % width] - 4, 0), (int)kernels::MAX_EXPONENT);
+		if (exponent != extract_exponents[index])
+		{
+			extract_exponents[index] = exponent;
+			dirty.insert(index);
+		}
+	}
 
-					// Add bonus for inspiration
-					if (grid_score_inspiration[new_k][new_l] >= 2)
-						halite *= halite_multiplier;
+	insert_structure_cells(game, dirty);
+	if (late)
+	{
+		// The neighbor cell score is only read late in the game
+		grids.require(GRID_NEIGHBOR_CELL);
+		for (int index : neighbor_sums.dirty)
+			dirty.insert(index);
+	}
 
-					int distance = game.distance(Position(i, j), Position(new_k, new_l));
-					if (distance <= radius)
-						grid_score_extract_smooth[i][j] += halite / max((double)distance, 1.0);
-				}
+	// Post-processing of the dirty cells, gathered in a row so that the kernels run on them only
+	int n = dirty.size();
+	for (FloatPlane* plane : { &extract_dirty_smooth, &extract_dirty_nearby, &extract_dirty_halite, &extract_factor_plane })
+		plane->resize(n, 1);
+	for (ShortPlane* plane : { &extract_mask_plane, &extract_exponent_plane })
+		plane->resize(n, 1);
+
+	// Halite around adds to score, weighted by 1 / distance: ring d weighs 1 / max(d, 1), so
+	// the diamond of radius d weighs 1 / max(d, 1) - 1 / (d + 1)
+	const DiamondConvolution& sums = extract_sums.sums();
+	kernels::fill(extract_dirty_smooth, 0.0f);
+	for (int distance = 0; distance <= radius; ++distance)
+	{
+		double weight = 1.0 / max((double)distance, 1.0) - ((distance < radius) ? 1.0 / (distance + 1.0) : 0.0);
+		const vector<int>& diamond_sums = sums.diamond_sums(distance);
+		int k = 0;
+		for (int index : dirty)
+			extract_factor_plane[k++] = (float)diamond_sums[index];
+		kernels::multiply_add(extract_dirty_smooth, extract_factor_plane, (float)weight);
+	}
 
-			// Any structure has 0 score
-			if (game.mapcell(Position(j, i))->has_structure())
-				grid_score_extract_smooth[i][j] = 0.0;
+	// Any structure has 0 score
+	int k = 0;
+	for (int index : dirty)
+		extract_mask_plane[k++] = game.game_map->cell(index)->has_structure();
+	kernels::masked_assign(extract_dirty_smooth, extract_mask_plane, 0.0f);
 
-			grid_score_extract_nearby[i][j] = grid_score_extract_smooth[i][j];
+	kernels::copy(extract_dirty_nearby, extract_dirty_smooth);
 
-			if (game.is_four_player_game() && (game.game_map->width <= 48))
-			{
-				int distance_inf_from_shipyard = game.game_map->calculate_distance_inf(Position(j, i), game.my_shipyard_position());
-				int base_to_axis = width / 4;
-				int margin = width / 8 - 1;
-				double multiplier = 1.5;
-
-				grid_score_extract_smooth[i][j] *= strangle(
-					distance_inf_from_shipyard,
-					base_to_axis - margin,
-					base_to_axis - margin + 2,
-					base_to_axis + margin - 2,
-					base_to_axis + margin,
-					1.0,
-					multiplier,
-					multiplier,
-					0.9
-				);
-
-				if (game.close_to_crowded_area(Position(j, i), margin + 1))
-					grid_score_extract_smooth[i][j] *= multiplier;
-			}
+	if (game.is_four_player_game() && (game.game_map->width <= 48))
+	{
+		int base_to_axis = width / 4;
+		int margin = width / 8 - 1;
+		double multiplier = 1.5;
 
-			grid_score_extract_smooth[i][j] *= pow(0.9, max(grid_score_enemies_distance_2[i][j] - 4, 0));
-			grid_score_extract[i][j] = (double)game.mapcell(Position(j, i))->halite + ((game.turns_remaining_percent() <= 0.33) ? grid_score_neighbor_cell[i][j] : 0.0);
+		k = 0;
+		for (int index : dirty)
+		{
+			Position position = Position(index % width, index / width);
+			extract_dirty_halite[k] = (float)game.game_map->calculate_distance_inf(position, game.my_shipyard_position());
+			extract_mask_plane[k++] = game.close_to_crowded_area(position, margin + 1);
 		}
 
-	//log::log_vectorvector(grid_score_extract);
-	//log::log_vectorvector(grid_score_extract_smooth);
-	//log::log_vectorvector(grid_score_extract_nearby);
+		kernels::apply(extract_factor_plane, extract_dirty_halite, PiecewiseLinear::strangle(
+			base_to_axis - margin,
+			base_to_axis - margin + 2,
+			base_to_axis + margin - 2,
+			base_to_axis + margin,
+			1.0,
+			multiplier,
+			multiplier,
+			0.9
+		));
+		kernels::multiply(extract_dirty_smooth, extract_factor_plane);
+		kernels::masked_scale(extract_dirty_smooth, extract_mask_plane, (float)multiplier);
+	}
+
+	// 0.9 for each enemy within 2 over 4
+	k = 0;
+	for (int index : dirty)
+		extract_exponent_plane[k++] = extract_exponents[index];
+	kernels::scale_by_power(extract_dirty_smooth, extract_exponent_plane, 0.9);
+
+	k = 0;
+	for (int index : dirty)
+	{
+		extract_dirty_halite[k] = (float)game.game_map->cell(index)->halite;
+		extract_factor_plane[k++] = late ? (float)grid_score_neighbor_cell[index / width][index % width] : 0.0f;
+	}
+	if (late)
+		kernels::add(extract_dirty_halite, extract_factor_plane);
+
+	k = 0;
+	for (int index : dirty)
+	{
+		extract_smooth_plane[index] = extract_dirty_smooth[k];
+		extract_nearby_plane[index] = extract_dirty_nearby[k];
+		extract_plane[index] = extract_dirty_halite[k++];
+	}
+
+	// The smooth grid is lowered by the objective assignment, so all of it is written again
+	kernels::store(extract_smooth_plane, grid_score_extract_smooth);
+	kernels::store(extract_nearby_plane, grid_score_extract_nearby);
+	kernels::store(extract_plane, grid_score_extract);
+
+#if HALITE_DEBUG
+	if (!rebuild && (game.turn_number % SMOOTHING_CHECK_PERIOD == 0))
+		check_smoothing_grids(game, &Scorer::update_grid_score_extract, { &grid_score_extract_smooth, &grid_score_extract_nearby, &grid_score_extract }, "grid_score_extract");
+#endif
+
+	//log::log_grid(grid_score_extract);
+	//log::log_grid(grid_score_extract_smooth);
+	//log::log_grid(grid_score_extract_nearby);
 }
 void hlt::Scorer::update_grid_score_targets(const Game& game)
 {
 	Stopwatch s("Updating grid_score_targets");
 
-	int width = game.game_map->width;
-	int height = game.game_map->height;
-	int radius = 5;
+	grid_score_ships_nearby.resize(game.game_map->width, game.game_map->height, (int)game.players.size(), 0.0);
 
-	grid_score_ships_nearby.clear();
+	// Enemies and allies around: every ship spreads its weight over its diamond
 	for (auto& player : game.players)
-		grid_score_ships_nearby[player->id] = vector<vector<double>>(height, vector<double>(width, 0.0));
+	{
+		double* plane = grid_score_ships_nearby.data(player->id);
 
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
+		for (auto& ship_iterator : player->ships)
 		{
-			Position position = Position(j, i);
+			const Ship& ship = *ship_iterator.second;
+			double weight = max(900.0 - (double)ship.halite, 0.0);
 
-			// Enemies and allies around
-			for (int k = 0; k <= radius * 2; ++k)
-				for (int l = 0; l <= radius * 2; ++l)
-				{
-					int new_k = (((i - radius + k) % width) + width) % width;
-					int new_l = (((j - radius + l) % height) + height) % height;
-
-					Position current_position = Position(new_l, new_k);
-					int distance = game.distance(position, current_position);
-
-					if (distance > radius)
-						continue;
-
-					if (game.position_has_ship(current_position))
-					{
-						PlayerId playerid = game.ship_on_position(current_position)->owner;
-						grid_score_ships_nearby[playerid][i][j] += max(900.0 - (double)game.mapcell(current_position)->ship->halite, 0.0) / max(1.0, (double)distance);
-					}
-				}
+			for (const WrappedCell& cell : game.game_map->wrap.diamond(ship.position.x, ship.position.y, SHIPS_NEARBY_RADIUS))
+				plane[cell.index] += weight * ships_nearby_kernel[cell.distance];
 		}
+	}
 
 	//for (auto& player : game.players)
 	//{
 	//	log::log(to_string(player->id));
-	//	log::log_vectorvector(grid_score_ships_nearby[player->id]);
+	//	log::log_grid(grid_score_ships_nearby.plane(player->id));
 	//}
 }
 void hlt::Scorer::update_grid_score_can_stay_still(const Game& game)
@@ -371,35 +622,23 @@ void hlt::Scorer::update_grid_score_can_stay_still(const Game& game)
 
 			if (game.is_two_player_game() || game.is_four_player_game())
 			{
-				// Find adjacent enemies
-				unordered_map<shared_ptr<Ship>, double> adjacent_enemies;
-				for (int k = 0; k <= 2; ++k)
-					for (int l = 0; l <= 2; ++l)
-					{
-						int new_k = (((i - 1 + k) % width) + width) % width;
-						int new_l = (((j - 1 + l) % height) + height) % height;
-						Position enemy_position = Position(new_l, new_k);
-
-						if (game.enemy_in_cell(enemy_position) && (game.distance(position, enemy_position) <= 1)) 
-							adjacent_enemies[game.mapcell(enemy_position)->ship] = 0.0;
-					}
-
-				// Fill score for attack from each adjacent enemy
-				for (auto& enemy_ship : adjacent_enemies)
+				// Worst score of an attack from each adjacent enemy, one ship per cell
+				double worst_score = 99999999.0;
+				for (const WrappedCell& cell : game.game_map->wrap.diamond(j, i, 1))
 				{
+					MapCell* map_cell = game.game_map->cell(cell.index);
+
+					if (!game.enemy_in_cell(*map_cell))
+						continue;
+
 					// can always stay next to high h ships
-					if (enemy_ship.first->halite <= 900)
-						adjacent_enemies[enemy_ship.first] = combat_score(game.ship_on_position(position), enemy_ship.first, position, game);
+					shared_ptr<Ship> enemy_ship = game.game_map->ship_in_cell(map_cell);
+					if (enemy_ship->halite <= 900)
+						worst_score = min(worst_score, combat_cache.score(game.ship_on_position(position), enemy_ship, position, *this, game));
 					else
-						adjacent_enemies[enemy_ship.first] = 9999999.0;
+						worst_score = min(worst_score, 9999999.0);
 				}
 
-				// fill worst score
-				double worst_score = 99999999.0;
-				for (auto& enemy_ship : adjacent_enemies)
-					if (enemy_ship.second < worst_score)
-						worst_score = enemy_ship.second;
-
 				grid_score_can_stay_still[i][j] = worst_score + score_bump;
 
 				// low halite ships can always stay still
@@ -408,50 +647,52 @@ void hlt::Scorer::update_grid_score_can_stay_still(const Game& game)
 			}
 		}
 
-	//log::log_vectorvector(grid_score_can_stay_still);
+	//log::log_grid(grid_score_can_stay_still);
 }
 
 double Scorer::get_score_ship_move_to_position(shared_ptr<Ship> ship, const Position& position, const Game& game) const
 {
 	// for now proxy desirability to retreat to cell by scoring with the cell with most ships around
 
-	double score;
-	for (auto& grid_it : grid_score_ships_nearby)
-		if (grid_it.first != game.my_id)
-			score = max(score, grid_it.second[position.y][position.x]);
+	// Ship pressure is never negative, no enemy reads as none around
+	double score = 0.0;
+	for (auto& player : game.players)
+		if (player->id != game.my_id)
+			score = max(score, get_grid_score_ships_nearby(player->id, position));
 
 	return score;
 }
 
 double Scorer::combat_score(shared_ptr<Ship> my_ship, shared_ptr<Ship> enemy_ship, const Position& position_to_score, const Game& game, bool big_cell) const
 {
-	double halite_ally = (double)my_ship->halite;
-	double halite_enemy = (double)enemy_ship->halite;
-	double halite_cell = (double)game.mapcell(position_to_score)->halite;
-	double halite_total = (halite_ally + halite_enemy + halite_cell);
-	
 	//int inspiration_ally = (game.scorer.get_grid_score_inspiration(position_to_score) >= 3) ? 3 : 1;
 	//int inspiration_enemy = (game.scorer.get_grid_score_inspiration_enemies(position_to_score) >= 3) ? 3 : 1;
 
 	//int distance_ally = game.distance(my_ship->position, position_to_score);
 	//int distance_enemy = game.distance(enemy_ship->position, position_to_score);
 
-	double score_attack_allies_nearby = max(get_grid_score_ships_nearby(my_ship->owner, position_to_score) - max(900.0 - halite_ally, 0.0), 0.0);
-	double score_attack_enemies_nearby = max(get_grid_score_ships_nearby(enemy_ship->owner, position_to_score) - max(900.0 - halite_enemy, 0.0), 0.0);
-
-	double proba_of_me_getting_back = (score_attack_allies_nearby + score_attack_enemies_nearby > 0.0) ? score_attack_allies_nearby / (score_attack_allies_nearby + score_attack_enemies_nearby) : 0.0;
-
-	// do not attack on enemy dropoffs
-	if (game.enemy_dropoff_in_cell(position_to_score))
-		proba_of_me_getting_back = 0.0;
-
 	//if (big_cell && (halite_cell > 800))
 	//	proba_of_me_getting_back = 1.0;
 
-	double score_ally = -halite_ally + halite_total * proba_of_me_getting_back;
-	double score_enemy = -halite_enemy + halite_total * (1.0 - proba_of_me_getting_back);
+	return CombatCache::combat_value(
+		(double)my_ship->halite,
+		(double)enemy_ship->halite,
+		(double)game.mapcell(position_to_score)->halite,
+		get_grid_score_ships_nearby(my_ship->owner, position_to_score),
+		get_grid_score_ships_nearby(enemy_ship->owner, position_to_score),
+		game.enemy_dropoff_in_cell(position_to_score)
+	);
+}
+void hlt::Scorer::update_combat_cache(const Game& game)
+{
+	Stopwatch s("Updating combat_cache");
+
+	combat_cache.begin_turn(*this, game);
 
-	return score_ally - score_enemy;
+	// Enemies next to a cell within 3 are within 4, as counted by grid_score_inspiration
+	for (const shared_ptr<Ship>& my_ship : game.me->my_ships)
+		if (grid_score_inspiration[my_ship->position.y][my_ship->position.x] > 0)
+			combat_cache.fill_window(*my_ship, *this, game);
 }
 
 Objective hlt::Scorer::find_best_objective_cell(shared_ptr<Ship> ship, const Game& game, bool verbose) const
@@ -464,71 +705,173 @@ Objective hlt::Scorer::find_best_objective_cell(shared_ptr<Ship> ship, const Gam
 
 Objective hlt::Scorer::find_best_objective_cell_2p(shared_ptr<Ship> ship, const Game& game, bool verbose) const
 {
+	bool can_attack = (ship->halite < 500) && (game.halite_on_position(ship->position) < 400);
+	Objective objective = search_objective_cell(ship, game, can_attack);
+
+	//if (verbose)
+	//{
+	//	log::log(ship->to_string_ship());
+
+	//	log::log("Grid Score Extract");
+	//	log::log_grid(grid_score_extract_smooth);
+	//}
+
+	return objective;
+}
+
+Objective hlt::Scorer::find_best_objective_cell_4p(shared_ptr<Ship> ship, const Game& game, bool verbose) const
+{
+	Objective objective = search_objective_cell(ship, game, false);
+
+	//if (verbose)
+	//{
+	//	log::log(ship->to_string_ship());
+
+	//	log::log("Grid Score Extract");
+	//	log::log_grid(grid_score_extract_smooth);
+	//}
+
+	return objective;
+}
+
+bool hlt::Scorer::is_attack_cell(int x, int y, bool can_attack, const Game& game) const
+{
+	return can_attack && (grid_score_move[y][x] == 10) && !game.ship_on_position(Position(x, y))->is_targeted;
+}
+
+Objective hlt::Scorer::search_objective_cell(const shared_ptr<Ship>& ship, const Game& game, bool can_attack) const
+{
+	ArenaScope scope; // blocks of this search only
+	grids.require(GRID_HALITE_PYRAMID);
+
 	int width = game.game_map->width;
 	int height = game.game_map->height;
+	int turns_remaining = game.turns_remaining();
+	const WrapTable& wrap = game.game_map->wrap;
+	const Grid<int>& distances_base = game.distance_manager.distance_cell_shipyard_or_dropoff;
+	const int* distances_x = wrap.distances_x_from(ship->position.x);
+	const int* distances_y = wrap.distances_y_from(ship->position.y);
 
+	// Best score, then first cell in row-major order, as the scan keeps it
 	double max_score = -DBL_MAX;
-	int max_i = 0, max_j = 0;
-	int turns_remaining = game.turns_remaining();
+	int max_index = width * height;
 	Objective_Type max_type = Objective_Type::EXTRACT_ZONE;
-	bool can_attack = (ship->halite < 500) && (game.halite_on_position(ship->position) < 400);
-
-	for (int i = 0; i < height; ++i)
-		for (int j = 0; j < width; ++j)
+	auto offer = [&](double score, int index, Objective_Type type)
+	{
+		if ((score > max_score) || ((score == max_score) && (index < max_index)))
 		{
-			Objective_Type type = Objective_Type::EXTRACT_ZONE;
-			double halite = grid_score_extract_smooth[i][j];
-			Position position = Position(j, i);
-			int distance_cell_ship = game.distance(ship->position, position);
-			int distance_cell_shipyard = game.distance_manager.get_distance_cell_shipyard_or_dropoff(position);
+			max_score = score;
+			max_index = index;
+			max_type = type;
+		}
+	};
 
-			int total_distance = distance_cell_ship + distance_cell_shipyard;
-			double total_score = halite / (1.0 + (double)total_distance);
+	// Attacked cells first and whole, the block search leaves them out
+	if (can_attack)
+		for (auto& player : game.players)
+		{
+			if (player->id == game.my_id)
+				continue;
 
-			if (
-				can_attack &&
-				(grid_score_move[i][j] == 10) &&
-				!game.ship_on_position(position)->is_targeted
-				)
+			for (auto& ship_iterator : player->ships)
 			{
-				double score_combat = combat_score(ship, game.ship_on_position(position), position, game);
-				double total_score_attack = 1.0 * max(score_combat, 0.0) / max(1.0, (double)distance_cell_ship);
+				const Position& position = ship_iterator.second->position;
+				if (!is_attack_cell(position.x, position.y, can_attack, game))
+					continue;
 
+				int distance_cell_ship = distances_x[position.x] + distances_y[position.y];
+				int total_distance = distance_cell_ship + distances_base[position.y][position.x];
+				double total_score = objective_score(grid_score_extract_smooth[position.y][position.x], total_distance);
+				Objective_Type type = Objective_Type::EXTRACT_ZONE;
+
+				double score_combat = combat_cache.enemy_cell_score(*ship, *game.ship_on_position(position), *this, game);
+				double total_score_attack = 1.0 * max(score_combat, 0.0) / max(1.0, (double)distance_cell_ship);
 				if (total_score_attack > total_score)
 				{
 					total_score = total_score_attack;
 					type = Objective_Type::ATTACK;
 				}
-			}
-
-			// Cannot go to objectives further than turns remaining
-			if ((int)(1.5 * total_distance) >= turns_remaining)
-				total_score -= 999999.0;
 
-			if (total_score > max_score)
-			{
-				max_score = total_score;
-				max_i = i;
-				max_j = j;
-				max_type = type;
+				offer(objective_reachable_score(total_score, total_distance, turns_remaining), position.y * width + position.x, type);
 			}
 		}
 
-	//if (verbose)
-	//{
-	//	log::log(ship->to_string_ship());
+	// Distance from the ship to the nearest cell of each column and row of blocks
+	const HalitePyramid::Level* levels[2] = { &halite_pyramid.coarse, &halite_pyramid.fine };
+	ArenaVector<int> block_distances_x[2], block_distances_y[2];
+	for (int level = 0; level < 2; ++level)
+	{
+		block_distances_x[level].assign(levels[level]->columns, INT_MAX);
+		block_distances_y[level].assign(levels[level]->rows, INT_MAX);
+		for (int x = 0; x < width; ++x)
+			block_distances_x[level][x / levels[level]->size] = min(block_distances_x[level][x / levels[level]->size], distances_x[x]);
+		for (int y = 0; y < height; ++y)
+			block_distances_y[level][y / levels[level]->size] = min(block_distances_y[level][y / levels[level]->size], distances_y[y]);
+	}
 
-	//	log::log("Grid Score Extract");
-	//	log::log_vectorvector(grid_score_extract_smooth);
+	// No cell of a block scores more than its best halite over its nearest distance, the penalty only lowers scores
+	auto bound = [&](int level, int column, int row)
+	{
+		double halite = levels[level]->max_value[row][column];
+		int distance = block_distances_x[level][column] + block_distances_y[level][row] + levels[level]->min_distance[row][column];
+		return (halite >= 0.0) ? objective_score(halite, distance) : 0.0;
+	};
+	auto by_bound = [](const pair<double, int>& a, const pair<double, int>& b) { return a.first > b.first; };
+
+	// Blocks by decreasing bound, down to the first one that cannot beat the best cell
+	const HalitePyramid::Level& coarse = halite_pyramid.coarse;
+	const HalitePyramid::Level& fine = halite_pyramid.fine;
+	const int ratio = HalitePyramid::COARSE / HalitePyramid::FINE;
+	ArenaVector<pair<double, int>> coarse_blocks, fine_blocks;
+	for (int row = 0; row < coarse.rows; ++row)
+		for (int column = 0; column < coarse.columns; ++column)
+			coarse_blocks.push_back(make_pair(bound(0, column, row), row * coarse.columns + column));
+	sort(coarse_blocks.begin(), coarse_blocks.end(), by_bound);
+
+	for (const pair<double, int>& coarse_block : coarse_blocks)
+	{
+		if (coarse_block.first < max_score)
+			break;
 
-	//	log::log("Total Score");
-	//	log::log_vectorvector(total_score);
-	//}
+		int coarse_row = coarse_block.second / coarse.columns, coarse_column = coarse_block.second % coarse.columns;
+		fine_blocks.clear();
+		for (int row = coarse_row * ratio; row < min((coarse_row + 1) * ratio, fine.rows); ++row)
+			for (int column = coarse_column * ratio; column < min((coarse_column + 1) * ratio, fine.columns); ++column)
+				fine_blocks.push_back(make_pair(bound(1, column, row), row * fine.columns + column));
+		sort(fine_blocks.begin(), fine_blocks.end(), by_bound);
 
-	return Objective(-1, max_type, game.mapcell(max_i, max_j)->position, max_score);
+		for (const pair<double, int>& fine_block : fine_blocks)
+		{
+			if (fine_block.first < max_score)
+				break;
+
+			int row = fine_block.second / fine.columns, column = fine_block.second % fine.columns;
+			for (int y = fine.y0(row); y < fine.y1(row, height); ++y)
+				for (int x = fine.x0(column); x < fine.x1(column, width); ++x)
+				{
+					if (is_attack_cell(x, y, can_attack, game))
+						continue;
+
+					int total_distance = distances_x[x] + distances_y[y] + distances_base[y][x];
+					double total_score = objective_reachable_score(objective_score(grid_score_extract_smooth[y][x], total_distance), total_distance, turns_remaining);
+					offer(total_score, y * width + x, Objective_Type::EXTRACT_ZONE);
+				}
+		}
+	}
+
+	if (max_index == width * height)
+		max_index = 0;
+	Objective objective = Objective(-1, max_type, Position(max_index % width, max_index / width), max_score);
+
+#if HALITE_DEBUG
+	if (game.turn_number % HalitePyramid::CHECK_PERIOD == 0)
+		check_objective_cell(ship, game, can_attack, objective);
+#endif
+
+	return objective;
 }
 
-Objective hlt::Scorer::find_best_objective_cell_4p(shared_ptr<Ship> ship, const Game& game, bool verbose) const
+Objective hlt::Scorer::scan_objective_cell(const shared_ptr<Ship>& ship, const Game& game, bool can_attack) const
 {
 	int width = game.game_map->width;
 	int height = game.game_map->height;
@@ -536,62 +879,89 @@ Objective hlt::Scorer::find_best_objective_cell_4p(shared_ptr<Ship> ship, const
 	double max_score = -DBL_MAX;
 	int max_i = 0, max_j = 0;
 	int turns_remaining = game.turns_remaining();
+	Objective_Type max_type = Objective_Type::EXTRACT_ZONE;
+	vector<int> distances(width);
 
 	for (int i = 0; i < height; ++i)
+	{
+		game.game_map->wrap.fill_distance_row(ship->position.x, ship->position.y, i, distances.data());
+
 		for (int j = 0; j < width; ++j)
 		{
+			Objective_Type type = Objective_Type::EXTRACT_ZONE;
 			double halite = grid_score_extract_smooth[i][j];
 			Position position = Position(j, i);
-			int distance_cell_ship = game.distance(ship->position, position);
+			int distance_cell_ship = distances[j];
 			int distance_cell_shipyard = game.distance_manager.get_distance_cell_shipyard_or_dropoff(position);
 
 			int total_distance = distance_cell_ship + distance_cell_shipyard;
-			double total_score = halite / (1.0 + (double)total_distance);
+			double total_score = objective_score(halite, total_distance);
 
-			// Cannot go to objectives further than turns remaining
-			if ((int)(1.5 * total_distance) >= turns_remaining)
-				total_score -= 999999.0;
+			if (is_attack_cell(j, i, can_attack, game))
+			{
+				double score_combat = combat_cache.enemy_cell_score(*ship, *game.ship_on_position(position), *this, game);
+				double total_score_attack = 1.0 * max(score_combat, 0.0) / max(1.0, (double)distance_cell_ship);
+
+				if (total_score_attack > total_score)
+				{
+					total_score = total_score_attack;
+					type = Objective_Type::ATTACK;
+				}
+			}
+
+			total_score = objective_reachable_score(total_score, total_distance, turns_remaining);
 
 			if (total_score > max_score)
 			{
 				max_score = total_score;
 				max_i = i;
 				max_j = j;
+				max_type = type;
 			}
 		}
+	}
 
-	//if (verbose)
-	//{
-	//	log::log(ship->to_string_ship());
-
-	//	log::log("Grid Score Extract");
-	//	log::log_vectorvector(grid_score_extract_smooth);
+	return Objective(-1, max_type, Position(max_j, max_i), max_score);
+}
 
-	//	log::log("Total Score");
-	//	log::log_vectorvector(total_score);
-	//}
+void hlt::Scorer::check_objective_cell(const shared_ptr<Ship>& ship, const Game& game, bool can_attack, const Objective& objective) const
+{
+	halite_pyramid.check(grid_score_extract_smooth, game.distance_manager.distance_cell_shipyard_or_dropoff);
 
-	return Objective(-1, Objective_Type::EXTRACT_ZONE, game.mapcell(max_i, max_j)->position, max_score);
+	Objective scanned = scan_objective_cell(ship, game, can_attack);
+	if ((scanned.target_position != objective.target_position) || (scanned.score != objective.score) || (scanned.type != objective.type))
+		log::log("Error: Scorer: objective search of " + ship->to_string_ship() + " found " + objective.target_position.to_string_position() + " instead of " + scanned.target_position.to_string_position());
 }
 
 pair<MapCell*, double> hlt::Scorer::find_best_dropoff_cell(shared_ptr<Shipyard> shipyard, vector<Position> dropoffs, const Game& game) const
 {
+	grids.require(GRID_DROPOFF);
+
 	int width = game.game_map->width;
 	int height = game.game_map->height;
 
-	vector<vector<double>> total_score = vector<vector<double>>(height, vector<double>(width, 0.0));
+	Grid<double> total_score(width, height);
 
 	double max_score = -999999.0;
 	int max_i = 0, max_j = 0;
 
+	// Find distance to closest shipyards
+	const WrapTable& wrap = game.game_map->wrap;
+	vector<int> distances(width * height);
+	vector<int> distances_dropoff(width * height);
+	wrap.fill_distance_grid(game.my_shipyard_position().x, game.my_shipyard_position().y, distances.data());
+
+	for (Position& shipyard_or_dropoff : dropoffs)
+	{
+		wrap.fill_distance_grid(shipyard_or_dropoff.x, shipyard_or_dropoff.y, distances_dropoff.data());
+		for (int i = 0; i < width * height; ++i)
+			distances[i] = min(distances_dropoff[i], distances[i]);
+	}
+
 	for (int i = 0; i < height; ++i)
 		for (int j = 0; j < width; ++j)
 		{
-			// Find distance to closest shipyards
-			int distance = game.distance(game.my_shipyard_position(), Position(j, i));
-
-			for (Position& shipyard_or_dropoff : dropoffs)
-				distance = min(game.distance(shipyard_or_dropoff, Position(j, i)), distance);
+			int distance = distances[i * width + j];
 			
 			total_score[i][j] = grid_score_dropoff[i][j] * butterfly(distance, 6, 14, 32, 0.0, 1.0, 0.0);
 
@@ -604,23 +974,17 @@ pair<MapCell*, double> hlt::Scorer::find_best_dropoff_cell(shared_ptr<Shipyard>
 		}
 
 	//log::log("Dropoff Score");
-	//log::log_vectorvector(grid_score_dropoff);
+	//log::log_grid(grid_score_dropoff);
 
 	//log::log("Total Score");
-	//log::log_vectorvector(total_score);
+	//log::log_grid(total_score);
 
 	return make_pair(game.mapcell(max_i, max_j), grid_score_dropoff[max_i][max_j]);
 }
 
 void hlt::Scorer::decreases_score_in_target_area(shared_ptr<Ship> ship, const Position& position, const Game& game)
 {
-	int width = game.game_map->width;
-	int height = game.game_map->height;
-
-	int target_x = position.x;
-	int target_y = position.y;
-
-	int radius = 4;
+	int radius = TARGET_AREA_RADIUS;
 	int area = 2 * radius * radius + 2 * radius + 1;
 
 	double remove_multiplier = 15.0;
@@ -628,49 +992,63 @@ void hlt::Scorer::decreases_score_in_target_area(shared_ptr<Ship> ship, const Po
 	double halite_to_decrease = max((double)ship->missing_halite(), 300.0) / (double)area * remove_multiplier;
 	// add max here?
 
-	for (int i = 0; i <= radius * 2; ++i)
-		for (int j = 0; j <= radius * 2; ++j)
-		{
-			int new_x = (((target_x - radius + i) % width) + width) % width;
-			int new_y = (((target_y - radius + j) % height) + height) % height;
-
-			// When ship assigned to an area, remove missing cargo from the zone's score in radius around.
-			if (game.distance(position, Position(new_x, new_y)) <= radius)
-				grid_score_extract_smooth[new_y][new_x] -= halite_to_decrease;
+	for (const WrappedCell& cell : game.game_map->wrap.square(position.x, position.y, radius))
+	{
+		// When ship assigned to an area, remove missing cargo from the zone's score in radius around.
+		if (cell.distance <= radius)
+			grid_score_extract_smooth[cell.y][cell.x] -= halite_to_decrease;
 
-			grid_score_extract_smooth[new_y][new_x] = max(0.0, grid_score_extract_smooth[new_y][new_x]);
-		}
+		grid_score_extract_smooth[cell.y][cell.x] = max(0.0, grid_score_extract_smooth[cell.y][cell.x]);
+	}
+	halite_pyramid.update_square(grid_score_extract_smooth, game.game_map->wrap, position.x, position.y, radius);
 
 	//log::log("Grid Score Extract");
-	//log::log_vectorvector(grid_score_extract);
+	//log::log_grid(grid_score_extract);
 }
 
 void hlt::Scorer::update_grid_ship_can_move_to_dangerous_cell(const Game& game)
 {
 	Stopwatch s("Updating grid_ship_can_move_to_dangerous_cell");
 
-	grid_ship_can_move_to_dangerous_cell.clear();
+	int slots = game.game_map->ship_pool.capacity();
+	danger_windows.resize(slots);
+	danger_window_state.assign(slots, DangerWindow::NONE);
 
 	for (const shared_ptr<Ship>& my_ship : game.me->my_ships)
 	{
-		grid_ship_can_move_to_dangerous_cell[my_ship] = unordered_map<Position, double>();
+		// Ships without a combat window have no enemy within reach
+		if (!combat_cache.has_window(my_ship->slot))
+		{
+			danger_window_state[my_ship->slot] = DangerWindow::SAFE;
+			continue;
+		}
 
-		vector<Position> dangerous_positions = game.nearby_positions_to_position(my_ship->position, 3);
+		danger_window_state[my_ship->slot] = DangerWindow::FILLED;
+		array<double, DANGER_CELLS>& window = danger_windows[my_ship->slot];
 
-		for (auto& dangerous_position : dangerous_positions)
+		for (int cell = 0; cell < DANGER_CELLS; ++cell)
 		{
-			vector<shared_ptr<Ship>> enemies = game.enemies_adjacent_to_position(dangerous_position);
+			const double* scores = combat_cache.window_scores(my_ship->slot, cell);
 
-			double score = 9999999.0;
-			for (auto& enemy_ship : enemies)
-				score = min(score, combat_score(my_ship, enemy_ship, dangerous_position, game));
+			double score = NO_DANGER;
+			for (int side = 0; side < CombatCache::SIDES; ++side)
+				score = min(score, scores[side]);
 
-			grid_ship_can_move_to_dangerous_cell[my_ship][dangerous_position] = score;
+			window[cell] = score;
 		}
 	}
 
-	//for (auto& ship_it : grid_ship_can_move_to_dangerous_cell)
-	//	for (auto& position_it : ship_it.second)
-	//		if (position_it.second != 9999999.0)
-	//			log::log(ship_it.first->to_string_ship() + " move to " + position_it.first.to_string_position() + " with score " + to_string(position_it.second));
+	//for (const shared_ptr<Ship>& my_ship : game.me->my_ships)
+	//	for (int index = 0; (danger_window_state[my_ship->slot] == DangerWindow::FILLED) && (index < DANGER_CELLS); ++index)
+	//		if (danger_windows[my_ship->slot][index] != NO_DANGER)
+	//			log::log(my_ship->to_string_ship() + " window cell " + to_string(index) + " with score " + to_string(danger_windows[my_ship->slot][index]));
+}
+double hlt::Scorer::score_ship_can_move_to_dangerous_cell(const shared_ptr<Ship>& ship, const Position& position, const Game& game) const
+{
+	// Worst combat against the enemies around the cell, as the windows hold it
+	double score = NO_DANGER;
+	for (const shared_ptr<Ship>& enemy_ship : game.enemies_adjacent_to_position(position))
+		score = min(score, combat_score(ship, enemy_ship, position, game));
+
+	return score;
 }
\ No newline at end of file
@@ -1,13 +1,24 @@
 #pragma once
 
 #include "ship.hpp"
+#include "ship_pool.hpp"
 #include "shipyard.hpp"
 #include "map_cell.hpp"
 #include "position.hpp"
 #include "stopwatch.hpp"
+#include "diamond_convolution.hpp"
+#include "small_vector.hpp"
+#include "task_graph.hpp"
+#include "grid_kernels.hpp"
+#include "combat_cache.hpp"
+#include "grid_registry.hpp"
+#include "grid.hpp"
+#include "halite_pyramid.hpp"
 
 #include <vector>
+#include <array>
 #include <utility>
+#include <initializer_list>
 
 using namespace std;
 
@@ -17,110 +28,215 @@ namespace hlt
 	class Scorer
 	{
 	public:
-		vector<vector<double>> grid_score_highway;
-		vector<vector<int>> grid_score_move;
-		vector<vector<double>> grid_score_enemies;
-
-		vector<vector<double>> grid_score_extract;
-		vector<vector<double>> grid_score_dropoff;
-		vector<vector<double>> grid_score_extract_smooth;
-		vector<vector<double>> grid_score_extract_nearby;
-		vector<vector<double>> grid_score_neighbor_cell;
-
-		vector<vector<int>> grid_score_inspiration;
-		vector<vector<int>> grid_score_inspiration_enemies;
-		vector<vector<int>> grid_score_inspiration_enemies_6;
-		vector<vector<int>> grid_score_enemies_distance_2;
-		vector<vector<int>> grid_score_enemies_distance_5;
-
-		unordered_map<PlayerId, vector<vector<double>>> grid_score_ships_nearby;
-		unordered_map<shared_ptr<Ship>, unordered_map<Position, double>> grid_ship_can_move_to_dangerous_cell;
-
-		vector<vector<double>> grid_score_can_stay_still;
-		vector<vector<int>> grid_score_allies_around;
-
-		int halite_initial;
-		int halite_total;
-		int halite_percentile;
-
-		Scorer() : halite_initial(0), halite_total(0), halite_percentile(0) {};
-		Scorer(int height, int width) : halite_initial(0), halite_total(0), halite_percentile(0) 
+		Grid<double> grid_score_highway;
+		Grid<int> grid_score_move;
+		Grid<double> grid_score_enemies;
+
+		Grid<double> grid_score_extract;
+		Grid<double> grid_score_dropoff;
+		Grid<double> grid_score_extract_smooth;
+		Grid<double> grid_score_extract_nearby;
+		Grid<double> grid_score_neighbor_cell;
+		// Block maxima of grid_score_extract_smooth, kept exact through the objective decreases
+		HalitePyramid halite_pyramid;
+
+		// Ship counts within a distance, stacked in one grid and updated together
+		enum InspirationPlane { INSPIRATION, INSPIRATION_ENEMIES, INSPIRATION_ENEMIES_6, ENEMIES_DISTANCE_2, ENEMIES_DISTANCE_5, INSPIRATION_PLANES };
+		Grid<int> inspiration_planes;
+		GridView<int> grid_score_inspiration;
+		GridView<int> grid_score_inspiration_enemies;
+		GridView<int> grid_score_inspiration_enemies_6;
+		GridView<int> grid_score_enemies_distance_2;
+		GridView<int> grid_score_enemies_distance_5;
+
+		// Ship pressure around each cell, one plane per player id
+		Grid<double> grid_score_ships_nearby;
+		static const int SHIPS_NEARBY_RADIUS = 5;
+		double ships_nearby_kernel[SHIPS_NEARBY_RADIUS + 1]; // 1 / max(1, d)
+		// Worst combat score of my ships moving to each cell of their radius 3 diamond, by ship slot.
+		// Windows are only filled for ships with an enemy within reach, the others read NO_DANGER.
+		enum class DangerWindow : char { NONE, SAFE, FILLED };
+		// Cells are in the order of the combat cache windows.
+		static const int DANGER_RADIUS = CombatCache::WINDOW_RADIUS;
+		static const int DANGER_CELLS = CombatCache::WINDOW_CELLS;
+		static constexpr double NO_DANGER = 9999999.0;
+		vector<array<double, DANGER_CELLS>> danger_windows;
+		vector<DangerWindow> danger_window_state;
+
+		// Combat scores of the turn, the rows are filled by const queries of the objective search
+		mutable CombatCache combat_cache;
+
+		Grid<double> grid_score_can_stay_still;
+		Grid<int> grid_score_allies_around;
+
+		// Turn the inspiration count grids are up to date with, -1 before the first build
+		int inspiration_turn;
+		static const int INSPIRATION_CHECK_PERIOD = 50;
+
+		// Halite smoothing kept across turns, following the cells set by each frame. Post-processing
+		// only runs on the cells whose inputs changed, turn of the last update, -1 before the first.
+		IncrementalDiamondSums neighbor_sums = IncrementalDiamondSums(true);
+		IncrementalDiamondSums extract_sums = IncrementalDiamondSums(true);
+		IncrementalDiamondSums dropoff_sums = IncrementalDiamondSums(false);
+		int neighbor_turn;
+		int extract_turn;
+		int dropoff_turn;
+		bool extract_late;
+		static const int SMOOTHING_CHECK_PERIOD = 50;
+
+		// Extract results by cell, and the 0.9 exponent of the enemies within 2 they were computed with
+		FloatPlane extract_smooth_plane, extract_nearby_plane, extract_plane;
+		vector<int16_t> extract_exponents;
+		// Own ships within 6 factor of the dropoff score, cells within 2 of enemy structures
+		vector<int16_t> dropoff_inspiration;
+		vector<char> dropoff_blocked;
+		vector<int> dropoff_blocked_cells;
+
+		// Dirty cells of the extract and dropoff post-processing gathered in a row, one set per task
+		FloatPlane extract_dirty_smooth, extract_dirty_nearby, extract_dirty_halite, extract_factor_plane;
+		ShortPlane extract_mask_plane, extract_exponent_plane;
+		FloatPlane dropoff_plane, dropoff_factor_plane;
+		ShortPlane dropoff_mask_plane, dropoff_inspiration_plane;
+
+		Scorer() : inspiration_turn(-1), neighbor_turn(-1), extract_turn(-1), dropoff_turn(-1), extract_late(false) {};
+		Scorer(int height, int width) : inspiration_turn(-1), neighbor_turn(-1), extract_turn(-1), dropoff_turn(-1), extract_late(false) 
 		{
-			grid_score_move = vector<vector<int>>(height, vector<int>(width, 0));
-			grid_score_enemies = vector<vector<double>>(height, vector<double>(width, 0.0));
-			grid_score_ships_nearby = unordered_map<PlayerId, vector<vector<double>>>();
-
-			grid_score_extract = vector<vector<double>>(height, vector<double>(width, 0.0));
-			grid_score_extract_smooth = vector<vector<double>>(height, vector<double>(width, 0.0));
-			grid_score_extract_nearby = vector<vector<double>>(height, vector<double>(width, 0.0));
-			grid_score_neighbor_cell = vector<vector<double>>(height, vector<double>(width, 0.0));
-
-			grid_score_dropoff = vector<vector<double>>(height, vector<double>(width, 0.0));
-			grid_score_inspiration = vector<vector<int>>(height, vector<int>(width, 0));
-			grid_score_inspiration_enemies = vector<vector<int>>(height, vector<int>(width, 0));
-			grid_score_inspiration_enemies_6 = vector<vector<int>>(height, vector<int>(width, 0));
-			grid_score_enemies_distance_2 = vector<vector<int>>(height, vector<int>(width, 0));
-			grid_score_enemies_distance_5 = vector<vector<int>>(height, vector<int>(width, 0));
-
-			grid_score_can_stay_still = vector<vector<double>>(height, vector<double>(width, 0.0));
+			grid_score_move.resize(width, height);
+			grid_score_enemies.resize(width, height);
+			for (int d = 0; d <= SHIPS_NEARBY_RADIUS; ++d)
+				ships_nearby_kernel[d] = 1.0 / max(1.0, (double)d);
+
+			grid_score_extract.resize(width, height);
+			grid_score_extract_smooth.resize(width, height);
+			grid_score_extract_nearby.resize(width, height);
+			grid_score_neighbor_cell.resize(width, height);
+
+			grid_score_dropoff.resize(width, height);
+			inspiration_planes.resize(width, height, INSPIRATION_PLANES);
+			grid_score_inspiration = inspiration_planes.plane(INSPIRATION);
+			grid_score_inspiration_enemies = inspiration_planes.plane(INSPIRATION_ENEMIES);
+			grid_score_inspiration_enemies_6 = inspiration_planes.plane(INSPIRATION_ENEMIES_6);
+			grid_score_enemies_distance_2 = inspiration_planes.plane(ENEMIES_DISTANCE_2);
+			grid_score_enemies_distance_5 = inspiration_planes.plane(ENEMIES_DISTANCE_5);
+
+			grid_score_can_stay_still.resize(width, height);
+
+			for (FloatPlane* plane : { &extract_smooth_plane, &extract_nearby_plane, &extract_plane })
+				plane->resize(width, height);
 		};
 		
-		void update_grids(const Game& game)
+		// Grids of the registry, in the order they are added
+		enum GridId
+		{
+			GRID_MOVE,
+			GRID_ENEMIES,
+			GRID_INSPIRATION,
+			GRID_NEIGHBOR_CELL,
+			GRID_EXTRACT,
+			GRID_DROPOFF,
+			GRID_TARGETS,
+			GRID_COMBAT_CACHE,
+			GRID_CAN_STAY_STILL,
+			GRID_DANGEROUS_CELL,
+			GRID_HALITE_PYRAMID
+		};
+		// Grids computed when read after their inputs changed, lazy ones are required by const readers
+		mutable GridRegistry grids;
+
+		void register_grids(const Game& game);
+		// Marks the grids whose sources the frame changed as stale
+		void begin_turn(const Game& game);
+		// Grid updates as tasks, each one after the grids it reads: the eager grids, or every grid the bot reads
+		void add_grid_tasks(TaskGraph& graph, const Game& game, bool every_grid = false)
+		{
+			if (grids.empty())
+				register_grids(game);
+			grids.add_tasks(graph, every_grid);
+		}
+		void update_grids(const Game& game, ThreadPool* pool = nullptr)
 		{
 			Stopwatch s("Updating grids");
-			update_grid_score_move(game); // no dep
-			//update_grid_score_enemies(game); // no dep
-			update_grid_score_inspiration(game); // no dep
-			update_grid_score_neighbor_cell(game); // no dep
-			update_grid_score_extract(game); // depend on grid_score_inspiration
-			update_grid_score_dropoff(game); // depend on grid_score_move
-			update_grid_score_targets(game); // no dep
-			update_grid_score_can_stay_still(game); // depend on grid_score_move, grid_score_targets
-			update_grid_ship_can_move_to_dangerous_cell(game); // depend on grid_score_move, grid_score_targets
+			TaskGraph graph;
+			add_grid_tasks(graph, game, true);
+			graph.run(pool);
 		}
 
 		// Move scorer
 		void add_self_ships_to_grid_score(shared_ptr<Ship> ship, const Position& position);
 		inline void flush_grid_score(const Position& position) { grid_score_move[position.y][position.x] = 0; }
 		inline int get_grid_score_move(const Position& position) const { return grid_score_move[position.y][position.x]; }
-		inline double get_grid_score_enemies(const Position& position) const { return grid_score_enemies[position.y][position.x]; }
+		// After the frame tasks, see register_grids
+		inline double get_grid_score_enemies(const Position& position) const { grids.require(GRID_ENEMIES); return grid_score_enemies[position.y][position.x]; }
 		void update_grid_score_move(const Game& game);
 		void update_grid_score_enemies(const Game& game);
 
 		// Strategic extraction scorer
 		void update_grid_score_inspiration(const Game& game);
-		void update_grid_score_extract(const Game& game);
-		void update_grid_score_neighbor_cell(const Game& game);
-		void update_grid_score_dropoff(const Game& game);
+		void rebuild_grid_score_inspiration(const Game& game);
+		void check_grid_score_inspiration(const Game& game);
+		SmallVector<pair<GridView<int>*, int>, 3> inspiration_stamps(const Game& game, PlayerId owner);
+		void stamp_ship_inspiration(const Game& game, PlayerId owner, const Position& position, int count);
+		void move_ship_inspiration(const Game& game, PlayerId owner, const Position& from, const Position& to);
+		// Incremental from the last turn unless rebuild is set
+		void update_grid_score_extract(const Game& game, bool rebuild = false);
+		void update_grid_score_neighbor_cell(const Game& game, bool rebuild = false);
+		void update_grid_score_dropoff(const Game& game, bool rebuild = false);
+		void insert_structure_cells(const Game& game, CellSet& cells) const;
+		void check_smoothing_grids(const Game& game, void (Scorer::*update)(const Game&, bool), initializer_list<Grid<double>*> grids, const string& name);
 		inline double get_grid_score_extract(const Position& position) const { return grid_score_extract[position.y][position.x]; }
 		inline double get_grid_score_extract_nearby(const Position& position) const { return grid_score_extract_nearby[position.y][position.x]; }
 		inline int get_grid_score_inspiration(const Position& position) const { return grid_score_inspiration[position.y][position.x]; }
 		inline int get_grid_score_inspiration_enemies(const Position& position) const { return grid_score_inspiration_enemies[position.y][position.x]; }
-		inline double get_grid_score_neighbor_cell(const Position& position) const { return grid_score_neighbor_cell[position.y][position.x]; }
+		inline double get_grid_score_neighbor_cell(const Position& position) const { grids.require(GRID_NEIGHBOR_CELL); return grid_score_neighbor_cell[position.y][position.x]; }
 
 		Objective find_best_objective_cell(shared_ptr<Ship> ship, const Game& game, bool verbose = false) const;
 		Objective find_best_objective_cell_2p(shared_ptr<Ship> ship, const Game& game, bool verbose = false) const;
 		Objective find_best_objective_cell_4p(shared_ptr<Ship> ship, const Game& game, bool verbose = false) const;
+		// Best objective cell of the ship, enemy cells are attacked when can_attack: through the blocks
+		// of halite_pyramid that can beat the best cell found so far, or a scan of every cell
+		Objective search_objective_cell(const shared_ptr<Ship>& ship, const Game& game, bool can_attack) const;
+		Objective scan_objective_cell(const shared_ptr<Ship>& ship, const Game& game, bool can_attack) const;
+		void check_objective_cell(const shared_ptr<Ship>& ship, const Game& game, bool can_attack, const Objective& objective) const;
+		bool is_attack_cell(int x, int y, bool can_attack, const Game& game) const;
+		static inline double objective_score(double halite, int total_distance) { return halite / (1.0 + (double)total_distance); }
+		// Cannot go to objectives further than turns remaining
+		static inline double objective_reachable_score(double score, int total_distance, int turns_remaining) { return ((int)(1.5 * total_distance) >= turns_remaining) ? score - 999999.0 : score; }
+		// Cells of grid_score_extract_smooth an assignment lowers: the square of TARGET_AREA_RADIUS around the target, no cell is raised
+		static const int TARGET_AREA_RADIUS = 4;
 		void decreases_score_in_target_area(shared_ptr<Ship> ship, const Position& position, const Game& game);
-		void decreases_score_in_target_cell(shared_ptr<Ship> ship, const Position& position, double mult, const Game& game) { grid_score_extract_smooth[position.y][position.x] *= mult; }
+		void decreases_score_in_target_cell(shared_ptr<Ship> ship, const Position& position, double mult, const Game& game)
+		{
+			grid_score_extract_smooth[position.y][position.x] *= mult;
+			halite_pyramid.update(grid_score_extract_smooth, position.x, position.y);
+		}
 
 		// Shipyard construction
 		pair<MapCell*, double> find_best_dropoff_cell(shared_ptr<Shipyard> shipyard, vector<Position> dropoffs, const Game& game) const;
 
 		// Attack
 		void update_grid_score_targets(const Game& game);
-		double get_grid_score_ships_nearby(PlayerId id, const Position& position) const { return grid_score_ships_nearby.at(id)[position.y][position.x]; }
+		inline double get_grid_score_ships_nearby(PlayerId id, const Position& position) const { return grid_score_ships_nearby.data(id)[position.y * grid_score_ships_nearby.width + position.x]; }
 		double combat_score(shared_ptr<Ship> my_ship, shared_ptr<Ship> enemy_ship, const Position& position_to_score, const Game& game, bool big_cell = false) const;
+		void update_combat_cache(const Game& game);
 
 		// Can Stay Still and Move
 		void update_grid_score_can_stay_still(const Game& game);
 		inline double get_grid_score_can_stay_still(const Position& position) const { return grid_score_can_stay_still[position.y][position.x]; }
 		double get_score_ship_move_to_position(shared_ptr<Ship> ship, const Position& position, const Game& game) const;
 		void update_grid_ship_can_move_to_dangerous_cell(const Game& game);
-		inline double get_score_ship_can_move_to_dangerous_cell(shared_ptr<Ship> ship, const Position& position) const 
+		// Ships without a window (built after the window pass) and cells out of the window are scored directly
+		inline double get_score_ship_can_move_to_dangerous_cell(const shared_ptr<Ship>& ship, const Position& position, const Game& game) const 
 		{ 
-			return grid_ship_can_move_to_dangerous_cell.at(ship).at(position);
+			DangerWindow state = ((size_t)ship->slot < danger_window_state.size()) ? danger_window_state[ship->slot] : DangerWindow::NONE;
+			int index = danger_index(ship->position, position);
+
+			if ((state == DangerWindow::NONE) || (index < 0))
+				return score_ship_can_move_to_dangerous_cell(ship, position, game);
+
+			return (state == DangerWindow::FILLED) ? danger_windows[ship->slot][index] : NO_DANGER;
 		}
+		double score_ship_can_move_to_dangerous_cell(const shared_ptr<Ship>& ship, const Position& position, const Game& game) const;
+		inline int danger_index(const Position& center, const Position& position) const { return combat_cache.window_cell(center, position); }
 
 		// utilities
 		static double linear_increase(int x, int x_min, int x_max, double y_min, double y_max)
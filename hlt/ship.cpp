@@ -1,13 +1,10 @@
 #include "ship.hpp"
-#include "input.hpp"
 
-std::shared_ptr<hlt::Ship> hlt::Ship::_generate(hlt::PlayerId player_id) 
+// Same ship seen again on a new turn, turn flags are reset but the objective is kept
+void hlt::Ship::_update(int x, int y, hlt::Halite halite)
 {
-    hlt::EntityId ship_id;
-    int x;
-    int y;
-    hlt::Halite halite;
-    hlt::get_sstream() >> ship_id >> x >> y >> halite;
-
-    return std::make_shared<hlt::Ship>(player_id, ship_id, x, y, halite);
+    this->position = Position(x, y);
+    this->halite = halite;
+    this->assigned = false;
+    this->is_targeted = false;
 }
@@ -15,12 +15,16 @@ namespace hlt
 		shared_ptr<Objective> objective;
 		bool assigned;
 		bool is_targeted;
+		int slot; // index in the ShipPool, stable while the ship is alive
+		int last_seen_turn;
 
         Ship(PlayerId player_id, EntityId ship_id, int x, int y, Halite halite) :
             Entity(player_id, ship_id, x, y),
             halite(halite),
 			assigned(false),
-			is_targeted(false)
+			is_targeted(false),
+			slot(-1),
+			last_seen_turn(-1)
         {}
 
 		void set_assigned() { this->assigned = true; }
@@ -95,7 +99,7 @@ namespace hlt
 
 
 		/* New turn */
-		static std::shared_ptr<Ship> _generate(PlayerId player_id);
+		void _update(int x, int y, Halite halite);
     };
 }
 
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "ship.hpp"
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+
+using namespace std;
+
+namespace hlt
+{
+	struct ShipMove
+	{
+		shared_ptr<Ship> ship;
+		Position from;
+	};
+
+	/*
+	Ship changes of the current turn, all players included. Destroyed ships keep their last
+	position and slot, and a slot freed this turn may already be reused by a spawned ship, so
+	slot indexed consumers should apply destroyed before spawned.
+	*/
+	struct ShipEvents
+	{
+		vector<shared_ptr<Ship>> spawned;
+		vector<shared_ptr<Ship>> destroyed;
+		vector<ShipMove> moved;
+		int cargo_changes = 0; // ships alive last turn whose halite changed
+
+		void clear()
+		{
+			spawned.clear();
+			destroyed.clear();
+			moved.clear();
+			cargo_changes = 0;
+		}
+	};
+
+	/*
+	Every ship alive in the game, all players included, sits in one slot of the pool. A ship keeps
+	its Ship object and its slot from one turn to the next while it is alive, so per ship data can
+	be stored in flat arrays indexed by Ship::slot. Slots of destroyed ships are reused by new ships.
+	*/
+	class ShipPool
+	{
+	public:
+		ShipEvents events;
+
+		ShipPool() {}
+
+		void begin_turn() { events.clear(); }
+
+		// New ship in a free slot, the only allocation of a ship lifetime
+		shared_ptr<Ship> acquire(PlayerId owner, EntityId id, int x, int y, Halite halite)
+		{
+			int slot;
+			if (free_slots.empty())
+			{
+				slot = (int)ships.size();
+				ships.push_back(shared_ptr<Ship>());
+			}
+			else
+			{
+				slot = free_slots.back();
+				free_slots.pop_back();
+			}
+
+			ships[slot] = make_shared<Ship>(owner, id, x, y, halite);
+			ships[slot]->slot = slot;
+			events.spawned.push_back(ships[slot]);
+			return ships[slot];
+		}
+
+		void release(const shared_ptr<Ship>& ship)
+		{
+			int slot = ship->slot;
+			events.destroyed.push_back(ship);
+			ships[slot].reset();
+			free_slots.push_back(slot);
+		}
+
+		void moved(const shared_ptr<Ship>& ship, const Position& from) { events.moved.push_back({ ship, from }); }
+		void cargo_changed() { events.cargo_changes++; }
+
+		inline const shared_ptr<Ship>& at(int slot) const { return ships[slot]; }
+
+		// Upper bound of Ship::slot, size of per slot arrays
+		inline int capacity() const { return (int)ships.size(); }
+
+	private:
+		vector<shared_ptr<Ship>> ships;
+		vector<int> free_slots;
+	};
+
+	/*
+	Replacement for unordered_map<shared_ptr<Ship>, T>: values are stored at Ship::slot, so
+	lookups do not hash and clearing keeps the storage. Iteration follows insertion order.
+	*/
+	template <typename T>
+	class ShipSlotMap
+	{
+	public:
+		typedef pair<shared_ptr<Ship>, T> value_type;
+
+		template <typename Map, typename Value>
+		class basic_iterator
+		{
+		public:
+			basic_iterator(Map* map, size_t i) : map(map), i(i) {}
+
+			inline Value& operator*() const { return map->entries[map->order[i]]; }
+			inline Value* operator->() const { return &map->entries[map->order[i]]; }
+			inline basic_iterator& operator++() { ++i; return *this; }
+			inline bool operator!=(const basic_iterator& other) const { return i != other.i; }
+			inline bool operator==(const basic_iterator& other) const { return i == other.i; }
+
+		private:
+			Map* map;
+			size_t i;
+		};
+		typedef basic_iterator<ShipSlotMap, value_type> iterator;
+		typedef basic_iterator<const ShipSlotMap, const value_type> const_iterator;
+
+		ShipSlotMap() {}
+
+		inline iterator begin() { return iterator(this, 0); }
+		inline iterator end() { return iterator(this, order.size()); }
+		inline const_iterator begin() const { return const_iterator(this, 0); }
+		inline const_iterator end() const { return const_iterator(this, order.size()); }
+
+		inline size_t size() const { return order.size(); }
+		inline bool empty() const { return order.empty(); }
+		inline size_t count(const shared_ptr<Ship>& ship) const { return ((size_t)ship->slot < present.size()) && present[ship->slot]; }
+
+		T& operator[](const shared_ptr<Ship>& ship)
+		{
+			size_t slot = (size_t)ship->slot;
+			if (slot >= entries.size())
+			{
+				entries.resize(slot + 1);
+				present.resize(slot + 1, 0);
+			}
+
+			if (!present[slot])
+			{
+				present[slot] = 1;
+				entries[slot] = value_type(ship, T());
+				order.push_back((int)slot);
+			}
+
+			return entries[slot].second;
+		}
+
+		const T& at(const shared_ptr<Ship>& ship) const
+		{
+			if (!count(ship))
+				throw out_of_range("ShipSlotMap::at: ship " + to_string(ship->id) + " not found");
+
+			return entries[ship->slot].second;
+		}
+
+		void clear()
+		{
+			for (int slot : order)
+			{
+				present[slot] = 0;
+				entries[slot].first.reset();
+			}
+			order.clear();
+		}
+
+	private:
+		vector<value_type> entries;
+		vector<char> present;
+		vector<int> order;
+	};
+}
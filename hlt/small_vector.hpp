@@ -0,0 +1,111 @@
+#pragma once
+
+#include "log.hpp"
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <cstdlib>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Vector of at most N elements stored inline, for the short lists built in the hot loops
+	(neighbors of a cell, candidate moves of a ship). Nothing is allocated; going over the
+	capacity is a bug and exits like the other map errors.
+	*/
+	template <typename T, size_t N>
+	class SmallVector
+	{
+	public:
+		typedef T value_type;
+		typedef T* iterator;
+		typedef const T* const_iterator;
+
+		SmallVector() : count(0) {}
+		SmallVector(initializer_list<T> values) : count(0)
+		{
+			for (const T& value : values)
+				push_back(value);
+		}
+		SmallVector(const SmallVector& other) : count(0)
+		{
+			for (const T& value : other)
+				push_back(value);
+		}
+		SmallVector(SmallVector&& other) : count(0)
+		{
+			for (T& value : other)
+				push_back(move(value));
+			other.clear();
+		}
+		SmallVector& operator=(const SmallVector& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				for (const T& value : other)
+					push_back(value);
+			}
+			return *this;
+		}
+		~SmallVector() { clear(); }
+
+		inline void push_back(const T& value)
+		{
+			check_capacity();
+			new (data() + count++) T(value);
+		}
+		inline void push_back(T&& value)
+		{
+			check_capacity();
+			new (data() + count++) T(move(value));
+		}
+		template <typename... Args>
+		inline T& emplace_back(Args&&... args)
+		{
+			check_capacity();
+			return *new (data() + count++) T(forward<Args>(args)...);
+		}
+		inline void pop_back() { data()[--count].~T(); }
+		inline void clear()
+		{
+			while (count > 0)
+				pop_back();
+		}
+
+		inline T* data() { return reinterpret_cast<T*>(storage); }
+		inline const T* data() const { return reinterpret_cast<const T*>(storage); }
+		inline iterator begin() { return data(); }
+		inline iterator end() { return data() + count; }
+		inline const_iterator begin() const { return data(); }
+		inline const_iterator end() const { return data() + count; }
+
+		inline T& operator[](size_t i) { return data()[i]; }
+		inline const T& operator[](size_t i) const { return data()[i]; }
+		inline T& front() { return data()[0]; }
+		inline T& back() { return data()[count - 1]; }
+
+		inline size_t size() const { return count; }
+		inline bool empty() const { return count == 0; }
+		static constexpr size_t capacity() { return N; }
+
+	private:
+		typename aligned_storage<sizeof(T), alignof(T)>::type storage[N];
+		size_t count;
+
+		inline void check_capacity() const
+		{
+			if (count >= N)
+			{
+				log::log("Error: SmallVector: more than " + to_string(N) + " elements");
+				exit(1);
+			}
+		}
+	};
+}
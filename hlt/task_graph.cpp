@@ -0,0 +1,204 @@
+#include "task_graph.hpp"
+#include "arena.hpp"
+#include "log.hpp"
+
+#include <chrono>
+#include <cstdlib>
+
+using namespace hlt;
+using namespace std;
+
+void TaskGraph::add(const string& name, function<void()> work, const vector<string>& dependencies)
+{
+	if (find(name) >= 0)
+	{
+		log::log("Error: TaskGraph: task " + name + " added twice");
+		exit(1);
+	}
+
+	Task task;
+	task.name = name;
+	task.work = move(work);
+	task.dependency_count = 0;
+	task.pending = 0;
+	task.elapsed_ms = 0.0;
+	task.thread_index = 0;
+
+	int id = (int)tasks.size();
+	for (const string& dependency : dependencies)
+	{
+		int dependency_id = find(dependency);
+		if (dependency_id < 0)
+		{
+			log::log("Error: TaskGraph: task " + name + " depends on " + dependency + ", which is not added before it");
+			exit(1);
+		}
+
+		tasks[dependency_id].dependents.push_back(id);
+		task.dependency_count++;
+	}
+
+	tasks.push_back(move(task));
+}
+
+int TaskGraph::find(const string& name) const
+{
+	for (size_t i = 0; i < tasks.size(); ++i)
+		if (tasks[i].name == name)
+			return (int)i;
+	return -1;
+}
+
+double TaskGraph::task_ms(const string& name) const
+{
+	int id = find(name);
+	return (id >= 0) ? tasks[id].elapsed_ms : 0.0;
+}
+
+void TaskGraph::run(ThreadPool* pool)
+{
+	auto start = chrono::high_resolution_clock::now();
+
+	if (pool && (pool->size() > 0))
+	{
+		pool->run(*this);
+
+		for (Task& task : tasks)
+		{
+			for (const string& line : task.log_lines)
+				log::log(line);
+			task.log_lines.clear();
+		}
+	}
+	else
+	{
+		// Declaration order is a valid order, dependencies are always added first
+		start_run();
+		for (size_t id = 0; id < tasks.size(); ++id)
+			run_task((int)id, 0, false);
+		threads_used = 1;
+	}
+
+	wall_ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+void TaskGraph::start_run()
+{
+	ready.clear();
+	finished = 0;
+
+	for (size_t id = 0; id < tasks.size(); ++id)
+	{
+		tasks[id].pending = tasks[id].dependency_count;
+		if (tasks[id].pending == 0)
+			ready.push_back((int)id);
+	}
+}
+
+void TaskGraph::run_task(int id, int thread_index, bool capture_log)
+{
+	Task& task = tasks[id];
+	auto start = chrono::high_resolution_clock::now();
+
+	if (capture_log)
+		log::redirect(&task.log_lines);
+	task.work();
+	if (capture_log)
+		log::redirect(nullptr);
+
+	task.elapsed_ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	task.thread_index = thread_index;
+}
+
+void TaskGraph::complete(int id)
+{
+	finished++;
+	for (int dependent : tasks[id].dependents)
+		if (--tasks[dependent].pending == 0)
+			ready.push_back(dependent);
+}
+
+void TaskGraph::log_timings() const
+{
+	double total_ms = 0.0;
+	for (const Task& task : tasks)
+	{
+		log::log("Task " + task.name + ": " + to_string(task.elapsed_ms) + "ms on thread " + to_string(task.thread_index));
+		total_ms += task.elapsed_ms;
+	}
+
+	log::log("Task graph: " + to_string(tasks.size()) + " tasks, " + to_string(total_ms) + "ms of work in " + to_string(wall_ms) + "ms on " + to_string(threads_used) + " threads");
+}
+
+ThreadPool::ThreadPool(int threads) : graph(nullptr), stopping(false)
+{
+	for (int worker = 1; worker <= threads; ++worker)
+		workers.emplace_back(&ThreadPool::worker_loop, this, worker);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	work_ready.notify_all();
+
+	for (thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::run(TaskGraph& task_graph)
+{
+	unique_lock<mutex> guard(lock);
+	graph = &task_graph;
+	graph->start_run();
+	work_ready.notify_all();
+
+	// The calling thread takes ready tasks too, and waits when all are taken
+	while (graph->finished < graph->tasks.size())
+	{
+		execute(guard, 0);
+		work_done.wait(guard, [this]() { return (graph->finished == graph->tasks.size()) || !graph->ready.empty(); });
+	}
+
+	graph->threads_used = size() + 1;
+	graph = nullptr;
+}
+
+void ThreadPool::worker_loop(int worker)
+{
+	unique_lock<mutex> guard(lock);
+
+	while (true)
+	{
+		work_ready.wait(guard, [this]() { return stopping || (graph && !graph->ready.empty()); });
+		if (stopping)
+			return;
+
+		execute(guard, worker);
+
+		// Arena temporaries of the tasks are dead once the tasks returned
+		guard.unlock();
+		Arena::turn().reset();
+		guard.lock();
+	}
+}
+
+void ThreadPool::execute(unique_lock<mutex>& guard, int thread_index)
+{
+	while (graph && !graph->ready.empty())
+	{
+		TaskGraph& current = *graph;
+		int id = current.ready.front();
+		current.ready.pop_front();
+
+		guard.unlock();
+		current.run_task(id, thread_index, true);
+		guard.lock();
+
+		current.complete(id);
+		work_ready.notify_all();
+		work_done.notify_all();
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+namespace hlt
+{
+	class ThreadPool;
+
+	/*
+	Tasks of a turn with the tasks they depend on, run serially in declaration order or on a
+	ThreadPool as soon as their dependencies are done. Tasks must only write state no other
+	task of the graph reads or writes, so results do not depend on the schedule.
+
+	Log messages of a task run on the pool are kept with the task and written after the run
+	in declaration order, so the log reads the same as a serial run.
+	*/
+	class TaskGraph
+	{
+	public:
+		// Adds a task run after the named tasks, which must have been added before
+		void add(const string& name, function<void()> work, const vector<string>& dependencies = {});
+		// Runs every task, on the pool when there is one, serially otherwise
+		void run(ThreadPool* pool);
+		void clear() { tasks.clear(); }
+
+		inline size_t size() const { return tasks.size(); }
+		// Time spent in the task on the last run
+		double task_ms(const string& name) const;
+		void log_timings() const;
+
+	private:
+		friend class ThreadPool;
+
+		struct Task
+		{
+			string name;
+			function<void()> work;
+			vector<int> dependents;
+			int dependency_count;
+			int pending; // dependencies not done yet in the current run
+			double elapsed_ms;
+			int thread_index; // 0 is the calling thread, workers are 1 and up
+			vector<string> log_lines;
+		};
+
+		vector<Task> tasks;
+		deque<int> ready;
+		size_t finished = 0;
+		double wall_ms = 0.0;
+		int threads_used = 1;
+
+		int find(const string& name) const;
+		void start_run();
+		void run_task(int id, int thread_index, bool capture_log);
+		// Marks the task done and queues the dependents it was the last dependency of
+		void complete(int id);
+	};
+
+	// Worker threads running TaskGraphs together with the calling thread
+	class ThreadPool
+	{
+	public:
+		ThreadPool(int threads);
+		~ThreadPool();
+
+		inline int size() const { return (int)workers.size(); }
+		void run(TaskGraph& graph);
+
+	private:
+		vector<thread> workers;
+		mutex lock;
+		condition_variable work_ready;
+		condition_variable work_done;
+		TaskGraph* graph;
+		bool stopping;
+
+		void worker_loop(int worker);
+		// Runs ready tasks of the current graph until none is left, lock held outside tasks
+		void execute(unique_lock<mutex>& guard, int thread_index);
+	};
+}
@@ -0,0 +1,386 @@
+#include "transcript.hpp"
+#include "input.hpp"
+#include "log.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+static const char TRANSCRIPT_MAGIC[4] = { 'H', 'L', 'T', 'T' };
+static const unsigned int TRANSCRIPT_VERSION = 1;
+
+/*
+Game state the deltas are taken against, kept identical on both sides: the capture updates
+it while encoding and the replay updates it while decoding.
+*/
+struct TranscriptState
+{
+	int num_players = 0;
+	int width = 0;
+	int height = 0;
+	int turn = 0;
+	vector<int> player_halite;
+	vector<int> cell_halite;
+};
+
+static ofstream capture_file;
+static TranscriptState capture_state;
+static bool capture_init_written = false;
+static string capture_record;
+
+static void put_varint(string& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+static void put_signed(string& out, int value)
+{
+	put_varint(out, (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+}
+
+// Integers of an engine text block, in reading order
+class TextReader
+{
+public:
+	TextReader(const string& text) : text(text), cursor(0) {}
+
+	string next_line()
+	{
+		size_t end = text.find('\n', cursor);
+		if (end == string::npos)
+			end = text.size();
+		string line = text.substr(cursor, end - cursor);
+		cursor = end + 1;
+		return line;
+	}
+
+	int next_int()
+	{
+		while ((cursor < text.size()) && !is_number_start(text[cursor]))
+			cursor++;
+
+		bool negative = (cursor < text.size()) && (text[cursor] == '-');
+		if (negative)
+			cursor++;
+
+		int value = 0;
+		while ((cursor < text.size()) && (text[cursor] >= '0') && (text[cursor] <= '9'))
+			value = 10 * value + (text[cursor++] - '0');
+
+		return negative ? -value : value;
+	}
+
+private:
+	const string& text;
+	size_t cursor;
+
+	static bool is_number_start(char c) { return (c == '-') || ((c >= '0') && (c <= '9')); }
+};
+
+// Varints of a transcript file, in writing order
+class BinaryReader
+{
+public:
+	BinaryReader(const string& data, const string& path) : data(data), path(path), cursor(0) {}
+
+	bool at_end() const { return cursor >= data.size(); }
+
+	uint32_t next_varint()
+	{
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			if (at_end())
+				fail("truncated record");
+
+			uint8_t byte = static_cast<uint8_t>(data[cursor++]);
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return value;
+		}
+
+		fail("malformed varint");
+		return 0;
+	}
+
+	int next_int() { return static_cast<int>(next_varint()); }
+
+	int next_signed()
+	{
+		uint32_t value = next_varint();
+		return static_cast<int>((value >> 1) ^ (~(value & 1) + 1));
+	}
+
+	string next_bytes(size_t length)
+	{
+		if (cursor + length > data.size())
+			fail("truncated record");
+
+		string bytes = data.substr(cursor, length);
+		cursor += length;
+		return bytes;
+	}
+
+	void fail(const string& reason) const
+	{
+		hlt::log::log("Error: transcript: " + path + ": " + reason + " at byte " + to_string(cursor));
+		exit(1);
+	}
+
+private:
+	const string& data;
+	const string& path;
+	size_t cursor;
+};
+
+static void encode_init(const string& block, string& out, TranscriptState& state)
+{
+	TextReader reader(block);
+
+	string constants_line = reader.next_line();
+	put_varint(out, (uint32_t)constants_line.size());
+	out += constants_line;
+
+	state.num_players = reader.next_int();
+	put_varint(out, state.num_players);
+	put_varint(out, reader.next_int()); // my_id
+
+	for (int i = 0; i < state.num_players; ++i)
+	{
+		put_varint(out, reader.next_int()); // player id
+		put_varint(out, reader.next_int()); // shipyard x
+		put_varint(out, reader.next_int()); // shipyard y
+	}
+
+	state.width = reader.next_int();
+	state.height = reader.next_int();
+	put_varint(out, state.width);
+	put_varint(out, state.height);
+
+	state.cell_halite.resize(state.width * state.height);
+	for (int& halite : state.cell_halite)
+	{
+		halite = reader.next_int();
+		put_varint(out, halite);
+	}
+
+	state.player_halite.assign(state.num_players, 0);
+	state.turn = 0;
+}
+
+static void encode_frame(const string& block, string& out, TranscriptState& state)
+{
+	TextReader reader(block);
+
+	int turn = reader.next_int();
+	put_signed(out, turn - state.turn);
+	state.turn = turn;
+
+	for (int i = 0; i < state.num_players; ++i)
+	{
+		int player_id = reader.next_int();
+		int num_ships = reader.next_int();
+		int num_dropoffs = reader.next_int();
+		int halite = reader.next_int();
+
+		put_varint(out, player_id);
+		put_varint(out, num_ships);
+		put_varint(out, num_dropoffs);
+		put_signed(out, halite - state.player_halite[i]);
+		state.player_halite[i] = halite;
+
+		int previous_id = 0;
+		for (int j = 0; j < num_ships; ++j)
+		{
+			int ship_id = reader.next_int();
+			put_signed(out, ship_id - previous_id);
+			previous_id = ship_id;
+
+			put_varint(out, reader.next_int()); // x
+			put_varint(out, reader.next_int()); // y
+			put_varint(out, reader.next_int()); // halite
+		}
+
+		for (int j = 0; j < num_dropoffs; ++j)
+		{
+			put_varint(out, reader.next_int()); // id
+			put_varint(out, reader.next_int()); // x
+			put_varint(out, reader.next_int()); // y
+		}
+	}
+
+	int update_count = reader.next_int();
+	put_varint(out, update_count);
+
+	int previous_index = 0;
+	for (int i = 0; i < update_count; ++i)
+	{
+		int x = reader.next_int();
+		int y = reader.next_int();
+		int halite = reader.next_int();
+		int index = y * state.width + x;
+
+		put_signed(out, index - previous_index);
+		put_signed(out, halite - state.cell_halite[index]);
+		previous_index = index;
+		state.cell_halite[index] = halite;
+	}
+}
+
+static void decode_init(BinaryReader& reader, string& text, TranscriptState& state)
+{
+	text += reader.next_bytes(reader.next_varint());
+	text += '\n';
+
+	state.num_players = reader.next_int();
+	text += to_string(state.num_players) + " " + to_string(reader.next_int()) + "\n";
+
+	for (int i = 0; i < state.num_players; ++i)
+	{
+		int player_id = reader.next_int();
+		int x = reader.next_int();
+		int y = reader.next_int();
+		text += to_string(player_id) + " " + to_string(x) + " " + to_string(y) + "\n";
+	}
+
+	state.width = reader.next_int();
+	state.height = reader.next_int();
+	text += to_string(state.width) + " " + to_string(state.height) + "\n";
+
+	state.cell_halite.resize(state.width * state.height);
+	for (int y = 0; y < state.height; ++y)
+	{
+		for (int x = 0; x < state.width; ++x)
+		{
+			int halite = reader.next_int();
+			state.cell_halite[y * state.width + x] = halite;
+			text += to_string(halite);
+			text += (x + 1 < state.width) ? ' ' : '\n';
+		}
+	}
+
+	state.player_halite.assign(state.num_players, 0);
+	state.turn = 0;
+}
+
+static void decode_frame(BinaryReader& reader, string& text, TranscriptState& state)
+{
+	state.turn += reader.next_signed();
+	text += to_string(state.turn) + "\n";
+
+	for (int i = 0; i < state.num_players; ++i)
+	{
+		int player_id = reader.next_int();
+		int num_ships = reader.next_int();
+		int num_dropoffs = reader.next_int();
+		state.player_halite[i] += reader.next_signed();
+		text += to_string(player_id) + " " + to_string(num_ships) + " " + to_string(num_dropoffs) + " " + to_string(state.player_halite[i]) + "\n";
+
+		int ship_id = 0;
+		for (int j = 0; j < num_ships; ++j)
+		{
+			ship_id += reader.next_signed();
+			int x = reader.next_int();
+			int y = reader.next_int();
+			int halite = reader.next_int();
+			text += to_string(ship_id) + " " + to_string(x) + " " + to_string(y) + " " + to_string(halite) + "\n";
+		}
+
+		for (int j = 0; j < num_dropoffs; ++j)
+		{
+			int dropoff_id = reader.next_int();
+			int x = reader.next_int();
+			int y = reader.next_int();
+			text += to_string(dropoff_id) + " " + to_string(x) + " " + to_string(y) + "\n";
+		}
+	}
+
+	int update_count = reader.next_int();
+	text += to_string(update_count) + "\n";
+
+	int index = 0;
+	for (int i = 0; i < update_count; ++i)
+	{
+		index += reader.next_signed();
+		if ((index < 0) || (index >= (int)state.cell_halite.size()))
+			reader.fail("cell index " + to_string(index) + " out of the map");
+
+		state.cell_halite[index] += reader.next_signed();
+		text += to_string(index % state.width) + " " + to_string(index / state.width) + " " + to_string(state.cell_halite[index]) + "\n";
+	}
+}
+
+// Called by hlt::input as soon as a block is read, the init block comes first
+static void capture_block(const string& block)
+{
+	capture_record.clear();
+
+	if (!capture_init_written)
+	{
+		encode_init(block, capture_record, capture_state);
+		capture_init_written = true;
+	}
+	else
+		encode_frame(block, capture_record, capture_state);
+
+	// Flushed every turn, the engine may kill the bot at any time
+	capture_file.write(capture_record.data(), capture_record.size());
+	capture_file.flush();
+}
+
+void hlt::transcript::start_capture(const string& path, unsigned int rng_seed)
+{
+	capture_file.open(path, ios::binary | ios::trunc | ios::out);
+	if (!capture_file)
+	{
+		log::log("Error: transcript: cannot open " + path + " for capture");
+		exit(1);
+	}
+
+	string header(TRANSCRIPT_MAGIC, sizeof(TRANSCRIPT_MAGIC));
+	put_varint(header, TRANSCRIPT_VERSION);
+	put_varint(header, rng_seed);
+	capture_file.write(header.data(), header.size());
+
+	capture_init_written = false;
+	capture_record.reserve(1 << 16);
+	input::set_capture(capture_block);
+}
+
+string hlt::transcript::load_replay(const string& path, unsigned int& rng_seed)
+{
+	ifstream file(path, ios::binary | ios::in);
+	if (!file)
+	{
+		log::log("Error: transcript: cannot open " + path + " for replay");
+		exit(1);
+	}
+
+	stringstream contents;
+	contents << file.rdbuf();
+	const string data = contents.str();
+	BinaryReader reader(data, path);
+
+	if (reader.next_bytes(sizeof(TRANSCRIPT_MAGIC)) != string(TRANSCRIPT_MAGIC, sizeof(TRANSCRIPT_MAGIC)))
+		reader.fail("not a transcript");
+	if (reader.next_varint() != TRANSCRIPT_VERSION)
+		reader.fail("unsupported version");
+	rng_seed = reader.next_varint();
+
+	TranscriptState state;
+	string text;
+	decode_init(reader, text, state);
+	while (!reader.at_end())
+		decode_frame(reader, text, state);
+
+	return text;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+namespace hlt
+{
+	/*
+	Compact recording of everything the engine sent to the bot during one game, so that a
+	real game can be replayed offline without halite.exe ("MyBot --capture file" during the
+	game, "MyBot --replay file" afterwards).
+
+	The file starts with a header (magic, version, rng seed), then the init block, then one
+	record per frame. Integers are varints; signed deltas use zigzag varints. Player halite
+	is stored as the change since the previous frame. Cell updates are stored as the
+	change in cell index since the previous update and the change in cell halite since the
+	last known value. Replaying rebuilds the engine text one line per entity. Whitespace can
+	differ from the original stream, but every value is the same.
+	*/
+	namespace transcript
+	{
+		// Record every block read through hlt::input from now on (init, then one per frame)
+		void start_capture(const string& path, unsigned int rng_seed);
+
+		// Engine text of a captured game, rng_seed is set to the seed of the capture
+		string load_replay(const string& path, unsigned int& rng_seed);
+	}
+}
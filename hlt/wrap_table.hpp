@@ -0,0 +1,254 @@
+#pragma once
+
+#include "direction.hpp"
+#include "log.hpp"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace hlt
+{
+	// Cell reached from a center through a wrapped offset
+	struct WrappedCell
+	{
+		int x;
+		int y;
+		int index;
+		int distance;
+	};
+
+	/*
+	Toroidal wrap tables, built once when the map is generated. Coordinates are wrapped
+	through per axis lookup tables instead of two modulos, every cell knows the flat index
+	of its 4 neighbors, and square / diamond neighborhoods are walked through precomputed
+	offset lists. Offsets are visited row by row (dy outer, dx inner), like the scorer loops
+	always did, and assume 2 * radius + 1 <= width so that no cell is visited twice.
+
+	It is also the distance oracle: the toroidal distance between two cells on the map is
+	delta_x[x1 - x2] + delta_y[y1 - y2], and a whole row or grid of distances from one source
+	is the sum of one delta_y entry and a contiguous slice of delta_x, which vectorizes.
+	*/
+	class WrapTable
+	{
+	public:
+		static const int MAX_RADIUS = 8;
+
+		struct Offset
+		{
+			int dx;
+			int dy;
+			int distance;
+		};
+
+		class OffsetIterator
+		{
+		public:
+			OffsetIterator(const WrapTable* table, const Offset* offset, int x, int y) : table(table), offset(offset), x(x), y(y) {}
+
+			inline WrappedCell operator*() const
+			{
+				int new_x = table->wrap_x(x + offset->dx);
+				int new_y = table->wrap_y(y + offset->dy);
+				return { new_x, new_y, new_y * table->width + new_x, offset->distance };
+			}
+			inline OffsetIterator& operator++() { ++offset; return *this; }
+			inline bool operator!=(const OffsetIterator& other) const { return offset != other.offset; }
+
+		private:
+			const WrapTable* table;
+			const Offset* offset;
+			int x;
+			int y;
+		};
+
+		class OffsetRange
+		{
+		public:
+			OffsetRange(const WrapTable* table, const vector<Offset>& offsets, int x, int y) : table(table), offsets(offsets), x(x), y(y) {}
+
+			inline OffsetIterator begin() const { return OffsetIterator(table, offsets.data(), x, y); }
+			inline OffsetIterator end() const { return OffsetIterator(table, offsets.data() + offsets.size(), x, y); }
+
+		private:
+			const WrapTable* table;
+			const vector<Offset>& offsets;
+			int x;
+			int y;
+		};
+
+		int width;
+		int height;
+
+		WrapTable() : width(0), height(0), margin_x(0), margin_y(0) {}
+		WrapTable(int width, int height) : width(width), height(height), margin_x(width), margin_y(height)
+		{
+			// Coordinates in [-size, 2 * size) are served by the tables
+			for (int x = -margin_x; x < 2 * width; ++x)
+				table_x.push_back(((x % width) + width) % width);
+			for (int y = -margin_y; y < 2 * height; ++y)
+				table_y.push_back(((y % height) + height) % height);
+
+			// delta_x[d + width - 1] is the toroidal distance between x and x + d
+			for (int d = -(width - 1); d < width; ++d)
+				delta_x.push_back(min(abs(d), width - abs(d)));
+			for (int d = -(height - 1); d < height; ++d)
+				delta_y.push_back(min(abs(d), height - abs(d)));
+
+			neighbors.resize(width * height);
+			for (int y = 0; y < height; ++y)
+				for (int x = 0; x < width; ++x)
+				{
+					array<int, 4>& cell_neighbors = neighbors[y * width + x];
+					cell_neighbors[0] = wrap_y(y - 1) * width + x;
+					cell_neighbors[1] = wrap_y(y + 1) * width + x;
+					cell_neighbors[2] = y * width + wrap_x(x + 1);
+					cell_neighbors[3] = y * width + wrap_x(x - 1);
+				}
+
+			squares.resize(MAX_RADIUS + 1);
+			diamonds.resize(MAX_RADIUS + 1);
+			for (int radius = 0; radius <= MAX_RADIUS; ++radius)
+				for (int dy = -radius; dy <= radius; ++dy)
+					for (int dx = -radius; dx <= radius; ++dx)
+					{
+						Offset offset = { dx, dy, abs(dx) + abs(dy) };
+						squares[radius].push_back(offset);
+						if (offset.distance <= radius)
+							diamonds[radius].push_back(offset);
+					}
+
+			// A one step move changes the distance to every cell by exactly 1, so the diamond
+			// gains the cells now at radius that were at radius + 1, and loses the opposite
+			const int steps[4][2] = { { 0, -1 }, { 0, 1 }, { 1, 0 }, { -1, 0 } };
+			for (int d = 0; d < 4; ++d)
+			{
+				diamonds_entering[d].resize(MAX_RADIUS + 1);
+				diamonds_leaving[d].resize(MAX_RADIUS + 1);
+
+				for (int radius = 0; radius <= MAX_RADIUS; ++radius)
+					for (int dy = -radius - 1; dy <= radius + 1; ++dy)
+						for (int dx = -radius - 1; dx <= radius + 1; ++dx)
+						{
+							int distance = abs(dx) + abs(dy);
+							int previous_distance = abs(dx + steps[d][0]) + abs(dy + steps[d][1]);
+
+							if ((distance == radius) && (previous_distance == radius + 1))
+								diamonds_entering[d][radius].push_back({ dx, dy, distance });
+							if ((distance == radius + 1) && (previous_distance == radius))
+								diamonds_leaving[d][radius].push_back({ dx, dy, distance });
+						}
+			}
+		}
+
+		inline int wrap_x(int x) const
+		{
+			unsigned int i = (unsigned int)(x + margin_x);
+			return (i < table_x.size()) ? table_x[i] : ((x % width) + width) % width;
+		}
+		inline int wrap_y(int y) const
+		{
+			unsigned int i = (unsigned int)(y + margin_y);
+			return (i < table_y.size()) ? table_y[i] : ((y % height) + height) % height;
+		}
+		inline int index(int x, int y) const { return wrap_y(y) * width + wrap_x(x); }
+
+		// Flat index of the neighbor of a flat index, NORTH / SOUTH / EAST / WEST
+		inline int neighbor(int index, Direction direction) const
+		{
+			switch (direction)
+			{
+			case Direction::NORTH:
+				return neighbors[index][0];
+			case Direction::SOUTH:
+				return neighbors[index][1];
+			case Direction::EAST:
+				return neighbors[index][2];
+			case Direction::WEST:
+				return neighbors[index][3];
+			default:
+				return index;
+			}
+		}
+		inline const array<int, 4>& neighbors_of(int index) const { return neighbors[index]; }
+
+		// Distance oracle, coordinates must already be on the map
+		inline int distance(int x1, int y1, int x2, int y2) const { return delta_x[x1 - x2 + width - 1] + delta_y[y1 - y2 + height - 1]; }
+		inline int distance_x(int x1, int x2) const { return delta_x[x1 - x2 + width - 1]; }
+		inline int distance_y(int y1, int y2) const { return delta_y[y1 - y2 + height - 1]; }
+
+		// distances_x_from(x)[x'] is the distance along x between x and x'
+		inline const int* distances_x_from(int x) const { return &delta_x[width - 1 - x]; }
+		inline const int* distances_y_from(int y) const { return &delta_y[height - 1 - y]; }
+
+		// Distances from (x, y) to every cell of one row, out must hold width ints
+		inline void fill_distance_row(int x, int y, int row, int* out) const
+		{
+			const int dy = distance_y(row, y);
+			const int* dx = distances_x_from(x);
+
+			for (int i = 0; i < width; ++i)
+				out[i] = dy + dx[i];
+		}
+
+		// Distances from (x, y) to every cell of the map, row-major, out must hold width * height ints
+		void fill_distance_grid(int x, int y, int* out) const
+		{
+			for (int row = 0; row < height; ++row)
+				fill_distance_row(x, y, row, out + row * width);
+		}
+
+		// Every cell of the (2 * radius + 1) square centered on (x, y)
+		inline OffsetRange square(int x, int y, int radius) const { return OffsetRange(this, offsets(squares, radius), x, y); }
+		// Every cell at manhattan distance <= radius of (x, y)
+		inline OffsetRange diamond(int x, int y, int radius) const { return OffsetRange(this, offsets(diamonds, radius), x, y); }
+
+		// Cells that enter / leave the diamond when its center moves one step in direction to (x, y)
+		inline OffsetRange diamond_entering(int x, int y, int radius, Direction direction) const { return OffsetRange(this, offsets(diamonds_entering[step_index(direction)], radius), x, y); }
+		inline OffsetRange diamond_leaving(int x, int y, int radius, Direction direction) const { return OffsetRange(this, offsets(diamonds_leaving[step_index(direction)], radius), x, y); }
+
+	private:
+		int margin_x;
+		int margin_y;
+		vector<int> table_x;
+		vector<int> table_y;
+		vector<int> delta_x;
+		vector<int> delta_y;
+		vector<array<int, 4>> neighbors;
+		vector<vector<Offset>> squares;
+		vector<vector<Offset>> diamonds;
+		array<vector<vector<Offset>>, 4> diamonds_entering; // NORTH / SOUTH / EAST / WEST
+		array<vector<vector<Offset>>, 4> diamonds_leaving;
+
+		static int step_index(Direction direction)
+		{
+			switch (direction)
+			{
+			case Direction::NORTH:
+				return 0;
+			case Direction::SOUTH:
+				return 1;
+			case Direction::EAST:
+				return 2;
+			case Direction::WEST:
+				return 3;
+			default:
+				log::log("Error: WrapTable: a diamond move needs a cardinal direction");
+				exit(1);
+			}
+		}
+
+		const vector<Offset>& offsets(const vector<vector<Offset>>& lists, int radius) const
+		{
+			if ((radius < 0) || (radius > MAX_RADIUS))
+			{
+				log::log("Error: WrapTable: radius " + to_string(radius) + " out of range");
+				exit(1);
+			}
+			return lists[radius];
+		}
+	};
+}
@@ -40,7 +40,6 @@ cl.exe /FeMyBot.exe /std:c++14 /O2 /MT /EHsc /I . /Fo.\obj\ ^
  /D_USE_MATH_DEFINES ^
  .\hlt\command.cpp ^
  .\hlt\constants.cpp ^
- .\hlt\dropoff.cpp ^
  .\hlt\game.cpp ^
  .\hlt\game_map.cpp ^
  .\hlt\collision_resolver.cpp ^
@@ -49,6 +48,18 @@ cl.exe /FeMyBot.exe /std:c++14 /O2 /MT /EHsc /I . /Fo.\obj\ ^
  .\hlt\objective_manager.cpp ^
  .\hlt\scorer.cpp ^
  .\hlt\log.cpp ^
+ .\hlt\input.cpp ^
+ .\hlt\transcript.cpp ^
+ .\hlt\arena.cpp ^
+ .\hlt\diamond_convolution.cpp ^
+ .\hlt\task_graph.cpp ^
+ .\hlt\grid_kernels.cpp ^
+ .\hlt\map_statistics.cpp ^
+ .\hlt\combat_cache.cpp ^
+ .\hlt\grid_registry.cpp ^
+ .\hlt\halite_pyramid.cpp ^
+ .\hlt\distance_fields.cpp ^
+ .\hlt\benchmark.cpp ^
  .\hlt\player.cpp ^
  .\hlt\move_solver.cpp ^
  .\hlt\blocker.cpp ^